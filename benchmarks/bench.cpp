@@ -0,0 +1,271 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+/*
+ * Latency and allocation benchmarks against a mock ModemManager/NetworkManager service.
+ *
+ * The mock runs in a forked child process, so its allocations are not counted.
+ * Run it on a private session bus, e.g.: dbus-run-session -- ./ezcellular_bench --output results.json
+ */
+#include <algorithm>  // std::sort
+#include <atomic>     // std::atomic
+#include <chrono>     // std::chrono::steady_clock
+#include <condition_variable> // std::condition_variable
+#include <cstdint>    // uint64_t
+#include <cstdlib>    // std::malloc, std::free
+#include <fstream>    // std::ofstream
+#include <functional> // std::function
+#include <iostream>   // std::cout, std::cerr
+#include <memory>     // std::shared_ptr
+#include <mutex>      // std::mutex
+#include <new>        // std::bad_alloc
+#include <string>     // std::string, std::stoul
+#include <thread>     // std::this_thread
+#include <vector>     // std::vector
+
+#include <signal.h>   // ::kill
+#include <sys/wait.h> // ::waitpid
+#include <unistd.h>   // ::fork, ::pipe
+
+#include <sdbus-c++/sdbus-c++.h>
+
+#include "ezcellular/ezcellular.h"
+#include "ezcellular/dbus_constants.h"
+#include "mock_service.h"
+
+#ifndef EZCELLULAR_VERSION
+#define EZCELLULAR_VERSION "unknown"
+#endif
+
+/* ------- allocation counting, all threads ------- */
+
+static std::atomic<uint64_t> g_alloc_count{0};
+static std::atomic<uint64_t> g_alloc_bytes{0};
+
+auto operator new(std::size_t size) -> void* {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) { // NOLINT(*-no-malloc)
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr); // NOLINT(*-no-malloc)
+}
+
+void operator delete(void* ptr, [[maybe_unused]] std::size_t size) noexcept {
+    std::free(ptr); // NOLINT(*-no-malloc)
+}
+
+namespace {
+
+using namespace ezcellular;
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double mean_ns;
+    double p50_ns;
+    double p99_ns;
+    double min_ns;
+    double allocs_per_op;
+    double bytes_per_op;
+};
+
+// run op `iterations` times (after a short warm-up) and collect latency and allocation statistics
+auto measure(const std::string& name, uint64_t iterations, const std::function<void()>& op) -> Result {
+    for (uint64_t i = 0; i < iterations / 10 + 1; ++i) {
+        op();  // warm-up: resolve proxies, fill caches
+    }
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+
+    auto allocs_before = g_alloc_count.load();
+    auto bytes_before = g_alloc_bytes.load();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        op();
+        auto end = Clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    auto allocs = g_alloc_count.load() - allocs_before;
+    auto bytes = g_alloc_bytes.load() - bytes_before;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (auto sample : samples) {
+        sum += sample;
+    }
+
+    Result res{};
+    res.name = name;
+    res.iterations = iterations;
+    res.mean_ns = sum / static_cast<double>(iterations);
+    res.p50_ns = samples[iterations / 2];
+    res.p99_ns = samples[(iterations * 99) / 100];
+    res.min_ns = samples.front();
+    res.allocs_per_op = static_cast<double>(allocs) / static_cast<double>(iterations);
+    res.bytes_per_op = static_cast<double>(bytes) / static_cast<double>(iterations);
+    return res;
+}
+
+// time from triggering `count` StateChanged signals until all `observers` got all of them
+auto measure_fan_out(ModemManager& mm, Modem& modem, uint32_t observers, uint32_t count) -> Result {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t received = 0;
+
+    std::vector<Subscription> subscriptions;
+    subscriptions.reserve(observers);
+    for (uint32_t i = 0; i < observers; ++i) {
+        subscriptions.push_back(modem.observe_modem_state([&](Modem::ModemState, Modem::ModemState) {
+            std::lock_guard lock{mutex};
+            ++received;
+            cv.notify_one();
+        }));
+    }
+
+    auto control = sdbus::createProxy(*mm.connection(), DBus::MM_BUS_NAME, DBus::MM_OBJ_MODEMMANAGER);
+    auto expected = static_cast<uint64_t>(observers) * count;
+
+    auto res = measure("observer_fan_out_" + std::to_string(observers), 5, [&]() {
+        {
+            std::lock_guard lock{mutex};
+            received = 0;
+        }
+        control->callMethod("EmitStateChanged").onInterface(bench::MOCK_IF_CONTROL).withArguments(count);
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return received >= expected; });
+    });
+
+    // report per signal instead of per batch
+    auto per_signal = static_cast<double>(count);
+    res.iterations *= count;
+    res.mean_ns /= per_signal;
+    res.p50_ns /= per_signal;
+    res.p99_ns /= per_signal;
+    res.min_ns /= per_signal;
+    res.allocs_per_op /= per_signal;
+    res.bytes_per_op /= per_signal;
+    return res;
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results) {
+    os << "{\n  \"library\": \"ezcellular\",\n  \"version\": \"" << EZCELLULAR_VERSION << "\",\n"
+       << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& res = results[i];
+        os << (i == 0 ? "\n" : ",\n")
+           << "    {\"name\": \"" << res.name << "\", \"iterations\": " << res.iterations
+           << ", \"mean_ns\": " << res.mean_ns << ", \"p50_ns\": " << res.p50_ns
+           << ", \"p99_ns\": " << res.p99_ns << ", \"min_ns\": " << res.min_ns
+           << ", \"allocs_per_op\": " << res.allocs_per_op << ", \"bytes_per_op\": " << res.bytes_per_op << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+// child process: serve until killed
+[[noreturn]] void run_mock_service(int ready_fd) {
+    auto conn = sdbus::createSessionBusConnection();
+    bench::MockService service{*conn};
+    (void) ::write(ready_fd, "1", 1);
+    ::close(ready_fd);
+    conn->enterEventLoop();
+    std::exit(0);
+}
+
+void usage(char* argv[]) {
+    std::cerr << "Usage: " << argv[0] << " [--iterations N] [--output FILE]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 1000;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::stoul(argv[++i]);
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            usage(argv);
+            return 1;
+        }
+    }
+
+    // 1. start the mock service, before any thread is created
+    int ready[2];
+    if (::pipe(ready) != 0) {
+        std::cerr << "pipe() failed" << std::endl;
+        return 1;
+    }
+    pid_t mock_pid = ::fork();
+    if (mock_pid == 0) {
+        ::close(ready[0]);
+        run_mock_service(ready[1]);
+    }
+    ::close(ready[1]);
+    char ready_byte{};
+    if (mock_pid < 0 || ::read(ready[0], &ready_byte, 1) != 1) {
+        std::cerr << "Failed to start the mock service" << std::endl;
+        return 1;
+    }
+    ::close(ready[0]);
+
+    std::vector<Result> results;
+    {
+        // 2. connect like an application would, but to the session bus
+        ModemManager mm{sdbus::createSessionBusConnection(), EventLoopMode::INTERNAL_THREAD};
+        auto modem = mm.any_modem();
+        if (!modem) {
+            std::cerr << "Mock modem not found" << std::endl;
+            ::kill(mock_pid, SIGTERM);
+            return 1;
+        }
+        auto conn = modem->active_connection();
+        if (!conn) {
+            std::cerr << "Mock bearer not found" << std::endl;
+            ::kill(mock_pid, SIGTERM);
+            return 1;
+        }
+
+        // 3. measure
+        results.push_back(measure("signal", iterations, [&]() { (void) modem->signal(); }));
+        results.push_back(measure("cell_info", iterations, [&]() { (void) modem->cell_info(); }));
+        results.push_back(measure("location", iterations, [&]() { (void) modem->location(); }));
+        results.push_back(measure("traffic_stats", iterations, [&]() { (void) conn->traffic_stats(); }));
+        results.push_back(measure("available_modems", iterations, [&]() { (void) mm.available_modems(); }));
+        // time-to-first-snapshot: construct a ModemManager on a separate connection, listed by a single
+        // GetManagedObjects call; with its own loop thread, which dispatches the replies of the snapshot
+        std::shared_ptr<sdbus::IConnection> startup_conn = sdbus::createSessionBusConnection();
+        results.push_back(measure("startup_to_first_snapshot", iterations / 20 + 1, [&]() {
+            ModemManager startup_mm{startup_conn, EventLoopMode::INTERNAL_THREAD};
+            (void) startup_mm.any_modem()->snapshot();
+        }));
+        for (uint32_t observers : {1U, 8U, 32U}) {
+            results.push_back(measure_fan_out(mm, *modem, observers, 100));
+        }
+    }
+
+    ::kill(mock_pid, SIGTERM);
+    ::waitpid(mock_pid, nullptr, 0);
+
+    // 4. report
+    if (output.empty()) {
+        write_json(std::cout, results);
+    } else {
+        std::ofstream file{output};
+        write_json(file, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "mock_service.h"
+
+#include <array>   // std::array
+#include <cstdio>  // std::snprintf
+
+#include <ModemManager/ModemManager.h>
+
+#include "dbus_constants.h"
+
+namespace ezcellular::bench {
+
+using sdbus_variant_map = std::map<std::string, sdbus::Variant>;
+
+// a cell info dict as returned by GetCellInfo(), see ModemManager docs
+static auto make_lte_cell(bool serving, uint32_t index) -> sdbus_variant_map {
+    std::array<char, 16> hex{};
+    sdbus_variant_map cell{
+        {"cell-type", static_cast<uint32_t>(MM_CELL_TYPE_LTE)},
+        {"serving", serving},
+        {"earfcn", static_cast<uint32_t>(1300 + index)},
+        {"rsrp", -90.0 - index},
+        {"rsrq", -10.5},
+        {"rssi", -60.0},
+        {"snr", 12.25},
+    };
+    std::snprintf(hex.data(), hex.size(), "%X", 100 + index);
+    cell.insert({"physical-ci", std::string{hex.data()}});
+    if (serving) {
+        std::snprintf(hex.data(), hex.size(), "%X", 0x1A2B3C0 + index);
+        cell.insert({"ci", std::string{hex.data()}});
+        cell.insert({"tac", std::string{"5A"}});
+        cell.insert({"operator-id", std::string{"26201"}});
+    }
+    return cell;
+}
+
+MockService::MockService(sdbus::IConnection& conn, uint32_t neighbor_cells)
+    : conn_{conn}, state_{MM_MODEM_STATE_CONNECTED} {
+
+    cells_.push_back(make_lte_cell(true, 0));
+    for (uint32_t i = 1; i <= neighbor_cells; ++i) {
+        cells_.push_back(make_lte_cell(false, i));
+    }
+
+    register_modem_manager();
+    register_modem();
+    register_bearer();
+    register_network_manager();
+
+    // names last, so clients only find us once everything is in place
+    conn_.requestName(DBus::MM_BUS_NAME);
+    conn_.requestName(DBus::NM_BUS_NAME);
+}
+
+void MockService::register_modem_manager() {
+    mm_ = sdbus::createObject(conn_, DBus::MM_OBJ_MODEMMANAGER);
+    mm_->registerProperty("Version").onInterface(DBus::MM_IF_MODEMMANAGER)
+        .withGetter([]() { return std::string{"1.20.0-mock"}; });
+    mm_->registerMethod("EmitStateChanged").onInterface(MOCK_IF_CONTROL)
+        .implementedAs([this](uint32_t count) { emit_state_changed(count); });
+    mm_->addObjectManager();  // GetManagedObjects() lists the modem below
+    mm_->finishRegistration();
+}
+
+void MockService::register_modem() {
+    modem_ = sdbus::createObject(conn_, MOCK_OBJ_MODEM);
+
+    // .Modem
+    modem_->registerProperty("State").onInterface(DBus::MM_IF_MODEM).withGetter([this]() { return state_; });
+    modem_->registerProperty("PowerState").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return static_cast<uint32_t>(MM_MODEM_POWER_STATE_ON); });
+    modem_->registerProperty("UnlockRequired").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return static_cast<uint32_t>(MM_MODEM_LOCK_NONE); });
+    modem_->registerProperty("AccessTechnologies").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return static_cast<uint32_t>(MM_MODEM_ACCESS_TECHNOLOGY_LTE); });
+    modem_->registerProperty("Manufacturer").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return std::string{"ezcellular"}; });
+    modem_->registerProperty("Model").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return std::string{"Mock Modem"}; });
+    modem_->registerProperty("Revision").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return std::string{"1.0"}; });
+    modem_->registerProperty("OwnNumbers").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return std::vector<std::string>{"+4915100000000"}; });
+    modem_->registerProperty("Sim").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return sdbus::ObjectPath{"/"}; });
+    modem_->registerProperty("Bearers").onInterface(DBus::MM_IF_MODEM)
+        .withGetter([]() { return std::vector<sdbus::ObjectPath>{MOCK_OBJ_BEARER}; });
+    modem_->registerMethod("GetCellInfo").onInterface(DBus::MM_IF_MODEM).implementedAs([this]() { return cells_; });
+    modem_->registerSignal("StateChanged").onInterface(DBus::MM_IF_MODEM).withParameters<int32_t, int32_t, uint32_t>();
+
+    // .Modem.Modem3gpp
+    modem_->registerProperty("Imei").onInterface(DBus::MM_IF_MODEM_MODEM3GPP)
+        .withGetter([]() { return std::string{"000000000000000"}; });
+    modem_->registerProperty("OperatorCode").onInterface(DBus::MM_IF_MODEM_MODEM3GPP)
+        .withGetter([]() { return std::string{"26201"}; });
+    modem_->registerProperty("OperatorName").onInterface(DBus::MM_IF_MODEM_MODEM3GPP)
+        .withGetter([]() { return std::string{"Mock Telecom"}; });
+
+    // .Modem.Signal, refresh already set up
+    modem_->registerProperty("Rate").onInterface(DBus::MM_IF_MODEM_SIGNAL).withGetter([]() { return 5U; });
+    modem_->registerProperty("Lte").onInterface(DBus::MM_IF_MODEM_SIGNAL).withGetter([]() {
+        return sdbus_variant_map{{"rsrp", -95.0}, {"rsrq", -11.0}, {"rssi", -65.0}, {"snr", 10.5}};
+    });
+    modem_->registerProperty("Nr5g").onInterface(DBus::MM_IF_MODEM_SIGNAL)
+        .withGetter([]() { return sdbus_variant_map{}; });
+    modem_->registerMethod("Setup").onInterface(DBus::MM_IF_MODEM_SIGNAL).implementedAs([](uint32_t /*rate*/) {});
+
+    // .Modem.Location
+    modem_->registerMethod("GetLocation").onInterface(DBus::MM_IF_MODEM_LOCATION).implementedAs([]() {
+        return std::map<uint32_t, sdbus::Variant>{
+            {MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI, std::string{"262,01,FFFE,1A2B3C0,5A"}}};
+    });
+    modem_->registerMethod("Setup").onInterface(DBus::MM_IF_MODEM_LOCATION)
+        .implementedAs([](uint32_t /*sources*/, bool /*signal_location*/) {});
+
+    // .Modem.Time
+    modem_->registerMethod("GetNetworkTime").onInterface(DBus::MM_IF_MODEM_TIME)
+        .implementedAs([]() { return std::string{"2023-06-01T12:00:00+02:00"}; });
+
+    modem_->finishRegistration();
+}
+
+void MockService::register_bearer() {
+    bearer_ = sdbus::createObject(conn_, MOCK_OBJ_BEARER);
+    bearer_->registerProperty("Connected").onInterface(DBus::MM_IF_BEARER).withGetter([]() { return true; });
+    bearer_->registerProperty("Interface").onInterface(DBus::MM_IF_BEARER)
+        .withGetter([]() { return std::string{MOCK_LINUX_INTERFACE}; });
+    bearer_->registerProperty("Properties").onInterface(DBus::MM_IF_BEARER).withGetter([]() {
+        return sdbus_variant_map{{"apn", std::string{"internet"}},
+                                 {"ip-type", static_cast<uint32_t>(MM_BEARER_IP_FAMILY_IPV4)}};
+    });
+    bearer_->registerProperty("Ip4Config").onInterface(DBus::MM_IF_BEARER).withGetter([]() {
+        return sdbus_variant_map{{"address", std::string{"10.0.0.2"}}, {"prefix", 30U},
+                                 {"gateway", std::string{"10.0.0.1"}},
+                                 {"dns1", std::string{"10.0.0.1"}}, {"dns2", std::string{"10.0.0.3"}}};
+    });
+    bearer_->registerProperty("Ip6Config").onInterface(DBus::MM_IF_BEARER)
+        .withGetter([]() { return sdbus_variant_map{}; });
+    bearer_->finishRegistration();
+}
+
+void MockService::register_network_manager() {
+    nm_ = sdbus::createObject(conn_, DBus::NM_OBJ_NETWORKMANAGER);
+    nm_->registerMethod("GetDeviceByIpIface").onInterface(DBus::NM_IF_NETWORKMANAGER)
+        .implementedAs([](const std::string& /*iface*/) { return sdbus::ObjectPath{MOCK_OBJ_NM_DEVICE}; });
+    nm_->finishRegistration();
+
+    // counters grow with every read, like on a busy link
+    nm_device_ = sdbus::createObject(conn_, MOCK_OBJ_NM_DEVICE);
+    nm_device_->registerProperty("RefreshRateMs").onInterface(DBus::NM_IF_DEVICE_STATISTICS)
+        .withGetter([this]() { return refresh_rate_ms_.load(); })
+        .withSetter([this](const uint32_t& rate) { refresh_rate_ms_ = rate; });
+    nm_device_->registerProperty("RxBytes").onInterface(DBus::NM_IF_DEVICE_STATISTICS)
+        .withGetter([this]() { return rx_bytes_ += 1500; });
+    nm_device_->registerProperty("TxBytes").onInterface(DBus::NM_IF_DEVICE_STATISTICS)
+        .withGetter([this]() { return tx_bytes_ += 500; });
+    nm_device_->finishRegistration();
+}
+
+// toggle between CONNECTED and REGISTERED, count times
+void MockService::emit_state_changed(uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t old_state = state_;
+        state_ = (state_ == MM_MODEM_STATE_CONNECTED) ? MM_MODEM_STATE_REGISTERED : MM_MODEM_STATE_CONNECTED;
+        modem_->emitSignal("StateChanged").onInterface(DBus::MM_IF_MODEM)
+            .withArguments(old_state, state_, static_cast<uint32_t>(0));
+    }
+}
+
+} // namespace ezcellular::bench
@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <atomic>  // std::atomic
+#include <cstdint> // uint32_t, uint64_t
+#include <map>     // std::map
+#include <memory>  // std::unique_ptr
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::*
+
+namespace ezcellular::bench {
+
+/* control interface of the mock, not part of ModemManager */
+constexpr auto MOCK_IF_CONTROL = "org.ezcellular.Mock";
+
+/* objects of the mock */
+constexpr auto MOCK_OBJ_MODEM = "/org/freedesktop/ModemManager1/Modem/0";
+constexpr auto MOCK_OBJ_BEARER = "/org/freedesktop/ModemManager1/Bearer/0";
+constexpr auto MOCK_OBJ_NM_DEVICE = "/org/freedesktop/NetworkManager/Devices/1";
+constexpr auto MOCK_LINUX_INTERFACE = "wwan0";
+
+/**
+ * @brief Minimal ModemManager and NetworkManager D-Bus service with one registered LTE modem and an active bearer.
+ *
+ * Implements the parts of both APIs that are used by the library with constant (or counting) values,
+ * so that the benchmarks measure the library and the bus, not the modem.
+ * Additionally, the `org.ezcellular.Mock` interface on the ModemManager object allows to trigger signals.
+ */
+class MockService {
+public:
+    /**
+     * @brief Register all objects and acquire the bus names of ModemManager and NetworkManager.
+     * @param conn the connection to serve on, usually a private session bus
+     * @param neighbor_cells number of neighbor cells reported by GetCellInfo() in addition to the serving cell
+     */
+    explicit MockService(sdbus::IConnection& conn, uint32_t neighbor_cells = 15);
+
+private:
+    sdbus::IConnection& conn_;
+    std::unique_ptr<sdbus::IObject> mm_;
+    std::unique_ptr<sdbus::IObject> modem_;
+    std::unique_ptr<sdbus::IObject> bearer_;
+    std::unique_ptr<sdbus::IObject> nm_;
+    std::unique_ptr<sdbus::IObject> nm_device_;
+
+    std::vector<std::map<std::string, sdbus::Variant>> cells_;
+    std::atomic<uint64_t> rx_bytes_{0};
+    std::atomic<uint64_t> tx_bytes_{0};
+    std::atomic<uint32_t> refresh_rate_ms_{0};
+    int32_t state_;
+
+    void register_modem_manager();
+    void register_modem();
+    void register_bearer();
+    void register_network_manager();
+    void emit_state_changed(uint32_t count);
+};
+
+} // namespace ezcellular::bench
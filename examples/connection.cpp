@@ -52,21 +52,22 @@ int main(int argc, char* argv[]) {
         << "\n\tlocked: " << std::boolalpha << modem->locked() << " (" << modem->lock_state() << ")"
         << std::endl;
 
-    modem->observe_modem_state([](Modem::ModemState old_, Modem::ModemState new_) {
+    auto state_subscription = modem->observe_modem_state([](Modem::ModemState old_, Modem::ModemState new_) {
         std::cout << "Modem state changed: " << old_ << "->" << new_ << std::endl;
     });
 
+    std::optional<Connection> conn;
     if (!modem->connected()) {
         if (apn.empty()) {
             std::cerr << "Error: not connected. Pass an APN as argument to connect." << std::endl;
             return 1;
         }
         std::cout << "Connecting to APN '" << apn << "' with IP type '" << ip_type << "'...\n";
-        modem->connect(apn, ip_type);
+        conn = modem->connect(apn, ip_type);
+    } else {
+        conn = modem->active_connection();
     }
 
-    auto conn = modem->active_connection();
-
     if (!conn) {
         std::cerr << "Error: not connected.\n";
         return 1;
@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include <csignal>
+#include <iostream>
+#include <memory>
+
+#include <poll.h> // ::poll
+
+#include <sdbus-c++/sdbus-c++.h>
+
+#include "ezcellular/ezcellular.h"
+
+bool should_run = true;
+
+void handle_sigint(int) {
+    should_run = false;
+}
+
+int main(int argc, char* argv[]) {
+    using namespace ezcellular;
+
+    ::signal(SIGINT, handle_sigint);  // clean shutdown
+
+    // no background thread, the messages are processed in the loop below
+    std::shared_ptr<sdbus::IConnection> conn = sdbus::createSystemBusConnection();
+    auto mm = ModemManager(conn, EventLoopMode::EXTERNAL);
+    auto modem = mm.any_modem();
+
+    if(!modem) {
+        std::cerr << "No modem present." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Modem: " << modem->manufacturer() << " " << modem->model() << std::endl;
+
+    // runs on this thread, inside process_pending()
+    auto state_subscription = modem->observe_modem_state([](Modem::ModemState old_state, Modem::ModemState new_state) {
+        std::cout << "Modem state update: " << old_state << " -> " << new_state << std::endl;
+    });
+
+    // event loop, usually part of an existing epoll/io_uring/... reactor
+    while (should_run) {
+        auto poll_data = mm.event_loop_poll_data();
+
+        // timeout_usec is an absolute deadline, poll() wants a relative timeout (-1: infinite)
+        pollfd fds{poll_data.fd, poll_data.events, 0};
+        ::poll(&fds, 1, ModemManager::poll_timeout_ms(poll_data));
+
+        while (mm.process_pending()) {
+            // process all pending messages
+        }
+    }
+
+    return 0;
+}
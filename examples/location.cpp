@@ -51,7 +51,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Current cell location: " << location << "\n";
 
     // observe cell location
-    modem->observe_location([](Location loc) {
+    auto location_subscription = modem->observe_location([](Location loc) {
         std::cout << "Cell location update: " << loc << std::endl;
     });
 
@@ -49,8 +49,8 @@ int main(int argc, char* argv[]) {
         << "\n\tPower State: " << modem->power_state()
         << std::endl;
 
-    // observe general state
-    modem->observe_modem_state(modem_state_observer);
+    // observe general state, as long as the subscription is alive
+    auto state_subscription = modem->observe_modem_state(modem_state_observer);
 
     if (argc != 2) {
         usage(argv);
@@ -67,7 +67,7 @@ int main(int argc, char* argv[]) {
     } else if (action == "restart") {
         std::cout << "Restarting modem\n";
         auto restarted_modem =  mm.reset_modem(*modem);
-        restarted_modem.observe_modem_state(modem_state_observer);
+        state_subscription = restarted_modem.observe_modem_state(modem_state_observer);
     } else if (action == "poweroff") {
         std::cout << "Turning off modem\n";
         modem->power_off();
@@ -37,7 +37,7 @@ int main(int argc, char* argv[]) {
         << "\n\tlocked: " << std::boolalpha << modem->locked() << " (" << modem->lock_state() << ")"
         << std::endl;
 
-    modem->observe_modem_state([](Modem::ModemState old_, Modem::ModemState new_) {
+    auto state_subscription = modem->observe_modem_state([](Modem::ModemState old_, Modem::ModemState new_) {
         std::cout << "Modem state changed: " << old_ << "->" << new_ << std::endl;
     });
 
@@ -68,7 +68,7 @@ int main(int argc, char* argv[]) {
     }
     std::cout << std::endl;
 
-    conn->observe_traffic_stats([](TrafficStats stats) {
+    auto traffic_subscription = conn->observe_traffic_stats([](TrafficStats stats) {
         std::cout << "Traffic stats: " << stats << "\n";
     }, 2000 /* interval ms */);
 
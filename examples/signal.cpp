@@ -51,7 +51,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Current signal quality: " << signal << "\n";
 
     // observe signal
-    modem->observe_signal([](Signal sq) {
+    auto signal_subscription = modem->observe_signal([](Signal sq) {
         std::cout << "Signal quality update: " << sq << std::endl;
     }, 2);
 
@@ -34,5 +34,14 @@ int main(int argc, char* argv[]) {
     std::cout << "Network time: " << modem->network_time()
         << " (unix timestamp: " << modem->network_time_epoch() << ")" << std::endl;
 
+    // or sync a clock once, which then needs no D-Bus call per timestamp
+    NetworkClock clock{*modem};
+    clock.sync();
+    std::cout << "Network clock: " << clock.now_epoch().value_or(0);
+    if (auto offset = clock.utc_offset()) {
+        std::cout << " (UTC offset: " << offset->count() << " min)";
+    }
+    std::cout << std::endl;
+
     return 0;
 }
@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <atomic>      // std::atomic
+#include <chrono>      // std::chrono::steady_clock
+#include <cstdint>     // int64_t
+#include <exception>   // std::uncaught_exceptions
+#include <string_view> // std::string_view
+
+namespace ezcellular {
+
+class CallSite; // IWYU pragma: keep
+
+/**
+ * @brief The call site of one D-Bus method at one place in the code, looked up once instead of on every call.
+ *
+ * Declared `static` next to the call, e.g. `static CallSiteRef site{DBus::MM_IF_MODEM, "Enable"};`.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class CallSiteRef {
+public:
+    /** @note interface and member must outlive the reference, e.g. string literals */
+    constexpr CallSiteRef(std::string_view interface, std::string_view member) noexcept
+        : interface_{interface}, member_{member} {}
+
+    /** @brief the site, registered on first use */
+    [[nodiscard]] auto get() -> CallSite*;
+
+private:
+    std::string_view interface_;
+    std::string_view member_;
+    std::atomic<CallSite*> site_{nullptr};
+};
+
+/**
+ * @brief Measures one D-Bus call for Metrics, does nothing if they are disabled.
+ *
+ * Copyable, so that it can be passed on to the reply handler of an asynchronous call.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class CallTimer {
+public:
+    /** @brief inactive timer */
+    CallTimer() = default;
+
+    /** @brief start measuring, right before the call is sent */
+    static auto start(CallSiteRef& site) -> CallTimer;
+    /** @brief start measuring a call whose interface is only known at run time, see above */
+    static auto start(std::string_view interface, std::string_view member) -> CallTimer;
+
+    /** @brief record the call, once the reply (or error) arrived */
+    void finish(bool error) const;
+
+private:
+    CallSite* site_ = nullptr;  // nullptr if disabled
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Measures a blocking D-Bus call in the current scope, it failed if the scope is left by an exception.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class ScopedCall {
+public:
+    explicit ScopedCall(CallSiteRef& site) : timer_{CallTimer::start(site)}, exceptions_{std::uncaught_exceptions()} {}
+    ScopedCall(std::string_view interface, std::string_view member)
+        : timer_{CallTimer::start(interface, member)}, exceptions_{std::uncaught_exceptions()} {}
+    ~ScopedCall() { timer_.finish(std::uncaught_exceptions() > exceptions_); }
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    ScopedCall(const ScopedCall&) = delete;
+    ScopedCall& operator=(const ScopedCall&) = delete;
+    ScopedCall(ScopedCall&&) = delete;
+    ScopedCall& operator=(ScopedCall&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+private:
+    CallTimer timer_;
+    int exceptions_;
+};
+
+/**
+ * @brief Observer dispatching part of Metrics, see ObserverQueue.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class DispatchMetrics {
+public:
+    /** @brief start of an observer callback, empty if disabled */
+    [[nodiscard]] static auto start() -> std::chrono::steady_clock::time_point;
+    /** @brief an observer callback returned, see start() */
+    static void finish(std::chrono::steady_clock::time_point start);
+    /**
+     * @brief an update was queued
+     * @return whether it was counted (metrics enabled), it must then be reported to taken() once it leaves the queue
+     */
+    [[nodiscard]] static auto queued() -> bool;
+    /** @brief counted updates were taken from a queue, or dropped */
+    static void taken(int64_t count);
+    /** @brief updates were dropped from a queue, see OverflowPolicy; report them to taken() too if counted */
+    static void dropped(int64_t count);
+};
+
+} // namespace ezcellular
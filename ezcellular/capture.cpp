@@ -0,0 +1,218 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "capture.h"
+
+#include <cerrno>       // errno
+#include <new>          // placement new
+#include <stdexcept>    // std::runtime_error
+#include <system_error> // std::system_error
+
+#include <fcntl.h>    // open, O_* constants
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // ftruncate, close
+
+#include "any_map.h"  // sdbus_variant_map
+
+namespace ezcellular {
+
+// --- payload ---
+
+namespace {
+
+template<typename T>
+struct Tag {
+    using type = T;
+};
+
+// call visit(Tag<T>{}) with the C++ type of a supported signature, false if it is not supported
+template<typename Visit>
+auto visit_signature(std::string_view signature, const Visit& visit) -> bool {
+    // basic types
+    if (signature == "b") { return visit(Tag<bool>{}); }
+    if (signature == "y") { return visit(Tag<uint8_t>{}); }
+    if (signature == "n") { return visit(Tag<int16_t>{}); }
+    if (signature == "q") { return visit(Tag<uint16_t>{}); }
+    if (signature == "i") { return visit(Tag<int32_t>{}); }
+    if (signature == "u") { return visit(Tag<uint32_t>{}); }
+    if (signature == "x") { return visit(Tag<int64_t>{}); }
+    if (signature == "t") { return visit(Tag<uint64_t>{}); }
+    if (signature == "d") { return visit(Tag<double>{}); }
+    if (signature == "s") { return visit(Tag<std::string>{}); }
+    if (signature == "o") { return visit(Tag<sdbus::ObjectPath>{}); }
+    // the containers used by ModemManager and NetworkManager
+    if (signature == "ay") { return visit(Tag<std::vector<uint8_t>>{}); }
+    if (signature == "as") { return visit(Tag<std::vector<std::string>>{}); }
+    if (signature == "ao") { return visit(Tag<std::vector<sdbus::ObjectPath>>{}); }
+    if (signature == "au") { return visit(Tag<std::vector<uint32_t>>{}); }
+    if (signature == "a{sv}") { return visit(Tag<sdbus_variant_map>{}); }
+    if (signature == "a{uv}") { return visit(Tag<std::map<uint32_t, sdbus::Variant>>{}); }
+    if (signature == "a{uu}") { return visit(Tag<std::map<uint32_t, uint32_t>>{}); }
+    if (signature == "aa{sv}") { return visit(Tag<std::vector<sdbus_variant_map>>{}); }
+    return false;
+}
+
+} // namespace
+
+auto variant_supported(const sdbus::Variant& variant) -> bool {
+    return !variant.isEmpty() && visit_signature(variant.peekValueType(), [](auto) { return true; });
+}
+
+void encode_variant(BinaryWriter& out, const sdbus::Variant& variant) {
+    std::string_view signature = variant.peekValueType();
+    out.bytes(signature);
+    static_cast<void>(visit_signature(signature, [&](auto tag) {
+        encode_value(out, variant.get<typename decltype(tag)::type>());
+        return true;
+    }));
+}
+
+auto decode_variant(BinaryReader& in, sdbus::Variant& variant) -> bool {
+    std::string_view signature;
+    if (!in.bytes(signature)) {
+        return false;
+    }
+    return visit_signature(signature, [&](auto tag) {
+        typename decltype(tag)::type value{};
+        if (!decode_value(in, value)) {
+            return false;
+        }
+        variant = sdbus::Variant{value};
+        return true;
+    });
+}
+
+// --- file ---
+
+namespace {
+
+// "ezcap" plus the version of the format, increment on incompatible changes
+constexpr uint64_t MAGIC = 0x657a636170000001;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "atomics in a mapped file must be address-free");
+
+} // namespace
+
+struct CaptureHeader {
+    uint64_t magic = MAGIC;
+    int64_t start_unix_ns = 0;        // system_clock at the start, to relate the capture to other logs
+    std::atomic<uint64_t> size{0};    // bytes of complete records after the header
+};
+
+CaptureWriter::CaptureWriter(const std::string& file, std::size_t capacity)
+    : capacity_{capacity}, last_{std::chrono::steady_clock::now()} {
+    fd_ = ::open(file.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::system_error{errno, std::generic_category(), "open " + file};
+    }
+    auto size = sizeof(CaptureHeader) + capacity;
+    if (::ftruncate(fd_, static_cast<off_t>(size)) < 0) {
+        auto error = errno;
+        ::close(fd_);
+        throw std::system_error{error, std::generic_category(), "ftruncate " + file};
+    }
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory == MAP_FAILED) {
+        auto error = errno;
+        ::close(fd_);
+        throw std::system_error{error, std::generic_category(), "mmap " + file};
+    }
+
+    header_ = new (memory) CaptureHeader{};
+    header_->start_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    records_ = static_cast<uint8_t*>(memory) + sizeof(CaptureHeader);
+}
+
+CaptureWriter::~CaptureWriter() {
+    ::munmap(header_, sizeof(CaptureHeader) + capacity_);
+    // drop the unused capacity, the file only holds complete records
+    static_cast<void>(::ftruncate(fd_, static_cast<off_t>(sizeof(CaptureHeader) + size_)));
+    ::close(fd_);
+}
+
+void CaptureWriter::commit(std::size_t bytes) {
+    size_ += bytes;
+    ++records_count_;
+    header_->size.store(size_, std::memory_order_release);  // publishes the record
+}
+
+CaptureReader::CaptureReader(const std::string& file) {
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "open " + file};
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) < 0) {
+        auto error = errno;
+        ::close(fd);
+        throw std::system_error{error, std::generic_category(), "fstat " + file};
+    }
+    auto size = static_cast<std::size_t>(info.st_size);
+    void* memory = size < sizeof(CaptureHeader) ? MAP_FAILED : ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping stays valid
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error{"not a capture file: " + file};
+    }
+
+    const auto* header = static_cast<const CaptureHeader*>(memory);
+    if (header->magic != MAGIC) {
+        ::munmap(memory, size);
+        throw std::runtime_error{"not a capture file (or another version): " + file};
+    }
+    memory_ = static_cast<const uint8_t*>(memory);
+    mapped_ = size;
+    rewind();
+}
+
+CaptureReader::~CaptureReader() {
+    ::munmap(const_cast<uint8_t*>(memory_), mapped_);  // NOLINT(*-const-cast)
+}
+
+void CaptureReader::rewind() {
+    // only complete records, also if the file is still being written
+    const auto* header = reinterpret_cast<const CaptureHeader*>(memory_);  // NOLINT(*-reinterpret-cast)
+    auto available = mapped_ - sizeof(CaptureHeader);
+    auto size = header->size.load(std::memory_order_acquire);
+    records_ = BinaryReader{memory_ + sizeof(CaptureHeader), size < available ? size : available};
+    time_ = {};
+}
+
+auto CaptureReader::next(CaptureRecord& record, bool& malformed) -> bool {
+    malformed = false;
+    if (records_.at_end()) {
+        return false;
+    }
+
+    BinaryReader part{nullptr, 0};
+    uint64_t kind{};
+    uint64_t delta_ns{};
+    if (!records_.message(part) || !part.varint(kind) || !part.varint(delta_ns) || !part.bytes(record.path)
+        || !part.bytes(record.interface) || !part.bytes(record.member)) {
+        malformed = true;
+        return false;
+    }
+    time_ += std::chrono::nanoseconds{delta_ns};
+    record.kind = static_cast<CaptureKind>(kind);
+    record.time = time_;
+    record.payload = part;  // positioned at the first argument
+    return true;
+}
+
+// --- CaptureTap ---
+
+void CaptureTap::start(std::shared_ptr<CaptureWriter> writer) {
+    std::lock_guard lock{mutex_};
+    writer_ = std::move(writer);
+    active_.store(writer_ != nullptr, std::memory_order_relaxed);
+}
+
+auto CaptureTap::stop() -> std::shared_ptr<CaptureWriter> {
+    std::lock_guard lock{mutex_};
+    active_.store(false, std::memory_order_relaxed);
+    return std::move(writer_);
+}
+
+} // namespace ezcellular
@@ -0,0 +1,342 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <atomic>      // std::atomic
+#include <chrono>      // std::chrono::steady_clock
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint8_t, uint64_t
+#include <cstring>     // std::memcpy
+#include <map>         // std::map
+#include <memory>      // std::shared_ptr
+#include <mutex>       // std::mutex
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::is_same_v and friends
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::ObjectPath, sdbus::Variant
+
+#include "encoding.h"  // BinaryWriter, BinaryReader
+
+/*
+ * capture and replay of the received D-Bus messages, internal, not part of the public API
+ *
+ * A capture file is a header followed by records, appended in the order they were received.
+ * Each record is a varint length plus:
+ *   varint kind, varint ns since the previous record, bytes path, bytes interface, bytes member, payload
+ * The payload holds the arguments of the message one after another, see encode_value().
+ */
+
+namespace ezcellular {
+
+/** @brief what a record holds */
+enum class CaptureKind : uint8_t {
+    SIGNAL = 1, ///< a signal, member is the signal name
+    REPLY = 2,  ///< a method reply, member is the method name
+};
+
+// --- payload ---
+
+/// @private
+template<typename T>
+struct is_vector : std::false_type {};
+/// @private
+template<typename T>
+struct is_vector<std::vector<T>> : std::true_type {};
+/// @private
+template<typename T>
+struct is_map : std::false_type {};
+/// @private
+template<typename K, typename V>
+struct is_map<std::map<K, V>> : std::true_type {};
+
+/** @brief whether the value of variant can be captured, see encode_variant() */
+auto variant_supported(const sdbus::Variant& variant) -> bool;
+/** @brief Write the signature of variant plus its value, only for variant_supported() ones. */
+void encode_variant(BinaryWriter& out, const sdbus::Variant& variant);
+/** @brief Read what encode_variant() wrote. */
+[[nodiscard]] auto decode_variant(BinaryReader& in, sdbus::Variant& variant) -> bool;
+
+/**
+ * @brief Write a value of a D-Bus type: integers as (zigzag) varints, doubles as their bits, strings as bytes,
+ *        arrays and dicts as a varint count followed by their elements.
+ * @note entries of a dict with a variant that is not variant_supported() are left out
+ */
+template<typename T>
+void encode_value(BinaryWriter& out, const T& value) {
+    if constexpr (std::is_same_v<T, sdbus::Variant>) {
+        encode_variant(out, value);  // first, as a variant converts to anything
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out.varint(value ? 1 : 0);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        out.signed_varint(value);
+    } else if constexpr (std::is_integral_v<T>) {
+        out.varint(value);
+    } else if constexpr (std::is_same_v<T, double>) {
+        uint64_t bits{};
+        std::memcpy(&bits, &value, sizeof(bits));
+        out.varint(bits);
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        out.bytes(value);  // also sdbus::ObjectPath
+    } else if constexpr (is_vector<T>::value) {
+        out.varint(value.size());
+        for (const auto& element : value) {
+            encode_value(out, element);
+        }
+    } else if constexpr (is_map<T>::value) {
+        constexpr bool variant_values = std::is_same_v<typename T::mapped_type, sdbus::Variant>;
+        std::size_t count = value.size();
+        if constexpr (variant_values) {
+            count = 0;
+            for (const auto& entry : value) {
+                count += variant_supported(entry.second) ? 1 : 0;
+            }
+        }
+        out.varint(count);
+        for (const auto& [key, element] : value) {
+            if constexpr (variant_values) {
+                if (!variant_supported(element)) {
+                    continue;
+                }
+            }
+            encode_value(out, key);
+            encode_value(out, element);
+        }
+    } else {
+        static_assert(!sizeof(T), "D-Bus type not supported by the capture");
+    }
+}
+
+/** @brief Read what encode_value() wrote, false on truncated or malformed input. */
+template<typename T>
+[[nodiscard]] auto decode_value(BinaryReader& in, T& value) -> bool {
+    if constexpr (std::is_same_v<T, sdbus::Variant>) {
+        return decode_variant(in, value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        uint64_t raw{};
+        if (!in.varint(raw) || raw > 1) {
+            return false;
+        }
+        value = raw != 0;
+        return true;
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        int64_t raw{};
+        if (!in.signed_varint(raw)) {
+            return false;
+        }
+        value = static_cast<T>(raw);
+        return true;
+    } else if constexpr (std::is_integral_v<T>) {
+        uint64_t raw{};
+        if (!in.varint(raw)) {
+            return false;
+        }
+        value = static_cast<T>(raw);
+        return true;
+    } else if constexpr (std::is_same_v<T, double>) {
+        uint64_t bits{};
+        if (!in.varint(bits)) {
+            return false;
+        }
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        std::string_view bytes;
+        if (!in.bytes(bytes)) {
+            return false;
+        }
+        value = T{std::string{bytes}};
+        return true;
+    } else if constexpr (is_vector<T>::value) {
+        uint64_t count{};
+        if (!in.varint(count)) {
+            return false;
+        }
+        value.clear();
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!decode_value(in, value.emplace_back())) {
+                return false;
+            }
+        }
+        return true;
+    } else if constexpr (is_map<T>::value) {
+        uint64_t count{};
+        if (!in.varint(count)) {
+            return false;
+        }
+        value.clear();
+        for (uint64_t i = 0; i < count; ++i) {
+            typename T::key_type key{};
+            typename T::mapped_type element{};
+            if (!decode_value(in, key) || !decode_value(in, element)) {
+                return false;
+            }
+            value.emplace(std::move(key), std::move(element));
+        }
+        return true;
+    } else {
+        static_assert(!sizeof(T), "D-Bus type not supported by the capture");
+    }
+}
+
+// --- file ---
+
+/** @brief one record of a capture, referring to the mapped file */
+struct CaptureRecord {
+    CaptureKind kind = CaptureKind::SIGNAL;
+    std::chrono::nanoseconds time{};  ///< since the start of the capture
+    std::string_view path;
+    std::string_view interface;
+    std::string_view member;
+    BinaryReader payload{nullptr, 0};  ///< the arguments, see decode_value()
+};
+
+/// @private layout of the start of a capture file, see capture.cpp
+struct CaptureHeader;
+
+/**
+ * @brief Appends records to a memory-mapped capture file of fixed capacity.
+ *
+ * Records are written in place, a record that doesn't fit anymore is dropped.
+ * The size in the header is only advanced once a record is complete, so a file that is read while it is written
+ * (or after a crash) never contains a partial record. Once closed, the file is truncated to its content.
+ *
+ * @note internal helper class, not part of the public API. Not thread-safe, see CaptureTap.
+ */
+class CaptureWriter {
+public:
+    /**
+     * @brief Create (or replace) the file and map it.
+     * @throws std::system_error if the file can't be created
+     */
+    CaptureWriter(const std::string& file, std::size_t capacity);
+    /** @brief Truncate the file to its content and unmap it. */
+    ~CaptureWriter();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+    CaptureWriter(CaptureWriter&&) = delete;
+    CaptureWriter& operator=(CaptureWriter&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /** @brief Append a record, write_payload(BinaryWriter&) writes the arguments. */
+    template<typename WritePayload>
+    void append(CaptureKind kind, std::string_view path, std::string_view interface, std::string_view member,
+                const WritePayload& write_payload) {
+        auto now = std::chrono::steady_clock::now();
+        BinaryWriter out{records_ + size_, capacity_ - size_};
+        auto mark = out.begin_message();
+        out.varint(static_cast<uint64_t>(kind));
+        out.varint(static_cast<uint64_t>(std::chrono::nanoseconds{now - last_}.count()));
+        out.bytes(path);
+        out.bytes(interface);
+        out.bytes(member);
+        write_payload(out);
+        out.end_message(mark);
+        if (out.overflow()) {
+            ++dropped_;  // full
+            return;
+        }
+        last_ = now;
+        commit(out.size());
+    }
+
+    /** @brief number of records written */
+    [[nodiscard]] auto records() const -> uint64_t { return records_count_; }
+    /** @brief number of records that didn't fit */
+    [[nodiscard]] auto dropped() const -> uint64_t { return dropped_; }
+    /** @brief bytes of records written */
+    [[nodiscard]] auto bytes() const -> uint64_t { return size_; }
+
+private:
+    int fd_ = -1;
+    CaptureHeader* header_ = nullptr;
+    uint8_t* records_ = nullptr;  // right after the header
+    std::size_t capacity_ = 0;    // bytes available for records
+    std::size_t size_ = 0;        // bytes of records written
+    uint64_t records_count_ = 0;
+    uint64_t dropped_ = 0;
+    std::chrono::steady_clock::time_point last_;  // time of the previous record, starts with the capture
+
+    void commit(std::size_t bytes);
+};
+
+/**
+ * @brief Reads the records of a capture file, in order.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class CaptureReader {
+public:
+    /**
+     * @brief Map the file read-only.
+     * @throws std::system_error if the file can't be read, std::runtime_error if it is no capture file
+     */
+    explicit CaptureReader(const std::string& file);
+    ~CaptureReader();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+    CaptureReader(CaptureReader&&) = delete;
+    CaptureReader& operator=(CaptureReader&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /**
+     * @brief Read the next record.
+     * @param malformed set if the rest of the file can't be read
+     * @return false at the end, or if malformed
+     */
+    [[nodiscard]] auto next(CaptureRecord& record, bool& malformed) -> bool;
+    /** @brief Start over from the first record. */
+    void rewind();
+
+private:
+    const uint8_t* memory_ = nullptr;
+    std::size_t mapped_ = 0;
+    BinaryReader records_{nullptr, 0};
+    std::chrono::nanoseconds time_{};
+};
+
+/**
+ * @brief Switch for capturing the messages received on one ProxyPool, cheap while it's off.
+ *
+ * Shared by the ModemManager, the ProxyPool and all SignalHubs. Recording is serialized by a mutex,
+ * which is only taken while capturing.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class CaptureTap {
+public:
+    /** @brief Start recording into writer, replacing the current one. */
+    void start(std::shared_ptr<CaptureWriter> writer);
+    /** @brief Stop recording, the writer is returned for its statistics and closed once released. */
+    auto stop() -> std::shared_ptr<CaptureWriter>;
+    /** @brief whether recording, a single relaxed atomic load */
+    [[nodiscard]] auto active() const -> bool { return active_.load(std::memory_order_relaxed); }
+
+    /** @brief Record a received message, no-op if not active(). */
+    template<typename... Args>
+    void record(CaptureKind kind, std::string_view path, std::string_view interface, std::string_view member,
+                const Args&... args) {
+        if (!active()) {
+            return;
+        }
+        std::lock_guard lock{mutex_};
+        if (writer_) {
+            writer_->append(kind, path, interface, member, [&](BinaryWriter& out) { (encode_value(out, args), ...); });
+        }
+    }
+
+private:
+    std::atomic<bool> active_{false};
+    std::mutex mutex_;  // protects writer_
+    std::shared_ptr<CaptureWriter> writer_;
+};
+
+} // namespace ezcellular
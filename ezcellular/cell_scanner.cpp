@@ -0,0 +1,157 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "cell_scanner.h"
+
+#include <exception>  // std::exception
+#include <functional> // std::hash
+#include <future>     // std::future
+#include <utility>    // std::move
+
+#include "modem.h"
+
+namespace ezcellular {
+
+auto CellKey::of(const CellInfo& cell) -> CellKey {
+    CellKey key{};
+    key.tech = cell.tech;
+    key.pci = cell.pci ? *cell.pci : NONE;
+    key.arfcn = cell.arfcn.value_or(NONE);
+    return key;
+}
+
+auto CellKeyHash::operator()(const CellKey& key) const -> std::size_t {
+    // boost::hash_combine
+    std::size_t seed = std::hash<uint32_t>{}(key.pci);
+    auto combine = [&seed](std::size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6U) + (seed >> 2U); };
+    combine(static_cast<std::size_t>(key.tech));
+    combine(key.arfcn);
+    return seed;
+}
+
+// common helper for sweep: whether a is the better measurement of the same cell
+static auto better(const CellInfo& a, const CellInfo& b) -> bool {
+    if (a.serving != b.serving) {
+        return a.serving;
+    }
+    return a.signal.rsrp.value_or(-1e9) > b.signal.rsrp.value_or(-1e9);
+}
+
+// common helper for sweep: take the identity of the cell that only the serving cell reports, if cell lacks it
+static void keep_identity(CellInfo& cell, const CellInfo& known) {
+    if (!cell.ci && known.ci) {
+        cell.ci = known.ci;
+    }
+    if (cell.location.empty() && !known.location.empty()) {
+        cell.location = known.location;
+    }
+}
+
+auto CellScanner::changed(const CellInfo& delivered, const CellInfo& current) const -> bool {
+    if (delivered.serving != current.serving) {
+        return true;
+    }
+    const auto& last = delivered.signal.rsrp;
+    const auto& now = current.signal.rsrp;
+    if (last.has_value() != now.has_value()) {
+        return true;
+    }
+    return last && rsrp_band_.enabled() && rsrp_band_.exceeded(*last, *now);
+}
+
+auto CellScanner::sweep(const std::vector<Modem>& modems) -> std::vector<CellDelta> {
+    // 1. request all at once, the replies are awaited afterwards
+    std::vector<std::future<std::vector<CellInfo>>> futures;
+    futures.reserve(modems.size());
+    bool complete = true;
+    for (const auto& modem : modems) {
+        try {
+            futures.push_back(modem.cell_info_async());
+        } catch (const std::exception&) {
+            complete = false;  // e.g. modem vanished
+        }
+    }
+
+    // 2. merge by key, keeping the best measurement of each cell
+    std::unordered_map<CellKey, CellInfo, CellKeyHash> merged;
+    std::vector<CellKey> order;  // as reported, for deterministic deltas
+    for (auto& future : futures) {
+        std::vector<CellInfo> cells;
+        try {
+            cells = future.get();
+        } catch (const std::exception&) {
+            complete = false;
+            continue;
+        }
+        for (auto& cell : cells) {
+            auto key = CellKey::of(cell);
+            auto [it, inserted] = merged.try_emplace(key, cell);
+            if (inserted) {
+                order.push_back(std::move(key));
+            } else if (better(cell, it->second)) {
+                keep_identity(cell, it->second);
+                it->second = std::move(cell);
+            } else {
+                keep_identity(it->second, cell);
+            }
+        }
+    }
+
+    // 3. update the index, only touching the reported cells and the ones that vanished
+    std::vector<CellDelta> deltas;
+    std::lock_guard lock{mutex_};
+    auto sweep = ++sweeps_;
+
+    for (const auto& key : order) {
+        auto& cell = merged.at(key);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            deltas.push_back(CellDelta{CellDelta::Kind::ADDED, key, cell});
+            index_.emplace(key, Entry{cell, cell, sweep});
+            continue;
+        }
+        keep_identity(cell, it->second.latest);  // e.g. no longer the serving cell
+        it->second.latest = cell;
+        it->second.sweep = sweep;
+        if (changed(it->second.delivered, cell)) {
+            it->second.delivered = cell;
+            deltas.push_back(CellDelta{CellDelta::Kind::CHANGED, key, cell});
+        }
+    }
+
+    if (complete && index_.size() > merged.size()) {
+        for (auto it = index_.begin(); it != index_.end();) {
+            if (it->second.sweep != sweep) {
+                deltas.push_back(CellDelta{CellDelta::Kind::REMOVED, it->first, it->second.delivered});
+                it = index_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    return deltas;
+}
+
+auto CellScanner::cells() const -> std::vector<CellInfo> {
+    std::lock_guard lock{mutex_};
+    std::vector<CellInfo> cells;
+    cells.reserve(index_.size());
+    for (const auto& [key, entry] : index_) {
+        cells.push_back(entry.latest);
+    }
+    return cells;
+}
+
+auto CellScanner::size() const -> std::size_t {
+    std::lock_guard lock{mutex_};
+    return index_.size();
+}
+
+auto CellScanner::sweeps() const -> uint64_t {
+    std::lock_guard lock{mutex_};
+    return sweeps_;
+}
+
+} // namespace ezcellular
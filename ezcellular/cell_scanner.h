@@ -0,0 +1,124 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <cstddef>       // std::size_t
+#include <cstdint>       // uint32_t, uint64_t
+#include <mutex>         // std::mutex
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include "enums.h"    // Technology
+#include "filters.h"  // Deadband
+#include "structs.h"  // CellInfo
+
+namespace ezcellular {
+
+class Modem; // IWYU pragma: keep
+
+/**
+ * @brief Identifies a cell across modems and sweeps, see CellScanner.
+ *
+ * Only the identifiers that serving and neighboring cells both report: the physical cell ID on a channel.
+ * The CI, TAC and PLMN are only reported for the serving cell, so they are attributes of the cell instead
+ * (see CellInfo::ci and CellInfo::location), and a cell keeps its key when it becomes (or ceases to be) the
+ * serving cell. Identifiers that were not reported are NONE.
+ */
+struct CellKey {
+    /** @brief value of identifiers that were not reported */
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    Technology tech = Technology::UNKNOWN; ///< see CellInfo::tech
+    uint32_t pci = NONE;                   ///< see CellInfo::pci
+    uint32_t arfcn = NONE;                 ///< see CellInfo::arfcn
+
+    /** @brief the key of a cell */
+    static auto of(const CellInfo& cell) -> CellKey;
+
+    /** @brief equal if all identifiers are */
+    auto operator==(const CellKey& other) const -> bool {
+        return tech == other.tech && pci == other.pci && arfcn == other.arfcn;
+    }
+};
+
+/** @brief hash for CellKey, e.g. for std::unordered_map */
+struct CellKeyHash {
+    /** @brief combined hash of all identifiers */
+    auto operator()(const CellKey& key) const -> std::size_t;
+};
+
+/**
+ * @brief A change of the cell index, see CellScanner::sweep().
+ */
+struct CellDelta {
+    /** @brief what changed */
+    enum class Kind {
+        ADDED,   ///< the cell is reported for the first time
+        CHANGED, ///< the cell changed significantly since it was last delivered, see CellScanner
+        REMOVED, ///< no modem reported the cell anymore, cell is the last delivered state
+    };
+
+    Kind kind;     ///< what changed
+    CellKey key;   ///< the cell
+    CellInfo cell; ///< the merged state of the cell, i.e. the strongest measurement of all modems
+};
+
+/**
+ * @brief Scans the cells of several modems at once, and keeps a merged index of all cells across sweeps.
+ *
+ * Each sweep requests the cell info of all modems in parallel (see Modem::cell_info_async()), merges them
+ * by CellKey, and only returns what changed since the previous sweep. So the work after a sweep scales with the
+ * cell churn rather than the number of cells.
+ *
+ * A cell CHANGED if it became (or ceased to be) the serving cell, if its RSRP moved out of the Deadband
+ * (or appeared or disappeared). Smaller changes are not reported, but can be read from cells().
+ * The CI and Location of a cell that is only reported as a neighbor (anymore) are kept from when it was serving.
+ *
+ * @warning With EventLoopMode::EXTERNAL, don't sweep on the event loop thread, see ModemManager.
+ */
+class CellScanner {
+public:
+    /** @brief default Deadband for the RSRP, in dB */
+    static constexpr double DEFAULT_RSRP_DEADBAND_DB = 3.0;
+
+    /**
+     * @brief Create a scanner with an empty index.
+     * @param rsrp_band when a changed RSRP is to be reported, see above
+     */
+    explicit CellScanner(Deadband rsrp_band = Deadband{DEFAULT_RSRP_DEADBAND_DB, 0.0}) : rsrp_band_{rsrp_band} {}
+
+    /**
+     * @brief Scan all modems at once and update the index.
+     *
+     * If the cell info of any modem could not be fetched, no cell is REMOVED by this sweep,
+     * as the failed modem might still receive it.
+     * @param modems the modems to scan, e.g. ModemManager::available_modems()
+     * @return the changes since the last sweep, ADDED and CHANGED in the order reported, then REMOVED
+     */
+    auto sweep(const std::vector<Modem>& modems) -> std::vector<CellDelta>;
+
+    /** @brief the current state of all known cells, i.e. the latest measurements (also if not reported as delta) */
+    [[nodiscard]] auto cells() const -> std::vector<CellInfo>;
+    /** @brief number of known cells */
+    [[nodiscard]] auto size() const -> std::size_t;
+    /** @brief number of sweeps done */
+    [[nodiscard]] auto sweeps() const -> uint64_t;
+
+private:
+    struct Entry {
+        CellInfo delivered; // the state last reported as delta
+        CellInfo latest;    // the latest merged measurement
+        uint64_t sweep;     // the sweep that saw the cell last
+    };
+
+    Deadband rsrp_band_;
+    mutable std::mutex mutex_;  // protects the members below, not held while the modems are scanned
+    std::unordered_map<CellKey, Entry, CellKeyHash> index_;
+    uint64_t sweeps_ = 0;
+
+    [[nodiscard]] auto changed(const CellInfo& delivered, const CellInfo& current) const -> bool;
+};
+
+} // namespace ezcellular
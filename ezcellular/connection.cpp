@@ -4,58 +4,96 @@
 */
 #include "connection.h"
 
+#include <chrono>    // std::chrono::steady_clock
 #include <map>       // std::map
+#include <mutex>     // std::mutex, std::call_once
 #include <stdexcept> // std::out_of_range
-#include <utility>   // std::move
+#include <utility>   // std::move, std::exchange
 #include <vector>    // std::vector
 
+#include "call_metrics.h"  // ScopedCall, CallTimer
 #include "dbus_constants.h"
+#include "dbus_helpers.h"  // get_property_async, set_promise_from
+#include "dispatcher.h"    // ObserverQueue
 #include "exception.h"
+#include "observer_filter.h"  // TrafficStatsGate
+#include "proxy_pool.h"
+#include "signal_hub.h"
+#include "traffic_poller.h"  // TrafficPoller
+#include "traffic_source.h"  // TrafficStatsSource, KernelTrafficStatsSource
 
 namespace ezcellular {
 
-Connection::Connection(std::weak_ptr<sdbus::IConnection> conn, const sdbus::ObjectPath& dbus_path)
-    : conn_{std::move(conn)}, dbus_proxy_{sdbus::createProxy(*conn_.lock(), DBus::MM_BUS_NAME, dbus_path)} {}
+/**
+ * @brief NetworkManager device of the connection's linux interface
+ */
+struct Connection::NMDevice {
+    std::mutex mutex;                        ///< protects the members below
+    std::shared_ptr<sdbus::IProxy> nm_proxy; ///< NetworkManager root object
+    std::string iface;                       ///< linux interface of the bearer (and proxy), empty until resolved
+    std::shared_ptr<sdbus::IProxy> proxy;    ///< NetworkManager device object, reset if the interface changes
+    std::once_flag subscribed;               ///< whether the bearer is observed for interface changes
+    Subscription bearer_watch;               ///< the bearer observer, see watch_bearer_interface()
+};
+
+// the default TrafficStatsSource, shared by all Connections (and its netlink socket)
+static auto default_traffic_stats_source() -> std::shared_ptr<TrafficStatsSource> {
+    static auto source = std::make_shared<KernelTrafficStatsSource>();
+    return source;
+}
+
+Connection::Connection(std::weak_ptr<sdbus::IConnection> conn, const sdbus::ObjectPath& dbus_path,
+                       std::shared_ptr<Dispatcher> dispatcher, std::shared_ptr<ProxyPool> proxies,
+                       const std::string& modem_path)
+    : conn_{std::move(conn)}, proxies_{proxies ? std::move(proxies) : std::make_shared<ProxyPool>(conn_)},
+      hub_{proxies_->hub(DBus::MM_BUS_NAME, dbus_path, modem_path)}, dbus_proxy_{hub_->shared_proxy()},
+      nm_device_{std::make_shared<NMDevice>()}, dispatcher_{std::move(dispatcher)},
+      stats_source_{default_traffic_stats_source()} {}
 
 // --- bearer info ---
 
 auto Connection::active() const -> bool {
-    return dbus_proxy_->getProperty("Connected").onInterface(DBus::MM_IF_BEARER);
+    return DBus::get_property(*dbus_proxy_, DBus::BEARER_CONNECTED);
+}
+
+// common helper for settings, settings_async
+static auto dbus_properties_to_BearerSettings(const std::map<std::string, sdbus::Variant>& result) -> BearerSettings {
+    BearerSettings settings{};
+    settings.apn = result.at("apn").get<std::string>();
+    settings.ip_type = static_cast<IPType>(result.at("ip-type").get<std::uint32_t>());
+    return settings;
+}
+
+auto Connection::settings() const -> BearerSettings {
+    return dbus_properties_to_BearerSettings(DBus::get_property(*dbus_proxy_, DBus::BEARER_PROPERTIES));
 }
 
 auto Connection::apn() const -> std::string {
-    std::map<std::string, sdbus::Variant> result;
-    result = dbus_proxy_->getProperty("Properties").onInterface(DBus::MM_IF_BEARER);
-    return result["apn"].get<std::string>();
+    return settings().apn;
 }
 
 auto Connection::ip_type() const -> IPType {
-    std::map<std::string, sdbus::Variant> result;
-    result = dbus_proxy_->getProperty("Properties").onInterface(DBus::MM_IF_BEARER);
-    return static_cast<IPType>(result["ip-type"].get<std::uint32_t>());
+    return settings().ip_type;
 }
 
 // --- IP info ---
 
 auto Connection::linux_interface() const -> std::string {
-    return dbus_proxy_->getProperty("Interface").onInterface(DBus::MM_IF_BEARER);
+    return DBus::get_property(*dbus_proxy_, DBus::BEARER_INTERFACE);
 }
 
-auto Connection::get_ip_config(IPType type) const -> std::optional<IPConfig> {
-    IPConfig ip_conf{};
-    std::string prop_name;
-
-    if (type == IPType::IPV4) {
-        prop_name = "Ip4Config";
-    } else if (type == IPType::IPV6) {
-        prop_name = "Ip6Config";
-    } else {
-        __builtin_unreachable(); // GCC ONLY
-        return {}; // empty
+// common helper for get_ip_config, get_ip_config_async
+static auto ip_config_prop(IPType type) -> const DBus::Prop<sdbus_variant_map>& {
+    if (type == IPType::IPV6) {
+        return DBus::BEARER_IP6_CONFIG;
     }
+    return DBus::BEARER_IP4_CONFIG;
+}
 
-    std::map<std::string, sdbus::Variant> result = dbus_proxy_->getProperty(prop_name)
-        .onInterface(DBus::MM_IF_BEARER);
+// common helper for get_ip_config, get_ip_config_async
+static auto dbus_ip_config_to_IPConfig(IPType type, const std::map<std::string, sdbus::Variant>& result)
+    -> std::optional<IPConfig> {
+    IPConfig ip_conf{};
 
     try {
         ip_conf.ip_type = type;
@@ -71,6 +109,10 @@ auto Connection::get_ip_config(IPType type) const -> std::optional<IPConfig> {
     return ip_conf;
 }
 
+auto Connection::get_ip_config(IPType type) const -> std::optional<IPConfig> {
+    return dbus_ip_config_to_IPConfig(type, DBus::get_property(*dbus_proxy_, ip_config_prop(type)));
+}
+
 auto Connection::ipv4_config() const -> std::optional<IPConfig> {
     return get_ip_config(IPType::IPV4);
 }
@@ -81,61 +123,455 @@ auto Connection::ipv6_config() const -> std::optional<IPConfig> {
 
 // --- IP metrics ---
 
-auto Connection::get_nm_device_proxy() const -> std::unique_ptr<sdbus::IProxy> {
+auto Connection::get_nm_device_path(const std::string& iface) const -> sdbus::ObjectPath {
     sdbus::ObjectPath obj_path_nm_dev;
-    auto iface = linux_interface();
 
-    if (auto conn = conn_.lock()) {
-        // 1. get "Device" object path for wwan iface (e.g. "wwan0")
-        auto nm_proxy = sdbus::createProxy(*conn, DBus::NM_BUS_NAME, DBus::NM_OBJ_NETWORKMANAGER);
+    std::shared_ptr<sdbus::IProxy> nm_proxy;
+    {
+        std::lock_guard lock{nm_device_->mutex};
+        if (!nm_device_->nm_proxy) {
+            nm_device_->nm_proxy = proxies_->hub(DBus::NM_BUS_NAME, DBus::NM_OBJ_NETWORKMANAGER)->shared_proxy();
+        }
+        nm_proxy = nm_device_->nm_proxy;
+    }
+
+    // get "Device" object path for wwan iface (e.g. "wwan0")
+    {
+        static CallSiteRef site{DBus::NM_IF_NETWORKMANAGER, "GetDeviceByIpIface"};
+        ScopedCall call{site};
         nm_proxy->callMethod("GetDeviceByIpIface")
             .onInterface(DBus::NM_IF_NETWORKMANAGER)
             .withArguments(iface)
             .storeResultsTo(obj_path_nm_dev);
-        // 2. return the proxy
-        return sdbus::createProxy(*conn, DBus::NM_BUS_NAME, obj_path_nm_dev);
     }
+    return obj_path_nm_dev;
+}
 
-    throw ConnectionException("DBus connection lost");
+auto Connection::shared_nm_device_proxy() const -> std::shared_ptr<sdbus::IProxy> {
+    watch_bearer_interface();
+    {
+        std::lock_guard lock{nm_device_->mutex};
+        if (nm_device_->proxy) {
+            return nm_device_->proxy;
+        }
+    }
+
+    // resolve: linux interface -> NM device
+    auto iface = linux_interface();
+    auto obj_path_nm_dev = get_nm_device_path(iface);
+    auto proxy = proxies_->hub(DBus::NM_BUS_NAME, obj_path_nm_dev, dbus_proxy_->getObjectPath())->shared_proxy();
+
+    std::lock_guard lock{nm_device_->mutex};
+    nm_device_->iface = iface;
+    nm_device_->proxy = proxy;
+    return proxy;
+}
+
+// (private) the linux interface, resolved once until the bearer's interface changes
+auto Connection::resolved_linux_interface() const -> std::string {
+    watch_bearer_interface();
+    {
+        std::lock_guard lock{nm_device_->mutex};
+        if (!nm_device_->iface.empty()) {
+            return nm_device_->iface;
+        }
+    }
+
+    auto iface = linux_interface();
+    std::lock_guard lock{nm_device_->mutex};
+    if (nm_device_->iface.empty()) {
+        nm_device_->iface = iface;
+    }
+    return iface;
+}
+
+// invalidate the resolved device when the bearer's interface changes (e.g. on reconnect)
+void Connection::watch_bearer_interface() const {
+    std::call_once(nm_device_->subscribed, [&]() {
+        auto subscription = hub_->subscribe_interface(DBus::MM_IF_BEARER,
+            [weak_dev = std::weak_ptr<NMDevice>{nm_device_}, weak_pool = std::weak_ptr<ProxyPool>{proxies_}](
+                    const std::map<std::string, sdbus::Variant>& changedProperties,
+                    [[maybe_unused]] const std::vector<std::string>& invalidatedProperties) {
+                if (changedProperties.count(DBus::BEARER_INTERFACE.name()) == 0
+                    && changedProperties.count(DBus::BEARER_CONNECTED.name()) == 0) {
+                    return;
+                }
+                auto dev = weak_dev.lock();
+                if (!dev) {
+                    return;
+                }
+                std::string stale_path;
+                {
+                    std::lock_guard lock{dev->mutex};
+                    if (dev->proxy) {
+                        stale_path = dev->proxy->getObjectPath();
+                    }
+                    dev->iface.clear();
+                    dev->proxy.reset();
+                }
+                // NetworkManager creates a new device object on reconnect
+                if (auto pool = weak_pool.lock(); pool && !stale_path.empty()) {
+                    pool->evict(stale_path);
+                }
+            });
+
+        std::lock_guard lock{nm_device_->mutex};
+        nm_device_->bearer_watch = std::move(subscription);
+    });
+}
+
+void Connection::invalidate_nm_device() const {
+    std::lock_guard lock{nm_device_->mutex};
+    nm_device_->iface.clear();
+    nm_device_->proxy.reset();
+}
+
+void Connection::set_traffic_stats_source(std::shared_ptr<TrafficStatsSource> source) {
+    stats_source_ = std::move(source);
 }
 
 auto Connection::traffic_stats() const -> TrafficStats {
+    if (stats_source_) {
+        if (auto stats = stats_source_->read(resolved_linux_interface())) {
+            return *stats;
+        }
+    }
+
+    // fallback: NetworkManager
     TrafficStats stats{};
-    auto nm_dev_proxy = get_nm_device_proxy();
+    std::map<std::string, sdbus::Variant> props;
 
-    stats.rx_bytes = nm_dev_proxy->getProperty("RxBytes").onInterface(DBus::NM_IF_DEVICE_STATISTICS);
-    stats.tx_bytes = nm_dev_proxy->getProperty("TxBytes").onInterface(DBus::NM_IF_DEVICE_STATISTICS);
+    // RxBytes and TxBytes at once
+    auto get_stats = [&]() {
+        static CallSiteRef site{DBus::NM_IF_DEVICE_STATISTICS, "GetAll"};
+        ScopedCall call{site};
+        shared_nm_device_proxy()->callMethod("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES)
+            .withArguments(std::string{DBus::NM_IF_DEVICE_STATISTICS})
+            .storeResultsTo(props);
+    };
+
+    try {
+        get_stats();
+    } catch (const sdbus::Error&) {
+        // the device might have vanished in the meantime, resolve again and retry once
+        invalidate_nm_device();
+        get_stats();
+    }
+
+    stats.rx_bytes = props.at(DBus::NM_STATS_RX_BYTES.name()).get<uint64_t>();
+    stats.tx_bytes = props.at(DBus::NM_STATS_TX_BYTES.name()).get<uint64_t>();
 
     return stats;
 }
 
-void Connection::observe_traffic_stats(Connection::TrafficStatsObserver observer, uint32_t interval_ms) {
-    /* get RX/TX stats from NetworkManager D-Bus endpoint */
+// (private) common helper for observe_traffic_stats, observe_traffic_rate
+auto Connection::subscribe_traffic_stats(const TimedTrafficStatsObserver& observer, uint32_t interval_ms)
+    -> Subscription {
+    /* poll the source, if it has counters for the interface */
+    if (stats_source_) {
+        auto iface = resolved_linux_interface();
+        if (stats_source_->read(iface)) {
+            auto interval = std::chrono::milliseconds{interval_ms != 0 ? interval_ms : DEFAULT_TRAFFIC_INTERVAL_MS};
+            // all observers of the source with this interval share one thread and one read per tick
+            auto poller = TrafficPoller::shared(stats_source_, interval);
+
+            // the bearer may reconnect on another interface, then poll that one instead
+            struct Polled {
+                std::mutex mutex;  // protects the members below
+                std::string iface;
+                uint64_t id = 0;
+            };
+            auto polled = std::make_shared<Polled>();
+            {
+                std::lock_guard lock{polled->mutex};
+                polled->iface = iface;
+                polled->id = poller->add(iface, observer);
+            }
+            auto watch = hub_->watch(DBus::BEARER_INTERFACE,
+                [poller, observer, weak_polled = std::weak_ptr<Polled>{polled}](const std::string& new_iface) {
+                    auto polled_ = weak_polled.lock();
+                    if (!polled_ || new_iface.empty()) {
+                        return;  // unsubscribed, or disconnected: the next connect brings the interface
+                    }
+                    std::lock_guard lock{polled_->mutex};
+                    if (polled_->id == 0 || new_iface == polled_->iface) {
+                        return;
+                    }
+                    poller->remove(polled_->id);
+                    polled_->iface = new_iface;
+                    polled_->id = poller->add(new_iface, observer);
+                });
+            return Subscription{[poller, polled, watch = std::make_shared<Subscription>(std::move(watch))]() {
+                watch->reset();
+                std::lock_guard lock{polled->mutex};
+                poller->remove(std::exchange(polled->id, 0));
+            }};
+        }
+    }
+
+    /* otherwise get RX/TX stats from NetworkManager D-Bus endpoint */
     if (auto conn = conn_.lock()) {
-        std::shared_ptr<sdbus::IProxy> nm_dev_proxy = get_nm_device_proxy();
-
-        // 1. set refresh interval
-        nm_dev_proxy->setProperty("RefreshRateMs").onInterface(DBus::NM_IF_DEVICE_STATISTICS).toValue(interval_ms);
-
-        // 3. subscribe to changes via DBus' default PropertiesChanged signal
-        nm_dev_proxy->uponSignal("PropertiesChanged").onInterface(DBus::DBUS_IF_PROPERTIES).call(
-            [nm_dev_proxy, observer](const std::string& interfaceName,
-                                     [[maybe_unused]] const std::map<std::string, sdbus::Variant>& changedProperties,
-                                     [[maybe_unused]] const std::vector<std::string>& invalidatedProperties) {
-            // check relevant interface
-            if (interfaceName == DBus::NM_IF_DEVICE_STATISTICS) {
-                // fetch RxBytes and TxBytes
-                TrafficStats stats{};
-                stats.rx_bytes = nm_dev_proxy->getProperty("RxBytes").onInterface(DBus::NM_IF_DEVICE_STATISTICS);
-                stats.tx_bytes = nm_dev_proxy->getProperty("TxBytes").onInterface(DBus::NM_IF_DEVICE_STATISTICS);
-                (void) observer(stats);
+        auto nm_dev_hub = proxies_->hub(DBus::NM_BUS_NAME, get_nm_device_path(linux_interface()),
+                                        dbus_proxy_->getObjectPath());
+        auto nm_dev_proxy = nm_dev_hub->shared_proxy();
+
+        // 1. set refresh interval, 0 keeps the current one (setting 0 would turn the updates off)
+        if (interval_ms != 0) {
+            static CallSiteRef site{DBus::NM_IF_DEVICE_STATISTICS, "Set"};
+            ScopedCall call{site};
+            nm_dev_proxy->setProperty("RefreshRateMs").onInterface(DBus::NM_IF_DEVICE_STATISTICS).toValue(interval_ms);
+        }
+
+        // 2. subscribe to changes via DBus' default PropertiesChanged signal
+        //    NM only sends the counters that changed, so remember the last value of both
+        struct Counters {
+            std::optional<uint64_t> rx_bytes;
+            std::optional<uint64_t> tx_bytes;
+        };
+        //    the proxy is owned by the hub, which lives as long as the subscription (even if evicted from the pool)
+        auto subscription = nm_dev_hub->subscribe_interface(DBus::NM_IF_DEVICE_STATISTICS,
+            [dev_proxy = nm_dev_proxy.get(), observer, counters = std::make_shared<Counters>()](
+                    const std::map<std::string, sdbus::Variant>& changedProperties,
+                    [[maybe_unused]] const std::vector<std::string>& invalidatedProperties) {
+            auto now = std::chrono::steady_clock::now();
+
+            // take the counters from the signal
+            if (auto it = changedProperties.find(DBus::NM_STATS_RX_BYTES.name()); it != changedProperties.end()) {
+                counters->rx_bytes = it->second.get<uint64_t>();
+            }
+            if (auto it = changedProperties.find(DBus::NM_STATS_TX_BYTES.name()); it != changedProperties.end()) {
+                counters->tx_bytes = it->second.get<uint64_t>();
             }
+            if (!counters->rx_bytes && !counters->tx_bytes) {
+                return;  // e.g. only RefreshRateMs changed
+            }
+
+            // only fetch a counter that was never sent
+            if (!counters->rx_bytes) {
+                counters->rx_bytes = DBus::get_property(*dev_proxy, DBus::NM_STATS_RX_BYTES);
+            }
+            if (!counters->tx_bytes) {
+                counters->tx_bytes = DBus::get_property(*dev_proxy, DBus::NM_STATS_TX_BYTES);
+            }
+
+            TrafficStats stats{};
+            stats.rx_bytes = *counters->rx_bytes;
+            stats.tx_bytes = *counters->tx_bytes;
+            observer(stats, now);
         });
-        nm_dev_proxy->finishRegistration();
 
+        auto inner = std::make_shared<Subscription>(std::move(subscription));
+        return Subscription{[inner, nm_dev_hub]() { inner->reset(); }};
     } else {
         throw ConnectionException("DBus connection lost");
     }
 }
 
+auto Connection::observe_traffic_stats(Connection::TrafficStatsObserver observer, uint32_t interval_ms,
+                                       const TrafficStatsFilter& filter) -> Subscription {
+    auto gate = std::make_shared<TrafficStatsGate>(filter);
+    return subscribe_traffic_stats([queue = ObserverQueue::create(dispatcher_), gate, observer = std::move(observer)](
+            const TrafficStats& stats, std::chrono::steady_clock::time_point time) {
+        if (!gate->admit(stats, time)) {
+            return;  // filtered on the D-Bus thread, never queued
+        }
+        queue->post([observer, stats]() { observer(stats); });
+    }, interval_ms);
+}
+
+// common helper for observe_traffic_rate, bytes/s between two samples
+static auto bytes_per_sec(uint64_t prev, uint64_t curr, double seconds) -> double {
+    if (curr < prev || seconds <= 0.0) {
+        return 0.0;  // counter reset, e.g. after reconnect
+    }
+    return static_cast<double>(curr - prev) / seconds;
+}
+
+auto Connection::observe_traffic_rate(Connection::TrafficRateObserver observer, uint32_t interval_ms)
+    -> Subscription {
+    struct Previous {
+        std::optional<TrafficStats> stats;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    // the rate is derived on the D-Bus thread, so that dropped updates don't distort it
+    return subscribe_traffic_stats([queue = ObserverQueue::create(dispatcher_), observer = std::move(observer), prev = Previous{}](
+            const TrafficStats& stats, std::chrono::steady_clock::time_point time) mutable {
+        if (prev.stats) {
+            std::chrono::duration<double> elapsed = time - prev.time;
+            TrafficRate rate{};
+            rate.rx_bytes_per_sec = bytes_per_sec(prev.stats->rx_bytes, stats.rx_bytes, elapsed.count());
+            rate.tx_bytes_per_sec = bytes_per_sec(prev.stats->tx_bytes, stats.tx_bytes, elapsed.count());
+            queue->post([observer, stats, rate]() { observer(stats, rate); });
+        }
+        prev.stats = stats;
+        prev.time = time;
+    }, interval_ms);
+}
+
+// --- asynchronous variants ---
+
+auto Connection::active_async() const -> std::future<bool> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::BEARER_CONNECTED);
+}
+
+auto Connection::settings_async() const -> std::future<BearerSettings> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::BEARER_PROPERTIES, dbus_properties_to_BearerSettings);
+}
+
+auto Connection::apn_async() const -> std::future<std::string> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::BEARER_PROPERTIES, [](const sdbus_variant_map& result) {
+        return dbus_properties_to_BearerSettings(result).apn;
+    });
+}
+
+auto Connection::ip_type_async() const -> std::future<IPType> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::BEARER_PROPERTIES, [](const sdbus_variant_map& result) {
+        return dbus_properties_to_BearerSettings(result).ip_type;
+    });
+}
+
+auto Connection::linux_interface_async() const -> std::future<std::string> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::BEARER_INTERFACE);
+}
+
+auto Connection::get_ip_config_async(IPType type) const -> std::future<std::optional<IPConfig>> {
+    return DBus::get_property_async(*dbus_proxy_, ip_config_prop(type), [type](const sdbus_variant_map& result) {
+        return dbus_ip_config_to_IPConfig(type, result);
+    });
+}
+
+auto Connection::ipv4_config_async() const -> std::future<std::optional<IPConfig>> {
+    return get_ip_config_async(IPType::IPV4);
+}
+
+auto Connection::ipv6_config_async() const -> std::future<std::optional<IPConfig>> {
+    return get_ip_config_async(IPType::IPV6);
+}
+
+// common helper for traffic_stats_async
+static void nm_device_stats_async(sdbus::IProxy& dev_proxy, const std::shared_ptr<std::promise<TrafficStats>>& promise) {
+    static CallSiteRef site{DBus::NM_IF_DEVICE_STATISTICS, "GetAll"};
+    dev_proxy.callMethodAsync("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES)
+        .withArguments(std::string{DBus::NM_IF_DEVICE_STATISTICS})
+        .uponReplyInvoke([promise, timer = CallTimer::start(site)](const sdbus::Error* err,
+                                                                   const std::map<std::string, sdbus::Variant>& props) {
+            timer.finish(err != nullptr);
+            if (err != nullptr) {
+                promise->set_exception(std::make_exception_ptr(*err));
+                return;
+            }
+            DBus::set_promise_from(*promise, [&]() {
+                TrafficStats stats{};
+                stats.rx_bytes = props.at(DBus::NM_STATS_RX_BYTES.name()).get<uint64_t>();
+                stats.tx_bytes = props.at(DBus::NM_STATS_TX_BYTES.name()).get<uint64_t>();
+                return stats;
+            });
+        });
+}
+
+auto Connection::traffic_stats_async() const -> std::future<TrafficStats> {
+    auto promise = std::make_shared<std::promise<TrafficStats>>();
+    auto future = promise->get_future();
+
+    watch_bearer_interface();
+
+    // fast path: interface or device already resolved
+    std::string iface;
+    {
+        std::lock_guard lock{nm_device_->mutex};
+        iface = nm_device_->iface;
+    }
+    if (stats_source_ && !iface.empty()) {
+        if (auto stats = stats_source_->read(iface)) {
+            promise->set_value(*stats);
+            return future;
+        }
+    }
+    {
+        std::lock_guard lock{nm_device_->mutex};
+        if (nm_device_->proxy) {
+            nm_device_stats_async(*nm_device_->proxy, promise);
+            return future;
+        }
+    }
+
+    // chain: 1. linux interface -> the source, or 2. NM device -> 3. statistics, each from the previous reply.
+    // The proxies are pooled and held by nm_device_, as a proxy can't be released from within its own callback.
+    static CallSiteRef get_site{DBus::MM_IF_BEARER, "Get"};
+    dbus_proxy_->callMethodAsync("Get").onInterface(DBus::DBUS_IF_PROPERTIES)
+        .withArguments(DBus::BEARER_INTERFACE.interface(), DBus::BEARER_INTERFACE.name())
+        .uponReplyInvoke([promise, weak_pool = std::weak_ptr<ProxyPool>{proxies_},
+                          weak_dev = std::weak_ptr<NMDevice>{nm_device_}, bearer_path = dbus_proxy_->getObjectPath(),
+                          source = stats_source_, timer = CallTimer::start(get_site)](
+                const sdbus::Error* err, const sdbus::Variant& iface_var) {
+            timer.finish(err != nullptr);
+            if (err != nullptr) {
+                promise->set_exception(std::make_exception_ptr(*err));
+                return;
+            }
+            auto pool = weak_pool.lock();
+            auto dev = weak_dev.lock();
+            if (!pool || !dev) {
+                promise->set_exception(std::make_exception_ptr(ConnectionException("DBus connection lost")));
+                return;
+            }
+            auto iface = iface_var.get<std::string>();
+
+            // the source doesn't block, so it is read right here
+            if (source) {
+                if (auto stats = source->read(iface)) {
+                    std::lock_guard lock{dev->mutex};
+                    if (dev->iface.empty()) {
+                        dev->iface = iface;
+                    }
+                    promise->set_value(*stats);
+                    return;
+                }
+            }
+
+            std::lock_guard lock{dev->mutex};
+            try {
+                if (!dev->nm_proxy) {
+                    dev->nm_proxy = pool->hub(DBus::NM_BUS_NAME, DBus::NM_OBJ_NETWORKMANAGER)->shared_proxy();
+                }
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+                return;
+            }
+            static CallSiteRef device_site{DBus::NM_IF_NETWORKMANAGER, "GetDeviceByIpIface"};
+            dev->nm_proxy->callMethodAsync("GetDeviceByIpIface").onInterface(DBus::NM_IF_NETWORKMANAGER)
+                .withArguments(iface)
+                .uponReplyInvoke([promise, weak_pool, weak_dev, iface, bearer_path,
+                                  timer = CallTimer::start(device_site)](
+                        const sdbus::Error* err, const sdbus::ObjectPath& obj_path_nm_dev) {
+                    timer.finish(err != nullptr);
+                    if (err != nullptr) {
+                        promise->set_exception(std::make_exception_ptr(*err));
+                        return;
+                    }
+                    auto pool = weak_pool.lock();
+                    auto dev = weak_dev.lock();
+                    if (!pool || !dev) {
+                        promise->set_exception(std::make_exception_ptr(ConnectionException("DBus connection lost")));
+                        return;
+                    }
+
+                    std::lock_guard lock{dev->mutex};
+                    try {
+                        if (!dev->proxy || dev->proxy->getObjectPath() != obj_path_nm_dev) {
+                            dev->iface = iface;
+                            dev->proxy = pool->hub(DBus::NM_BUS_NAME, obj_path_nm_dev, bearer_path)->shared_proxy();
+                        }
+                    } catch (...) {
+                        promise->set_exception(std::current_exception());
+                        return;
+                    }
+                    nm_device_stats_async(*dev->proxy, promise);
+                });
+        });
+
+    return future;
+}
+
 } // namespace ezcellular
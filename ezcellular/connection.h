@@ -4,19 +4,28 @@
 */
 #pragma once
 
+#include <chrono>      // std::chrono::steady_clock
 #include <cstdint>     // uint32_t and friends
 #include <functional>  // std::function
-#include <memory>      // std::unique_ptr, std::weak_ptr
+#include <future>      // std::future
+#include <memory>      // std::shared_ptr, std::weak_ptr
 #include <string>      // std::string
 #include <optional>    // std::optional
 
 #include <sdbus-c++/sdbus-c++.h>  // sdbus::*
 
 #include "enums.h"    // IPType
-#include "structs.h"  // IPConfig, TrafficStats
+#include "filters.h"  // TrafficStatsFilter
+#include "structs.h"  // BearerSettings, IPConfig, TrafficStats, TrafficRate
+#include "subscription.h"  // Subscription
 
 namespace ezcellular {
 
+class Dispatcher; // IWYU pragma: keep
+class ProxyPool; // IWYU pragma: keep
+class SignalHub; // IWYU pragma: keep
+class TrafficStatsSource; // IWYU pragma: keep
+
 /**
  * @brief Represents a connection and provides its most relevant information.
  *
@@ -48,6 +57,11 @@ public:
 
     /** @brief Whether the Connection is active (i.e. can be used for data communication) */
     [[nodiscard]] auto active() const -> bool;
+    /**
+     * @brief The configured APN/PDN and IP type.
+     * @note fetches both at once, prefer it over apn() and ip_type() if both are needed.
+     */
+    [[nodiscard]] auto settings() const -> BearerSettings;
     /** @brief The configured APN/PDN. */
     [[nodiscard]] auto apn() const -> std::string;
     /** @brief The configured APN/PDN IP type. */
@@ -64,27 +78,108 @@ public:
 
     // --- IP metrics ---
 
-    /** @brief Traffic statistics */
+    /**
+     * @brief Traffic statistics
+     *
+     * Read from the TrafficStatsSource, by default the kernel (see KernelTrafficStatsSource).
+     * Falls back to NetworkManager if the source has no counters for the interface.
+     * @note The linux interface and the NetworkManager device are resolved on the first call and reused afterwards,
+     *       until the linux interface of the bearer changes.
+     */
     [[nodiscard]] auto traffic_stats() const -> TrafficStats;
+    /** @brief default interval of observe_traffic_stats() and observe_traffic_rate() with a TrafficStatsSource */
+    static constexpr uint32_t DEFAULT_TRAFFIC_INTERVAL_MS = 1000;
+    /**
+     * @brief Set where traffic_stats() and the traffic observers take the counters from.
+     * @param source e.g. a KernelTrafficStatsSource, or nullptr for NetworkManager only
+     * @note only applies to observers registered afterwards
+     */
+    void set_traffic_stats_source(std::shared_ptr<TrafficStatsSource> source);
     /** @brief type for callbacks needed for observe_traffic_stats() */
     using TrafficStatsObserver = std::function<void(TrafficStats)>;
     /**
      * @brief Register a callback for periodic TrafficStats updates.
+     *
+     * The TrafficStatsSource is polled on a background thread, shared by all observers of the source with the same
+     * interval (one read per tick for all of them). NetworkManager is used if the source has no counters.
      * @param observer the TrafficStatsObserver to register
-     * @param interval_ms the update interval in milliseconds
+     * @param interval_ms the update interval in milliseconds, 0 for DEFAULT_TRAFFIC_INTERVAL_MS
+     *        (NetworkManager: its current interval)
+     * @param filter drops updates with small changes, see TrafficStatsFilter
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
+     */
+    [[nodiscard]] auto observe_traffic_stats(TrafficStatsObserver observer, uint32_t interval_ms = 0,
+                                             const TrafficStatsFilter& filter = {}) -> Subscription;
+    /** @brief type for callbacks needed for observe_traffic_rate() */
+    using TrafficRateObserver = std::function<void(TrafficStats, TrafficRate)>;
+    /**
+     * @brief Register a callback for periodic TrafficStats updates, along with the data rate since the last update.
+     *
+     * The rate is derived from the counters of two consecutive updates and their (monotonic) arrival times,
+     * so the first update is not delivered.
+     * @param observer the TrafficRateObserver to register
+     * @param interval_ms the update interval in milliseconds, see observe_traffic_stats()
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
      */
-    void observe_traffic_stats(TrafficStatsObserver observer, uint32_t interval_ms = 0);
+    [[nodiscard]] auto observe_traffic_rate(TrafficRateObserver observer, uint32_t interval_ms = 0) -> Subscription;
+
+    // --- asynchronous variants ---
+
+    /**
+     * @name Asynchronous variants
+     *
+     * Non-blocking versions of the methods above, see Modem for details.
+     * @note The Connection object must be kept alive until the future is ready.
+     * @{
+     */
+    /** @brief see active() */
+    [[nodiscard]] auto active_async() const -> std::future<bool>;
+    /** @brief see settings() */
+    [[nodiscard]] auto settings_async() const -> std::future<BearerSettings>;
+    /** @brief see apn() */
+    [[nodiscard]] auto apn_async() const -> std::future<std::string>;
+    /** @brief see ip_type() */
+    [[nodiscard]] auto ip_type_async() const -> std::future<IPType>;
+    /** @brief see linux_interface() */
+    [[nodiscard]] auto linux_interface_async() const -> std::future<std::string>;
+    /** @brief see ipv4_config() */
+    [[nodiscard]] auto ipv4_config_async() const -> std::future<std::optional<IPConfig>>;
+    /** @brief see ipv6_config() */
+    [[nodiscard]] auto ipv6_config_async() const -> std::future<std::optional<IPConfig>>;
+    /** @brief see traffic_stats() */
+    [[nodiscard]] auto traffic_stats_async() const -> std::future<TrafficStats>;
+    /** @} */
 
 private:
     std::weak_ptr<sdbus::IConnection> conn_;
-    std::unique_ptr<sdbus::IProxy> dbus_proxy_;
+    std::shared_ptr<ProxyPool> proxies_;  // shared with the Modem, owns the bearer and NetworkManager proxies
+    std::shared_ptr<SignalHub> hub_;  // signal handlers of the bearer
+    std::shared_ptr<sdbus::IProxy> dbus_proxy_;
+
+    // NetworkManager proxies, outlive the asynchronous calls made on them
+    struct NMDevice;
+    std::shared_ptr<NMDevice> nm_device_;
+
+    std::shared_ptr<Dispatcher> dispatcher_;  // runs the observers, see ModemManager::set_executor()
+    std::shared_ptr<TrafficStatsSource> stats_source_;  // nullptr for NetworkManager only
 
     // private ctor; supposed to be invoked by class Modem only
     friend class Modem;
-    explicit Connection(std::weak_ptr<sdbus::IConnection>, const sdbus::ObjectPath&);
-
-    [[nodiscard]] auto get_nm_device_proxy() const -> std::unique_ptr<sdbus::IProxy>;
+    explicit Connection(std::weak_ptr<sdbus::IConnection>, const sdbus::ObjectPath&,
+                        std::shared_ptr<Dispatcher> dispatcher = nullptr, std::shared_ptr<ProxyPool> proxies = nullptr,
+                        const std::string& modem_path = {});
+
+    [[nodiscard]] auto get_nm_device_path(const std::string& iface) const -> sdbus::ObjectPath;
+    [[nodiscard]] auto shared_nm_device_proxy() const -> std::shared_ptr<sdbus::IProxy>;
+    [[nodiscard]] auto resolved_linux_interface() const -> std::string;
+    void watch_bearer_interface() const;
+    void invalidate_nm_device() const;
     [[nodiscard]] auto get_ip_config(IPType type) const -> std::optional<IPConfig>;
+
+    using TimedTrafficStatsObserver = std::function<void(const TrafficStats&, std::chrono::steady_clock::time_point)>;
+    [[nodiscard]] auto subscribe_traffic_stats(const TimedTrafficStatsObserver& observer, uint32_t interval_ms)
+        -> Subscription;
+    [[nodiscard]] auto get_ip_config_async(IPType type) const -> std::future<std::optional<IPConfig>>;
 };
 
 } // namespace ezcellular
@@ -27,6 +27,7 @@ constexpr auto MM_IF_MODEM_TIME = MM_DBUS_INTERFACE_MODEM_TIME;
 
 /* ModemManager: Bearer objects */
 constexpr auto MM_IF_BEARER = MM_DBUS_INTERFACE_BEARER;
+constexpr auto MM_OBJ_BEARER_PREFIX = MM_DBUS_BEARER_PREFIX;
 
 /* ModemManager: SIM objects */
 constexpr auto MM_IF_SIM = MM_DBUS_INTERFACE_SIM;
@@ -0,0 +1,310 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <exception>   // std::exception_ptr
+#include <functional>  // std::function
+#include <future>      // std::future, std::promise
+#include <memory>      // std::make_shared
+#include <mutex>       // std::mutex
+#include <optional>    // std::optional
+#include <string>      // std::string
+#include <type_traits> // std::invoke_result_t, std::common_type_t
+#include <utility>     // std::move
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::*
+
+#include "any_map.h"  // sdbus_variant_map
+#include "call_metrics.h"  // CallTimer, ScopedCall
+#include "dbus_constants.h"
+#include "dbus_properties.h"  // Prop
+
+/*
+ * internal helpers for D-Bus calls, not part of the public API
+ */
+
+namespace ezcellular::DBus {
+
+/**
+ * @brief Fetch all properties of an interface, blocking (with the default method timeout).
+ * @return all properties, or an empty map if the interface is not available (or the call failed)
+ */
+inline auto get_all(sdbus::IProxy& proxy, const std::string& interface) -> sdbus_variant_map {
+    sdbus_variant_map props;
+    try {
+        ScopedCall call{interface, "GetAll"};
+        proxy.callMethod("GetAll").onInterface(DBUS_IF_PROPERTIES).withArguments(interface).storeResultsTo(props);
+    } catch (const sdbus::Error&) {
+        return {};  // e.g. interface not implemented
+    }
+    return props;
+}
+
+/**
+ * @brief Fetch all properties of an interface without blocking.
+ *
+ * Several calls can be issued back to back and are then processed by the bus in parallel.
+ * @note the reply is handled by the event loop of the connection, so don't wait for the result on that thread
+ * @return a std::future with all properties, or an empty map if the interface is not available
+ */
+inline auto get_all_async(sdbus::IProxy& proxy, const std::string& interface) -> std::future<sdbus_variant_map> {
+    auto promise = std::make_shared<std::promise<sdbus_variant_map>>();
+    auto future = promise->get_future();
+
+    auto timer = CallTimer::start(interface, "GetAll");
+    proxy.callMethodAsync("GetAll").onInterface(DBUS_IF_PROPERTIES).withArguments(interface)
+        .uponReplyInvoke([promise, timer](const sdbus::Error* err, const sdbus_variant_map& props) {
+            timer.finish(err != nullptr);
+            if (err != nullptr) {
+                promise->set_value({});  // e.g. interface not implemented
+                return;
+            }
+            promise->set_value(props);
+        });
+
+    return future;
+}
+
+/**
+ * @brief Fulfill a promise with the result of fn(), or with the exception thrown by it.
+ */
+template<typename R, typename Fn>
+void set_promise_from(std::promise<R>& promise, Fn&& fn) {
+    try {
+        if constexpr (std::is_void_v<R>) {
+            fn();
+            promise.set_value();
+        } else {
+            promise.set_value(fn());
+        }
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+/**
+ * @brief Get a property without blocking and convert it.
+ *
+ * @tparam T the expected type of the property value
+ * @param transform invoked with the value on the event loop thread, its result is the value of the future
+ * @return a std::future with the converted value, or the sdbus::Error as exception
+ */
+template<typename T, typename Fn>
+auto get_property_async(sdbus::IProxy& proxy, const std::string& interface, const std::string& name, Fn transform)
+    -> std::future<std::invoke_result_t<Fn, T>> {
+    using R = std::invoke_result_t<Fn, T>;
+    auto promise = std::make_shared<std::promise<R>>();
+    auto future = promise->get_future();
+
+    auto timer = CallTimer::start(interface, "Get");
+    proxy.callMethodAsync("Get").onInterface(DBUS_IF_PROPERTIES).withArguments(interface, name)
+        .uponReplyInvoke([promise, timer, transform = std::move(transform)](const sdbus::Error* err,
+                                                                            const sdbus::Variant& value) {
+            timer.finish(err != nullptr);
+            if (err != nullptr) {
+                promise->set_exception(std::make_exception_ptr(*err));
+                return;
+            }
+            set_promise_from(*promise, [&]() { return transform(value.get<T>()); });
+        });
+
+    return future;
+}
+
+/** @brief Get a property without blocking, see above. */
+template<typename T>
+auto get_property_async(sdbus::IProxy& proxy, const std::string& interface, const std::string& name)
+    -> std::future<T> {
+    return get_property_async<T>(proxy, interface, name, [](T value) { return value; });
+}
+
+/** @brief Get a typed property without blocking and convert it, see above. */
+template<typename T, typename Fn>
+auto get_property_async(sdbus::IProxy& proxy, const Prop<T>& prop, Fn transform)
+    -> std::future<std::invoke_result_t<Fn, T>> {
+    return get_property_async<T>(proxy, prop.interface(), prop.name(), std::move(transform));
+}
+
+/** @brief Get a typed property without blocking, see above. */
+template<typename T>
+auto get_property_async(sdbus::IProxy& proxy, const Prop<T>& prop) -> std::future<T> {
+    return get_property_async<T>(proxy, prop.interface(), prop.name());
+}
+
+/**
+ * @brief Get a typed property, blocking.
+ * @throws sdbus::Error if the call failed or the value has another type
+ */
+template<typename T>
+auto get_property(sdbus::IProxy& proxy, const Prop<T>& prop) -> T {
+    ScopedCall call{prop.interface(), "Get"};
+    return proxy.getProperty(prop.name()).onInterface(prop.interface()).template get<T>();
+}
+
+/**
+ * @brief Invoke a prepared method call without blocking and convert its results.
+ *
+ * @tparam Results the types of the return values of the method
+ * @param invoker e.g. `proxy.callMethodAsync("Foo").onInterface(...).withArguments(...)`
+ * @param transform invoked with the results on the event loop thread, its result is the value of the future
+ * @param timer measures the call for Metrics, see CallTimer::start()
+ * @return a std::future with the converted value, or the sdbus::Error as exception
+ */
+template<typename... Results, typename Fn>
+auto call_async(sdbus::AsyncMethodInvoker& invoker, Fn transform, CallTimer timer = {})
+    -> std::future<std::invoke_result_t<Fn, const Results&...>> {
+    using R = std::invoke_result_t<Fn, const Results&...>;
+    auto promise = std::make_shared<std::promise<R>>();
+    auto future = promise->get_future();
+
+    invoker.uponReplyInvoke([promise, timer, transform = std::move(transform)](const sdbus::Error* err,
+                                                                               const Results&... results) {
+        timer.finish(err != nullptr);
+        if (err != nullptr) {
+            promise->set_exception(std::make_exception_ptr(*err));
+            return;
+        }
+        set_promise_from(*promise, [&]() { return transform(results...); });
+    });
+
+    return future;
+}
+
+/**
+ * @brief Combines the results of two asynchronous calls into one promise.
+ *
+ * Pass callbacks from first() and second() to two async calls.
+ * Once both results are available, combine() is invoked on the event loop thread.
+ * If any of both fails, the promise is fulfilled with the exception instead.
+ */
+template<typename R, typename A, typename B>
+class AsyncJoin : public std::enable_shared_from_this<AsyncJoin<R, A, B>> {
+public:
+    /** @brief signature of the combining function */
+    using Combine = std::function<R(const A&, const B&)>;
+
+    /** @brief create a new join, only as std::shared_ptr */
+    static auto create(Combine combine) -> std::shared_ptr<AsyncJoin> {
+        return std::shared_ptr<AsyncJoin>{new AsyncJoin{std::move(combine)}};
+    }
+
+    /** @brief the future for the combined result */
+    auto get_future() -> std::future<R> { return promise_.get_future(); }
+
+    /**
+     * @brief callback for the first result
+     * @param timer measures the call for Metrics, see CallTimer::start()
+     */
+    auto first(CallTimer timer = {}) {
+        return [self = this->shared_from_this(), timer](const sdbus::Error* err, const A& a) {
+            timer.finish(err != nullptr);
+            std::lock_guard lock{self->mutex_};
+            self->a_ = a;
+            self->complete(err);
+        };
+    }
+
+    /** @brief callback for the second result, see first() */
+    auto second(CallTimer timer = {}) {
+        return [self = this->shared_from_this(), timer](const sdbus::Error* err, const B& b) {
+            timer.finish(err != nullptr);
+            std::lock_guard lock{self->mutex_};
+            self->b_ = b;
+            self->complete(err);
+        };
+    }
+
+private:
+    explicit AsyncJoin(Combine combine) : combine_{std::move(combine)} {}
+
+    std::mutex mutex_;
+    std::optional<A> a_;
+    std::optional<B> b_;
+    bool done_ = false;
+    std::promise<R> promise_;
+    Combine combine_;
+
+    void complete(const sdbus::Error* err) {
+        if (done_) {
+            return;  // other call failed before
+        }
+        if (err != nullptr) {
+            done_ = true;
+            promise_.set_exception(std::make_exception_ptr(*err));
+            return;
+        }
+        if (a_ && b_) {
+            done_ = true;
+            set_promise_from(promise_, [&]() { return combine_(*a_, *b_); });
+        }
+    }
+};
+
+/**
+ * @brief Get a value with the given type from a property map, or fall back to default
+ * @tparam T the expected type in the variant value
+ */
+template<typename T>
+auto value_or(const sdbus_variant_map& props, const std::string& key, const T& default_) -> T {
+    if (auto it = props.find(key); it != props.end()) {
+        return it->second.get<T>();
+    }
+    return default_;
+}
+
+/** @brief Get a typed property from a property map (e.g. from `GetAll`), or fall back to default, see above. */
+template<typename T>
+auto value_or(const sdbus_variant_map& props, const Prop<T>& prop, const std::common_type_t<T>& default_) -> T {
+    return value_or<T>(props, prop.name(), default_);
+}
+
+/**
+ * @brief Get a value that is fixed for the lifetime of a D-Bus object (e.g. the IMEI), fetching it only once.
+ * @param mutex protects value
+ * @param value the stored value, empty if not known (yet). Empty values are not stored, but fetched again.
+ * @param fetch gets the value, invoked without holding mutex
+ */
+template<typename Fetch>
+auto fetch_once(std::mutex& mutex, std::string& value, Fetch&& fetch) -> std::string {
+    {
+        std::lock_guard lock{mutex};
+        if (!value.empty()) {
+            return value;
+        }
+    }
+    auto fetched = fetch();
+    if (!fetched.empty()) {
+        std::lock_guard lock{mutex};
+        value = fetched;
+    }
+    return fetched;
+}
+
+/**
+ * @brief Asynchronous variant of fetch_once().
+ * @param owner keeps mutex and value alive until the reply
+ * @param fetch invoked with a transformation that stores the value, returns the std::future of the transformed value
+ */
+template<typename Fetch>
+auto fetch_once_async(std::shared_ptr<void> owner, std::mutex& mutex, std::string& value, Fetch&& fetch)
+    -> std::future<std::string> {
+    {
+        std::lock_guard lock{mutex};
+        if (!value.empty()) {
+            std::promise<std::string> promise;
+            promise.set_value(value);
+            return promise.get_future();
+        }
+    }
+    return fetch([owner = std::move(owner), &mutex, &value](std::string fetched) {
+        if (!fetched.empty()) {
+            std::lock_guard lock{mutex};
+            value = fetched;
+        }
+        return fetched;
+    });
+}
+
+} // namespace ezcellular::DBus
@@ -0,0 +1,216 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>       // std::array
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint32_t and friends
+#include <map>         // std::map
+#include <optional>    // std::optional
+#include <stdexcept>   // std::logic_error
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::common_type_t
+#include <utility>     // std::pair
+#include <vector>      // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::ObjectPath, sdbus::Variant
+
+#include "any_map.h"  // sdbus_variant_map
+#include "dbus_constants.h"
+
+/*
+ * typed descriptors of the D-Bus properties in use, internal, not part of the public API
+ */
+
+namespace ezcellular::DBus {
+
+/** @brief interface and name of a property, see PROPERTIES */
+struct PropertyKey {
+    const char* interface;
+    const char* name;
+};
+
+/**
+ * @brief All properties used by the library, the index of a property is its slot (see Prop).
+ *
+ * Sorted by interface, new properties can be added anywhere.
+ */
+constexpr std::array<PropertyKey, 31> PROPERTIES{{
+    // ModemManager
+    {MM_IF_MODEMMANAGER, "Version"},
+    // .Modem
+    {MM_IF_MODEM, "AccessTechnologies"},
+    {MM_IF_MODEM, "Bearers"},
+    {MM_IF_MODEM, "EquipmentIdentifier"},
+    {MM_IF_MODEM, "Manufacturer"},
+    {MM_IF_MODEM, "Model"},
+    {MM_IF_MODEM, "OwnNumbers"},
+    {MM_IF_MODEM, "PowerState"},
+    {MM_IF_MODEM, "Revision"},
+    {MM_IF_MODEM, "Sim"},
+    {MM_IF_MODEM, "State"},
+    {MM_IF_MODEM, "UnlockRequired"},
+    // .Modem.Location
+    {MM_IF_MODEM_LOCATION, "Location"},
+    // .Modem.Modem3gpp
+    {MM_IF_MODEM_MODEM3GPP, "Imei"},
+    {MM_IF_MODEM_MODEM3GPP, "OperatorCode"},
+    {MM_IF_MODEM_MODEM3GPP, "OperatorName"},
+    // .Modem.Signal
+    {MM_IF_MODEM_SIGNAL, "Lte"},
+    {MM_IF_MODEM_SIGNAL, "Nr5g"},
+    {MM_IF_MODEM_SIGNAL, "Rate"},
+    // .Bearer
+    {MM_IF_BEARER, "Connected"},
+    {MM_IF_BEARER, "Interface"},
+    {MM_IF_BEARER, "Ip4Config"},
+    {MM_IF_BEARER, "Ip6Config"},
+    {MM_IF_BEARER, "Properties"},
+    // .Sim
+    {MM_IF_SIM, "Active"},
+    {MM_IF_SIM, "Imsi"},
+    {MM_IF_SIM, "OperatorIdentifier"},
+    {MM_IF_SIM, "OperatorName"},
+    {MM_IF_SIM, "SimIdentifier"},
+    // NetworkManager .Device.Statistics
+    {NM_IF_DEVICE_STATISTICS, "RxBytes"},
+    {NM_IF_DEVICE_STATISTICS, "TxBytes"},
+}};
+
+/** @brief number of properties, i.e. of slots */
+constexpr std::size_t PROPERTY_COUNT = PROPERTIES.size();
+
+/** @brief the slot of a property, PROPERTY_COUNT if it is not in PROPERTIES */
+constexpr auto slot_of(std::string_view interface, std::string_view name) -> std::size_t {
+    for (std::size_t slot = 0; slot < PROPERTY_COUNT; ++slot) {
+        if (interface == PROPERTIES[slot].interface && name == PROPERTIES[slot].name) {
+            return slot;
+        }
+    }
+    return PROPERTY_COUNT;
+}
+
+/** @brief interface and name of each slot as std::string, built once instead of on every call */
+inline auto property_strings() -> const std::array<std::pair<std::string, std::string>, PROPERTY_COUNT>& {
+    static const auto strings = []() {
+        std::array<std::pair<std::string, std::string>, PROPERTY_COUNT> keys;
+        for (std::size_t slot = 0; slot < PROPERTY_COUNT; ++slot) {
+            keys[slot] = {PROPERTIES[slot].interface, PROPERTIES[slot].name};
+        }
+        return keys;
+    }();
+    return strings;
+}
+
+/**
+ * @brief Typed descriptor of a D-Bus property, resolved to its slot at compile time.
+ *
+ * @code
+ * constexpr Prop<int32_t> MODEM_STATE{MM_IF_MODEM, "State"};
+ * @endcode
+ * @tparam T the C++ type of the value, e.g. int32_t for the D-Bus signature `i`
+ */
+template<typename T>
+class Prop {
+public:
+    /** @brief the C++ type of the value */
+    using type = T;
+
+    /** @brief Look up the property, a constexpr descriptor of a property not in PROPERTIES doesn't compile. */
+    constexpr Prop(std::string_view interface, std::string_view name) : slot_{slot_of(interface, name)} {
+        if (slot_ == PROPERTY_COUNT) {
+            throw std::logic_error{"property missing in DBus::PROPERTIES"};
+        }
+    }
+
+    /** @brief fixed index of the property in PROPERTIES, e.g. in a PropertyCache */
+    [[nodiscard]] constexpr auto slot() const -> std::size_t { return slot_; }
+    /** @brief D-Bus interface of the property */
+    [[nodiscard]] auto interface() const -> const std::string& { return property_strings()[slot_].first; }
+    /** @brief name of the property */
+    [[nodiscard]] auto name() const -> const std::string& { return property_strings()[slot_].second; }
+
+private:
+    std::size_t slot_;
+};
+
+/** @brief one (optional) value per slot, e.g. to collect the properties of an object */
+using PropertySlots = std::array<std::optional<sdbus::Variant>, PROPERTY_COUNT>;
+
+/**
+ * @brief Copy the properties of interface (e.g. from `GetAll`) into their slots.
+ * @note slots of interface without a value in props are cleared
+ */
+inline void fill_slots(PropertySlots& slots, const std::string& interface, const sdbus_variant_map& props) {
+    for (std::size_t slot = 0; slot < PROPERTY_COUNT; ++slot) {
+        if (interface != PROPERTIES[slot].interface) {
+            continue;
+        }
+        if (auto it = props.find(PROPERTIES[slot].name); it != props.end()) {
+            slots[slot] = it->second;
+        } else {
+            slots[slot].reset();
+        }
+    }
+}
+
+/** @brief Get a typed value from its slot, or fall back to default */
+template<typename T>
+auto value_or(const PropertySlots& slots, const Prop<T>& prop, const std::common_type_t<T>& default_) -> T {
+    if (const auto& value = slots[prop.slot()]) {
+        return value->template get<T>();
+    }
+    return default_;
+}
+
+/** @brief value of .Modem.Location.Location, source -> location */
+using LocationDict = std::map<uint32_t, sdbus::Variant>;
+
+/* ModemManager */
+constexpr Prop<std::string> MM_VERSION{MM_IF_MODEMMANAGER, "Version"};
+
+/* ModemManager: Modem objects */
+constexpr Prop<uint32_t> MODEM_ACCESS_TECHNOLOGIES{MM_IF_MODEM, "AccessTechnologies"};
+constexpr Prop<std::vector<sdbus::ObjectPath>> MODEM_BEARERS{MM_IF_MODEM, "Bearers"};
+constexpr Prop<std::string> MODEM_EQUIPMENT_IDENTIFIER{MM_IF_MODEM, "EquipmentIdentifier"};
+constexpr Prop<std::string> MODEM_MANUFACTURER{MM_IF_MODEM, "Manufacturer"};
+constexpr Prop<std::string> MODEM_MODEL{MM_IF_MODEM, "Model"};
+constexpr Prop<std::vector<std::string>> MODEM_OWN_NUMBERS{MM_IF_MODEM, "OwnNumbers"};
+constexpr Prop<uint32_t> MODEM_POWER_STATE{MM_IF_MODEM, "PowerState"};
+constexpr Prop<std::string> MODEM_REVISION{MM_IF_MODEM, "Revision"};
+constexpr Prop<sdbus::ObjectPath> MODEM_SIM{MM_IF_MODEM, "Sim"};
+constexpr Prop<int32_t> MODEM_STATE{MM_IF_MODEM, "State"};
+constexpr Prop<uint32_t> MODEM_UNLOCK_REQUIRED{MM_IF_MODEM, "UnlockRequired"};
+
+constexpr Prop<LocationDict> LOCATION_LOCATION{MM_IF_MODEM_LOCATION, "Location"};
+
+constexpr Prop<std::string> MODEM3GPP_IMEI{MM_IF_MODEM_MODEM3GPP, "Imei"};
+constexpr Prop<std::string> MODEM3GPP_OPERATOR_CODE{MM_IF_MODEM_MODEM3GPP, "OperatorCode"};
+constexpr Prop<std::string> MODEM3GPP_OPERATOR_NAME{MM_IF_MODEM_MODEM3GPP, "OperatorName"};
+
+constexpr Prop<sdbus_variant_map> SIGNAL_LTE{MM_IF_MODEM_SIGNAL, "Lte"};
+constexpr Prop<sdbus_variant_map> SIGNAL_NR5G{MM_IF_MODEM_SIGNAL, "Nr5g"};
+constexpr Prop<uint32_t> SIGNAL_RATE{MM_IF_MODEM_SIGNAL, "Rate"};
+
+/* ModemManager: Bearer objects */
+constexpr Prop<bool> BEARER_CONNECTED{MM_IF_BEARER, "Connected"};
+constexpr Prop<std::string> BEARER_INTERFACE{MM_IF_BEARER, "Interface"};
+constexpr Prop<sdbus_variant_map> BEARER_IP4_CONFIG{MM_IF_BEARER, "Ip4Config"};
+constexpr Prop<sdbus_variant_map> BEARER_IP6_CONFIG{MM_IF_BEARER, "Ip6Config"};
+constexpr Prop<sdbus_variant_map> BEARER_PROPERTIES{MM_IF_BEARER, "Properties"};
+
+/* ModemManager: SIM objects */
+constexpr Prop<bool> SIM_ACTIVE{MM_IF_SIM, "Active"};
+constexpr Prop<std::string> SIM_IMSI{MM_IF_SIM, "Imsi"};
+constexpr Prop<std::string> SIM_OPERATOR_IDENTIFIER{MM_IF_SIM, "OperatorIdentifier"};
+constexpr Prop<std::string> SIM_OPERATOR_NAME{MM_IF_SIM, "OperatorName"};
+constexpr Prop<std::string> SIM_SIM_IDENTIFIER{MM_IF_SIM, "SimIdentifier"};
+
+/* NetworkManager */
+constexpr Prop<uint64_t> NM_STATS_RX_BYTES{NM_IF_DEVICE_STATISTICS, "RxBytes"};
+constexpr Prop<uint64_t> NM_STATS_TX_BYTES{NM_IF_DEVICE_STATISTICS, "TxBytes"};
+
+} // namespace ezcellular::DBus
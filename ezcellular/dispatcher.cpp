@@ -0,0 +1,109 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "dispatcher.h"
+
+#include <cstdint>  // int64_t
+#include <utility>  // std::move
+
+#include "call_metrics.h"  // DispatchMetrics
+
+namespace ezcellular {
+
+void Dispatcher::set_executor(std::shared_ptr<Executor> executor, DispatchOptions options) {
+    std::lock_guard lock{mutex_};
+    executor_ = std::move(executor);
+    options_ = options;
+}
+
+auto Dispatcher::current() const -> std::pair<std::shared_ptr<Executor>, DispatchOptions> {
+    std::lock_guard lock{mutex_};
+    return {executor_, options_};
+}
+
+auto ObserverQueue::create(std::shared_ptr<Dispatcher> dispatcher) -> std::shared_ptr<ObserverQueue> {
+    return std::shared_ptr<ObserverQueue>{new ObserverQueue{std::move(dispatcher)}};
+}
+
+ObserverQueue::~ObserverQueue() {
+    pending_.clear();
+    uncount();
+}
+
+// updates left the queue: the counted ones are the newest, so at most pending_.size() remain counted
+void ObserverQueue::uncount() {
+    if (counted_ > pending_.size()) {
+        DispatchMetrics::taken(static_cast<int64_t>(counted_ - pending_.size()));
+        counted_ = pending_.size();
+    }
+}
+
+void ObserverQueue::post(Executor::Task task) {
+    auto run_inline = [&task]() {
+        auto start = DispatchMetrics::start();
+        task();
+        DispatchMetrics::finish(start);
+    };
+    if (!dispatcher_) {
+        return run_inline();  // no executor configured: run on the D-Bus thread, like before
+    }
+
+    auto [executor, options] = dispatcher_->current();
+    if (!executor) {
+        return run_inline();
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        auto size_before = static_cast<int64_t>(pending_.size());
+        if (options.policy == OverflowPolicy::COALESCE) {
+            pending_.clear();  // only the newest update is of interest
+        } else {
+            while (!pending_.empty() && pending_.size() >= options.queue_size) {
+                pending_.pop_front();  // drop oldest
+            }
+        }
+        if (auto dropped = size_before - static_cast<int64_t>(pending_.size()); dropped > 0) {
+            DispatchMetrics::dropped(dropped);
+            uncount();
+        }
+        pending_.push_back(std::move(task));
+        if (DispatchMetrics::queued()) {
+            ++counted_;
+        }
+
+        if (scheduled_) {
+            return;  // picked up by the running drain()
+        }
+        scheduled_ = true;
+    }
+
+    executor->execute([self = shared_from_this()]() { self->drain(); });
+}
+
+void ObserverQueue::drain() {
+    while (true) {
+        Executor::Task task;
+        {
+            std::lock_guard lock{mutex_};
+            if (pending_.empty()) {
+                scheduled_ = false;
+                return;
+            }
+            task = std::move(pending_.front());
+            pending_.pop_front();
+            uncount();
+        }
+
+        auto start = DispatchMetrics::start();
+        try {
+            task();
+        } catch (...) {
+            // a failing observer must not stall its queue
+        }
+        DispatchMetrics::finish(start);
+    }
+}
+
+} // namespace ezcellular
@@ -0,0 +1,78 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <cstddef> // std::size_t
+#include <deque>   // std::deque
+#include <memory>  // std::shared_ptr
+#include <mutex>   // std::mutex
+#include <utility> // std::pair
+
+#include "executor.h"  // Executor, DispatchOptions
+
+namespace ezcellular {
+
+/**
+ * @brief Executor and queue options shared by a ModemManager and all Modems and Connections obtained from it.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class Dispatcher {
+public:
+    /** @brief replace the executor, nullptr runs callbacks on the D-Bus thread */
+    void set_executor(std::shared_ptr<Executor> executor, DispatchOptions options);
+    /** @brief the current executor (may be nullptr) and options */
+    [[nodiscard]] auto current() const -> std::pair<std::shared_ptr<Executor>, DispatchOptions>;
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<Executor> executor_;
+    DispatchOptions options_;
+};
+
+/**
+ * @brief Bounded queue of pending updates for one observer.
+ *
+ * Updates of one observer are run one after another, never in parallel, and in order.
+ * If the observer is slower than the updates arrive, old updates are dropped according to the OverflowPolicy.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class ObserverQueue : public std::enable_shared_from_this<ObserverQueue> {
+public:
+    /**
+     * @brief create a queue, only as std::shared_ptr
+     * @param dispatcher the executor to use, nullptr to always run inline
+     */
+    static auto create(std::shared_ptr<Dispatcher> dispatcher) -> std::shared_ptr<ObserverQueue>;
+
+    /** @brief drops the pending updates */
+    ~ObserverQueue();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    ObserverQueue(const ObserverQueue&) = delete;
+    ObserverQueue& operator=(const ObserverQueue&) = delete;
+    ObserverQueue(ObserverQueue&&) = delete;
+    ObserverQueue& operator=(ObserverQueue&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /** @brief queue an update, called on the D-Bus thread */
+    void post(Executor::Task task);
+
+private:
+    explicit ObserverQueue(std::shared_ptr<Dispatcher> dispatcher) : dispatcher_{std::move(dispatcher)} {}
+
+    std::shared_ptr<Dispatcher> dispatcher_;
+
+    std::mutex mutex_;  // protects the members below
+    std::deque<Executor::Task> pending_;
+    std::size_t counted_ = 0;  // newest pending updates that are counted in the metrics, see DispatchMetrics
+    bool scheduled_ = false;  // whether drain() is queued or running on the executor
+
+    void drain();
+    void uncount();  // expects mutex_ to be locked
+};
+
+} // namespace ezcellular
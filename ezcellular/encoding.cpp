@@ -0,0 +1,736 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "encoding.h"
+
+#include <cmath>   // std::isfinite, std::llround
+#include <cstring> // std::memcpy, std::memmove
+#include <limits>  // std::numeric_limits
+
+namespace ezcellular {
+
+// --- JsonWriter ---
+
+void JsonWriter::clear() noexcept {
+    size_ = 0;
+    overflow_ = false;
+    depth_ = 0;
+    has_items_ = 0;
+    after_key_ = false;
+}
+
+void JsonWriter::put(char c) {
+    if (overflow_ || size_ == capacity_) {
+        overflow_ = true;
+        return;
+    }
+    data_[size_++] = c;
+}
+
+void JsonWriter::put(std::string_view str) {
+    if (overflow_ || capacity_ - size_ < str.size()) {
+        overflow_ = true;
+        return;
+    }
+    std::memcpy(data_ + size_, str.data(), str.size());
+    size_ += str.size();
+}
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;  // the value of a key
+        return;
+    }
+    if (depth_ == 0) {
+        return;
+    }
+    auto bit = 1U << (depth_ - 1);
+    if ((has_items_ & bit) != 0) {
+        put(',');
+    }
+    has_items_ |= bit;
+}
+
+void JsonWriter::open(char bracket) {
+    separate();
+    if (depth_ == MAX_DEPTH) {
+        overflow_ = true;
+        return;
+    }
+    put(bracket);
+    ++depth_;
+    has_items_ &= ~(1U << (depth_ - 1));
+}
+
+void JsonWriter::close(char bracket) {
+    if (depth_ > 0) {
+        --depth_;
+    }
+    put(bracket);
+}
+
+void JsonWriter::begin_object() { open('{'); }
+void JsonWriter::end_object() { close('}'); }
+void JsonWriter::begin_array() { open('['); }
+void JsonWriter::end_array() { close(']'); }
+
+void JsonWriter::key(std::string_view key) {
+    string(key);
+    put(':');
+    after_key_ = true;
+}
+
+void JsonWriter::string(std::string_view value) {
+    static constexpr std::string_view HEX = "0123456789abcdef";
+    separate();
+    put('"');
+    for (auto c : value) {
+        auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put(c);
+        } else if (byte < 0x20) {
+            put("\\u00");
+            put(HEX[byte >> 4U]);
+            put(HEX[byte & 0xFU]);
+        } else {
+            put(c);  // UTF-8 is passed through
+        }
+    }
+    put('"');
+}
+
+void JsonWriter::boolean(bool value) {
+    separate();
+    put(value ? "true" : "false");
+}
+
+void JsonWriter::null() {
+    separate();
+    put("null");
+}
+
+void JsonWriter::write_double(double value) {
+    if (!std::isfinite(value)) {
+        null();
+        return;
+    }
+    separate();
+    if (overflow_) {
+        return;
+    }
+    // shortest representation that parses back to the same value
+    auto [ptr, ec] = std::to_chars(data_ + size_, data_ + capacity_, value);
+    if (ec != std::errc{}) {
+        overflow_ = true;
+        return;
+    }
+    size_ = static_cast<std::size_t>(ptr - data_);
+}
+
+// --- to_json ---
+
+static auto tech_name(Technology tech) -> std::string_view {
+    switch (tech) {
+        case Technology::GSM: return "GSM";
+        case Technology::UMTS: return "UMTS";
+        case Technology::LTE: return "LTE";
+        case Technology::NR5G: return "NR5G";
+        default: return "UNKNOWN";
+    }
+}
+
+static auto ip_type_name(IPType type) -> std::string_view {
+    switch (type) {
+        case IPType::IPV4: return "IPv4";
+        case IPType::IPV6: return "IPv6";
+        case IPType::IPV4_AND_IPV6: return "IPv4+IPv6";
+        default: return "UNKNOWN";
+    }
+}
+
+// common helper for to_json: a key and its value, if there is one
+template<typename T>
+static void maybe_number(JsonWriter& json, std::string_view key, const std::optional<T>& value) {
+    if (value) {
+        json.key(key);
+        json.number(*value);
+    }
+}
+
+void to_json(JsonWriter& json, const Signal& signal) {
+    json.begin_object();
+    json.key("tech");
+    json.string(tech_name(signal.tech));
+    maybe_number(json, "rsrp", signal.rsrp);
+    maybe_number(json, "rsrq", signal.rsrq);
+    maybe_number(json, "rssi", signal.rssi);
+    maybe_number(json, "sinr", signal.sinr);
+    json.end_object();
+}
+
+void to_json(JsonWriter& json, const Location& location) {
+    json.begin_object();
+    json.key("tech");
+    json.string(tech_name(location.tech));
+    if (!location.mcc.empty()) {
+        json.key("mcc");
+        json.string(location.mcc);
+    }
+    if (!location.mnc.empty()) {
+        json.key("mnc");
+        json.string(location.mnc);
+    }
+    maybe_number(json, "ci", location.ci);
+    maybe_number(json, "tac", location.tac);
+    json.end_object();
+}
+
+void to_json(JsonWriter& json, const CellInfo& cell) {
+    json.begin_object();
+    json.key("tech");
+    json.string(tech_name(cell.tech));
+    json.key("serving");
+    json.boolean(cell.serving);
+    maybe_number(json, "ci", cell.ci);
+    maybe_number(json, "pci", cell.pci);
+    maybe_number(json, cell.tech == Technology::NR5G ? "nrarfcn" : "earfcn", cell.arfcn);
+    if (!cell.signal.empty()) {
+        json.key("signal");
+        to_json(json, cell.signal);
+    }
+    if (!cell.location.empty()) {
+        json.key("location");
+        to_json(json, cell.location);
+    }
+    json.end_object();
+}
+
+void to_json(JsonWriter& json, const TrafficStats& stats) {
+    json.begin_object();
+    json.key("rx_bytes");
+    json.number(stats.rx_bytes);
+    json.key("tx_bytes");
+    json.number(stats.tx_bytes);
+    json.end_object();
+}
+
+void to_json(JsonWriter& json, const IPConfig& config) {
+    json.begin_object();
+    json.key("ip_type");
+    json.string(ip_type_name(config.ip_type));
+    json.key("address");
+    json.string(config.address);
+    json.key("prefix");
+    json.number(config.prefix);
+    json.key("gateway");
+    json.string(config.gateway);
+    json.key("dns1");
+    json.string(config.dns1);
+    json.key("dns2");
+    json.string(config.dns2);
+    json.end_object();
+}
+
+// --- BinaryWriter ---
+
+static constexpr uint32_t WIRE_VARINT = 0;
+static constexpr uint32_t WIRE_BYTES = 2;
+
+static auto varint_size(uint64_t value) -> std::size_t {
+    std::size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7U;
+        ++size;
+    }
+    return size;
+}
+
+void BinaryWriter::clear() noexcept {
+    size_ = 0;
+    overflow_ = false;
+}
+
+void BinaryWriter::varint(uint64_t value) {
+    if (overflow_ || capacity_ - size_ < varint_size(value)) {
+        overflow_ = true;
+        return;
+    }
+    while (value >= 0x80) {
+        data_[size_++] = static_cast<uint8_t>(value | 0x80U);
+        value >>= 7U;
+    }
+    data_[size_++] = static_cast<uint8_t>(value);
+}
+
+void BinaryWriter::signed_varint(int64_t value) {
+    // zigzag: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+    varint((static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void BinaryWriter::field_varint(uint32_t tag, uint64_t value) {
+    varint(tag << 3U | WIRE_VARINT);
+    varint(value);
+}
+
+void BinaryWriter::field_signed(uint32_t tag, int64_t value) {
+    varint(tag << 3U | WIRE_VARINT);
+    signed_varint(value);
+}
+
+void BinaryWriter::field_bytes(uint32_t tag, std::string_view bytes) {
+    varint(tag << 3U | WIRE_BYTES);
+    this->bytes(bytes);
+}
+
+void BinaryWriter::bytes(std::string_view bytes) {
+    varint(bytes.size());
+    if (overflow_ || capacity_ - size_ < bytes.size()) {
+        overflow_ = true;
+        return;
+    }
+    std::memcpy(data_ + size_, bytes.data(), bytes.size());
+    size_ += bytes.size();
+}
+
+auto BinaryWriter::begin_message() -> std::size_t {
+    auto mark = size_;
+    varint(0);  // placeholder for the length, usually one byte is enough
+    return mark;
+}
+
+void BinaryWriter::end_message(std::size_t mark) {
+    if (overflow_) {
+        return;
+    }
+    auto length = size_ - mark - 1;
+    auto extra = varint_size(length) - 1;
+    if (extra > 0) {
+        if (capacity_ - size_ < extra) {
+            overflow_ = true;
+            return;
+        }
+        std::memmove(data_ + mark + 1 + extra, data_ + mark + 1, length);
+    }
+    auto end = size_ + extra;
+    size_ = mark;
+    varint(length);
+    size_ = end;
+}
+
+// --- BinaryReader ---
+
+auto BinaryReader::varint(uint64_t& value) -> bool {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos_ == size_) {
+            return false;
+        }
+        auto byte = data_[pos_++];
+        value |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0) {
+            return true;
+        }
+    }
+    return false;  // too long
+}
+
+auto BinaryReader::signed_varint(int64_t& value) -> bool {
+    uint64_t zigzag{};
+    if (!varint(zigzag)) {
+        return false;
+    }
+    value = static_cast<int64_t>(zigzag >> 1U) ^ -static_cast<int64_t>(zigzag & 1U);
+    return true;
+}
+
+auto BinaryReader::bytes(std::string_view& bytes) -> bool {
+    uint64_t length{};
+    if (!varint(length) || length > size_ - pos_) {
+        return false;
+    }
+    bytes = {reinterpret_cast<const char*>(data_ + pos_), static_cast<std::size_t>(length)};
+    pos_ += static_cast<std::size_t>(length);
+    return true;
+}
+
+auto BinaryReader::field(uint32_t& tag, Wire& wire) -> bool {
+    uint64_t key{};
+    if (!varint(key) || key >> 3U > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    auto type = key & 0x7U;
+    if (type != WIRE_VARINT && type != WIRE_BYTES) {
+        return false;
+    }
+    tag = static_cast<uint32_t>(key >> 3U);
+    wire = static_cast<Wire>(type);
+    return true;
+}
+
+auto BinaryReader::skip(Wire wire) -> bool {
+    if (wire == Wire::VARINT) {
+        uint64_t ignored{};
+        return varint(ignored);
+    }
+    std::string_view ignored;
+    return bytes(ignored);
+}
+
+auto BinaryReader::message(BinaryReader& part) -> bool {
+    std::string_view bytes;
+    if (!this->bytes(bytes)) {
+        return false;
+    }
+    part = BinaryReader{reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size()};
+    return true;
+}
+
+// --- DeltaEncoder ---
+
+using Fields = DeltaBaselines::Fields;
+
+// signal values are sent in steps of 0.01 dB
+static constexpr double SIGNAL_SCALE = 100.0;
+
+// common helper: a numeric field as difference to its baseline, computed unsigned so that it wraps (not overflows)
+static void delta_field(BinaryWriter& out, Fields& baselines, uint32_t tag, int64_t value) {
+    auto delta = static_cast<uint64_t>(value) - static_cast<uint64_t>(baselines[tag]);
+    out.field_signed(tag, static_cast<int64_t>(delta));
+    baselines[tag] = value;
+}
+
+template<typename T>
+static void maybe_delta_field(BinaryWriter& out, Fields& baselines, uint32_t tag, const std::optional<T>& value) {
+    if (value) {
+        delta_field(out, baselines, tag, static_cast<int64_t>(*value));
+    }
+}
+
+static void maybe_signal_field(BinaryWriter& out, Fields& baselines, uint32_t tag,
+                               const std::optional<double>& value) {
+    if (value && std::isfinite(*value)) {
+        delta_field(out, baselines, tag, std::llround(*value * SIGNAL_SCALE));
+    }
+}
+
+// the fields of the types, shared by the records and the nested parts of CellInfo
+static void signal_fields(BinaryWriter& out, Fields& baselines, const Signal& signal) {
+    out.field_varint(1, static_cast<uint64_t>(signal.tech));
+    maybe_signal_field(out, baselines, 2, signal.rsrp);
+    maybe_signal_field(out, baselines, 3, signal.rsrq);
+    maybe_signal_field(out, baselines, 4, signal.rssi);
+    maybe_signal_field(out, baselines, 5, signal.sinr);
+}
+
+static void location_fields(BinaryWriter& out, Fields& baselines, const Location& location) {
+    out.field_varint(1, static_cast<uint64_t>(location.tech));
+    if (!location.mcc.empty()) {
+        out.field_bytes(2, location.mcc);
+    }
+    if (!location.mnc.empty()) {
+        out.field_bytes(3, location.mnc);
+    }
+    maybe_delta_field(out, baselines, 4, location.ci);
+    maybe_delta_field(out, baselines, 5, location.tac);
+}
+
+static void cell_fields(BinaryWriter& out, DeltaBaselines& baselines, const CellInfo& cell) {
+    out.field_varint(1, static_cast<uint64_t>(cell.tech));
+    out.field_varint(2, cell.serving ? 1 : 0);
+    maybe_delta_field(out, baselines.cell, 3, cell.ci);
+    maybe_delta_field(out, baselines.cell, 4, cell.pci);
+    maybe_delta_field(out, baselines.cell, 5, cell.arfcn);
+    if (!cell.signal.empty()) {
+        out.varint(6U << 3U | WIRE_BYTES);
+        auto part = out.begin_message();
+        signal_fields(out, baselines.cell_signal, cell.signal);
+        out.end_message(part);
+    }
+    if (!cell.location.empty()) {
+        out.varint(7U << 3U | WIRE_BYTES);
+        auto part = out.begin_message();
+        location_fields(out, baselines.cell_location, cell.location);
+        out.end_message(part);
+    }
+}
+
+// common helper for encode: write a record completely (advancing the baselines) or not at all (keeping them)
+template<typename WriteFields>
+static auto record(BinaryWriter& out, DeltaBaselines& baselines, const WriteFields& write_fields) -> bool {
+    if (out.overflow()) {
+        return false;
+    }
+    auto saved = baselines;  // restored if the record doesn't fit, the decoder never sees it
+    auto mark = out.begin_message();
+    write_fields();
+    out.end_message(mark);
+    if (out.overflow()) {
+        baselines = saved;
+        out.truncate(mark);
+        return false;
+    }
+    return true;
+}
+
+auto DeltaEncoder::encode(BinaryWriter& out, const Signal& signal) -> bool {
+    return record(out, baselines_, [&]() { signal_fields(out, baselines_.signal, signal); });
+}
+
+auto DeltaEncoder::encode(BinaryWriter& out, const Location& location) -> bool {
+    return record(out, baselines_, [&]() { location_fields(out, baselines_.location, location); });
+}
+
+auto DeltaEncoder::encode(BinaryWriter& out, const CellInfo& cell) -> bool {
+    return record(out, baselines_, [&]() { cell_fields(out, baselines_, cell); });
+}
+
+auto DeltaEncoder::encode(BinaryWriter& out, const TrafficStats& stats) -> bool {
+    return record(out, baselines_, [&]() {
+        // counters only grow, except on a reset (which is a single negative difference)
+        delta_field(out, baselines_.traffic, 1, static_cast<int64_t>(stats.rx_bytes));
+        delta_field(out, baselines_.traffic, 2, static_cast<int64_t>(stats.tx_bytes));
+    });
+}
+
+auto DeltaEncoder::encode(BinaryWriter& out, const IPConfig& config) -> bool {
+    return record(out, baselines_, [&]() {
+        out.field_varint(1, static_cast<uint64_t>(config.ip_type));
+        out.field_bytes(2, config.address);
+        out.field_varint(3, config.prefix);
+        out.field_bytes(4, config.gateway);
+        out.field_bytes(5, config.dns1);
+        out.field_bytes(6, config.dns2);
+    });
+}
+
+// --- DeltaDecoder ---
+
+// common helper: the next field of a record, returns false at its end (or on malformed input, see ok)
+static auto next_field(BinaryReader& in, uint32_t& tag, BinaryReader::Wire& wire, bool& ok) -> bool {
+    if (in.at_end()) {
+        return false;
+    }
+    ok = in.field(tag, wire);
+    return ok;
+}
+
+// common helper: a numeric field from the difference to its baseline
+static auto read_delta(BinaryReader& in, Fields& baselines, uint32_t tag, int64_t& value) -> bool {
+    int64_t delta{};
+    if (tag >= baselines.size() || !in.signed_varint(delta)) {
+        return false;
+    }
+    baselines[tag] = static_cast<int64_t>(static_cast<uint64_t>(baselines[tag]) + static_cast<uint64_t>(delta));
+    value = baselines[tag];
+    return true;
+}
+
+template<typename T>
+static auto read_delta(BinaryReader& in, Fields& baselines, uint32_t tag, std::optional<T>& value) -> bool {
+    int64_t raw{};
+    if (!read_delta(in, baselines, tag, raw)) {
+        return false;
+    }
+    value = static_cast<T>(raw);
+    return true;
+}
+
+static auto read_signal_value(BinaryReader& in, Fields& baselines, uint32_t tag, std::optional<double>& value)
+    -> bool {
+    int64_t raw{};
+    if (!read_delta(in, baselines, tag, raw)) {
+        return false;
+    }
+    value = static_cast<double>(raw) / SIGNAL_SCALE;
+    return true;
+}
+
+template<typename Enum>
+static auto read_enum(BinaryReader& in, Enum& value) -> bool {
+    uint64_t raw{};
+    if (!in.varint(raw)) {
+        return false;
+    }
+    value = static_cast<Enum>(raw);
+    return true;
+}
+
+static auto read_string(BinaryReader& in, std::string& value) -> bool {
+    std::string_view bytes;
+    if (!in.bytes(bytes)) {
+        return false;
+    }
+    value.assign(bytes);
+    return true;
+}
+
+// the fields of the types, shared by the records and the nested parts of CellInfo
+static auto signal_fields(BinaryReader& in, Fields& baselines, Signal& signal) -> bool {
+    signal = Signal{};
+    uint32_t tag{};
+    BinaryReader::Wire wire{};
+    bool ok = true;
+    while (next_field(in, tag, wire, ok)) {
+        using Wire = BinaryReader::Wire;
+        bool read = false;
+        if (tag == 1 && wire == Wire::VARINT) {
+            read = read_enum(in, signal.tech);
+        } else if (tag == 2 && wire == Wire::VARINT) {
+            read = read_signal_value(in, baselines, tag, signal.rsrp);
+        } else if (tag == 3 && wire == Wire::VARINT) {
+            read = read_signal_value(in, baselines, tag, signal.rsrq);
+        } else if (tag == 4 && wire == Wire::VARINT) {
+            read = read_signal_value(in, baselines, tag, signal.rssi);
+        } else if (tag == 5 && wire == Wire::VARINT) {
+            read = read_signal_value(in, baselines, tag, signal.sinr);
+        } else {
+            read = in.skip(wire);
+        }
+        if (!read) {
+            return false;
+        }
+    }
+    return ok;
+}
+
+static auto location_fields(BinaryReader& in, Fields& baselines, Location& location) -> bool {
+    location = Location{};
+    uint32_t tag{};
+    BinaryReader::Wire wire{};
+    bool ok = true;
+    while (next_field(in, tag, wire, ok)) {
+        using Wire = BinaryReader::Wire;
+        bool read = false;
+        if (tag == 1 && wire == Wire::VARINT) {
+            read = read_enum(in, location.tech);
+        } else if (tag == 2 && wire == Wire::BYTES) {
+            read = read_string(in, location.mcc);
+        } else if (tag == 3 && wire == Wire::BYTES) {
+            read = read_string(in, location.mnc);
+        } else if (tag == 4 && wire == Wire::VARINT) {
+            read = read_delta(in, baselines, tag, location.ci);
+        } else if (tag == 5 && wire == Wire::VARINT) {
+            read = read_delta(in, baselines, tag, location.tac);
+        } else {
+            read = in.skip(wire);
+        }
+        if (!read) {
+            return false;
+        }
+    }
+    return ok;
+}
+
+auto DeltaDecoder::decode(BinaryReader& in, Signal& signal) -> bool {
+    BinaryReader record{nullptr, 0};
+    return in.message(record) && signal_fields(record, baselines_.signal, signal);
+}
+
+auto DeltaDecoder::decode(BinaryReader& in, Location& location) -> bool {
+    BinaryReader record{nullptr, 0};
+    return in.message(record) && location_fields(record, baselines_.location, location);
+}
+
+auto DeltaDecoder::decode(BinaryReader& in, CellInfo& cell) -> bool {
+    BinaryReader record{nullptr, 0};
+    if (!in.message(record)) {
+        return false;
+    }
+    cell = CellInfo{};
+    uint32_t tag{};
+    BinaryReader::Wire wire{};
+    bool ok = true;
+    while (next_field(record, tag, wire, ok)) {
+        using Wire = BinaryReader::Wire;
+        bool read = false;
+        BinaryReader part{nullptr, 0};
+        if (tag == 1 && wire == Wire::VARINT) {
+            read = read_enum(record, cell.tech);
+        } else if (tag == 2 && wire == Wire::VARINT) {
+            uint64_t serving{};
+            read = record.varint(serving);
+            cell.serving = serving != 0;
+        } else if (tag == 3 && wire == Wire::VARINT) {
+            read = read_delta(record, baselines_.cell, tag, cell.ci);
+        } else if (tag == 4 && wire == Wire::VARINT) {
+            read = read_delta(record, baselines_.cell, tag, cell.pci);
+        } else if (tag == 5 && wire == Wire::VARINT) {
+            read = read_delta(record, baselines_.cell, tag, cell.arfcn);
+        } else if (tag == 6 && wire == Wire::BYTES) {
+            read = record.message(part) && signal_fields(part, baselines_.cell_signal, cell.signal);
+        } else if (tag == 7 && wire == Wire::BYTES) {
+            read = record.message(part) && location_fields(part, baselines_.cell_location, cell.location);
+        } else {
+            read = record.skip(wire);
+        }
+        if (!read) {
+            return false;
+        }
+    }
+    return ok;
+}
+
+auto DeltaDecoder::decode(BinaryReader& in, TrafficStats& stats) -> bool {
+    BinaryReader record{nullptr, 0};
+    if (!in.message(record)) {
+        return false;
+    }
+    stats = TrafficStats{};
+    uint32_t tag{};
+    BinaryReader::Wire wire{};
+    bool ok = true;
+    while (next_field(record, tag, wire, ok)) {
+        int64_t value{};
+        bool read = false;
+        if ((tag == 1 || tag == 2) && wire == BinaryReader::Wire::VARINT) {
+            read = read_delta(record, baselines_.traffic, tag, value);
+            (tag == 1 ? stats.rx_bytes : stats.tx_bytes) = static_cast<uint64_t>(value);
+        } else {
+            read = record.skip(wire);
+        }
+        if (!read) {
+            return false;
+        }
+    }
+    return ok;
+}
+
+auto DeltaDecoder::decode(BinaryReader& in, IPConfig& config) -> bool {
+    BinaryReader record{nullptr, 0};
+    if (!in.message(record)) {
+        return false;
+    }
+    config = IPConfig{};
+    uint32_t tag{};
+    BinaryReader::Wire wire{};
+    bool ok = true;
+    while (next_field(record, tag, wire, ok)) {
+        using Wire = BinaryReader::Wire;
+        bool read = false;
+        if (tag == 1 && wire == Wire::VARINT) {
+            read = read_enum(record, config.ip_type);
+        } else if (tag == 2 && wire == Wire::BYTES) {
+            read = read_string(record, config.address);
+        } else if (tag == 3 && wire == Wire::VARINT) {
+            uint64_t prefix{};
+            read = record.varint(prefix);
+            config.prefix = static_cast<uint32_t>(prefix);
+        } else if (tag == 4 && wire == Wire::BYTES) {
+            read = read_string(record, config.gateway);
+        } else if (tag == 5 && wire == Wire::BYTES) {
+            read = read_string(record, config.dns1);
+        } else if (tag == 6 && wire == Wire::BYTES) {
+            read = read_string(record, config.dns2);
+        } else {
+            read = record.skip(wire);
+        }
+        if (!read) {
+            return false;
+        }
+    }
+    return ok;
+}
+
+} // namespace ezcellular
@@ -0,0 +1,299 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>       // std::array
+#include <charconv>    // std::to_chars
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint8_t and friends
+#include <string_view> // std::string_view
+#include <type_traits> // std::is_integral_v
+
+#include "structs.h"
+
+namespace ezcellular {
+
+/*
+ * Serialization of samples into a caller-provided buffer, without heap allocations.
+ *
+ * JSON (see JsonWriter) uses the keys of the ostream helpers (see helpers.h);
+ * the binary format (see DeltaEncoder) is a compact stream of records for the uplink.
+ */
+
+/**
+ * @brief Writes JSON into a fixed buffer.
+ *
+ * Commas are inserted automatically. If the buffer is too small, writing stops and overflow() is set,
+ * the output is incomplete then.
+ *
+ * @code
+ * std::array<char, 512> buffer{};
+ * JsonWriter json{buffer};
+ * to_json(json, modem.signal());
+ * if (!json.overflow()) {
+ *     send(json.view());
+ * }
+ * @endcode
+ */
+class JsonWriter {
+public:
+    /** @brief max. nesting of objects and arrays */
+    static constexpr std::size_t MAX_DEPTH = 32;
+
+    /** @brief Write into data, which must outlive the writer. */
+    JsonWriter(char* data, std::size_t capacity) noexcept : data_{data}, capacity_{capacity} {}
+    /** @brief Write into buffer, which must outlive the writer. */
+    template<std::size_t N>
+    explicit JsonWriter(std::array<char, N>& buffer) noexcept : JsonWriter{buffer.data(), N} {}
+
+    /** @brief the JSON written so far (not null-terminated) */
+    [[nodiscard]] auto view() const -> std::string_view { return {data_, size_}; }
+    /** @brief number of chars written */
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+    /** @brief whether the buffer was too small (or the nesting too deep) */
+    [[nodiscard]] auto overflow() const -> bool { return overflow_; }
+    /** @brief Start over, e.g. for the next sample. */
+    void clear() noexcept;
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+    /** @brief the key of the next value, only valid in an object */
+    void key(std::string_view key);
+
+    /** @brief a string value, escaped as needed */
+    void string(std::string_view value);
+    void boolean(bool value);
+    void null();
+    /** @brief a number value, non-finite floating point values are written as null */
+    template<typename T>
+    void number(T value) {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "use boolean()");
+        if constexpr (std::is_integral_v<T>) {
+            separate();
+            write_integer(value);
+        } else {
+            write_double(static_cast<double>(value));
+        }
+    }
+
+private:
+    char* data_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+    bool overflow_ = false;
+    std::size_t depth_ = 0;
+    uint32_t has_items_ = 0;  // bit per depth: whether the object/array has got a value already
+    bool after_key_ = false;
+
+    void put(char c);
+    void put(std::string_view str);
+    void separate();  // the comma, if needed
+    void open(char bracket);
+    void close(char bracket);
+    void write_double(double value);
+
+    template<typename T>
+    void write_integer(T value) {
+        if (overflow_) {
+            return;
+        }
+        auto [ptr, ec] = std::to_chars(data_ + size_, data_ + capacity_, value);
+        if (ec != std::errc{}) {
+            overflow_ = true;
+            return;
+        }
+        size_ = static_cast<std::size_t>(ptr - data_);
+    }
+};
+
+/** @brief Write signal as JSON object, values that were not reported are left out. */
+void to_json(JsonWriter& json, const Signal& signal);
+/** @brief Write location as JSON object, values that were not reported are left out. */
+void to_json(JsonWriter& json, const Location& location);
+/** @brief Write cell as JSON object, values that were not reported are left out. */
+void to_json(JsonWriter& json, const CellInfo& cell);
+/** @brief Write stats as JSON object. */
+void to_json(JsonWriter& json, const TrafficStats& stats);
+/** @brief Write config as JSON object. */
+void to_json(JsonWriter& json, const IPConfig& config);
+
+/**
+ * @brief Writes protobuf-style fields into a fixed buffer, see DeltaEncoder.
+ *
+ * Each field is a key (`tag << 3 | wire type`) followed by a LEB128 varint (wire type 0)
+ * or a varint length plus that many bytes (wire type 2).
+ * If the buffer is too small, writing stops and overflow() is set, the output is incomplete then.
+ */
+class BinaryWriter {
+public:
+    /** @brief Write into data, which must outlive the writer. */
+    BinaryWriter(uint8_t* data, std::size_t capacity) noexcept : data_{data}, capacity_{capacity} {}
+    /** @brief Write into buffer, which must outlive the writer. */
+    template<std::size_t N>
+    explicit BinaryWriter(std::array<uint8_t, N>& buffer) noexcept : BinaryWriter{buffer.data(), N} {}
+
+    /** @brief the bytes written so far */
+    [[nodiscard]] auto data() const -> const uint8_t* { return data_; }
+    /** @brief number of bytes written */
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+    /** @brief whether the buffer was too small */
+    [[nodiscard]] auto overflow() const -> bool { return overflow_; }
+    /** @brief Start over, e.g. for the next batch of records. */
+    void clear() noexcept;
+    /** @brief Drop the bytes after size (e.g. a mark of begin_message()), overflow() stays set. */
+    void truncate(std::size_t size) noexcept { size_ = size < size_ ? size : size_; }
+
+    void varint(uint64_t value);
+    /** @brief a signed value, zigzag encoded so that small negative values stay short */
+    void signed_varint(int64_t value);
+    /** @brief a varint length plus the bytes, without a key, see BinaryReader::bytes() */
+    void bytes(std::string_view bytes);
+    void field_varint(uint32_t tag, uint64_t value);
+    void field_signed(uint32_t tag, int64_t value);
+    void field_bytes(uint32_t tag, std::string_view bytes);
+
+    /**
+     * @brief Start a length-delimited part, e.g. a record or a nested message.
+     * @return the mark to pass to end_message()
+     */
+    [[nodiscard]] auto begin_message() -> std::size_t;
+    /** @brief Write the length of the part started at mark. */
+    void end_message(std::size_t mark);
+
+private:
+    uint8_t* data_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+    bool overflow_ = false;
+};
+
+/**
+ * @brief Reads what a BinaryWriter wrote, without copying.
+ *
+ * All functions return false on truncated or malformed input.
+ */
+class BinaryReader {
+public:
+    /** @brief wire type of a field */
+    enum class Wire : uint8_t {
+        VARINT = 0, ///< a varint
+        BYTES = 2,  ///< a varint length plus bytes
+    };
+
+    /** @brief Read from data, which must outlive the reader. */
+    BinaryReader(const uint8_t* data, std::size_t size) noexcept : data_{data}, size_{size} {}
+
+    /** @brief whether everything was read */
+    [[nodiscard]] auto at_end() const -> bool { return pos_ == size_; }
+    /** @brief number of bytes read so far */
+    [[nodiscard]] auto position() const -> std::size_t { return pos_; }
+
+    [[nodiscard]] auto varint(uint64_t& value) -> bool;
+    [[nodiscard]] auto signed_varint(int64_t& value) -> bool;
+    /** @brief a varint length plus bytes, bytes refers to the input */
+    [[nodiscard]] auto bytes(std::string_view& bytes) -> bool;
+    /** @brief the key of the next field */
+    [[nodiscard]] auto field(uint32_t& tag, Wire& wire) -> bool;
+    /** @brief Skip the value of a field, e.g. of an unknown tag. */
+    [[nodiscard]] auto skip(Wire wire) -> bool;
+    /** @brief Read a length-delimited part (see BinaryWriter::begin_message()) into part. */
+    [[nodiscard]] auto message(BinaryReader& part) -> bool;
+
+private:
+    const uint8_t* data_;
+    std::size_t size_;
+    std::size_t pos_ = 0;
+};
+
+/// @private the previous value of each numeric field, the same on the encoding and the decoding side
+struct DeltaBaselines {
+    static constexpr std::size_t FIELDS = 8;  // > highest tag
+    using Fields = std::array<int64_t, FIELDS>;
+
+    Fields signal{};
+    Fields location{};
+    Fields cell{};
+    Fields cell_signal{};
+    Fields cell_location{};
+    Fields traffic{};
+};
+
+/**
+ * @brief Encodes samples into a compact stream of records, each value as difference to the previous sample.
+ *
+ * Every record is a varint length followed by fields keyed by tag (see BinaryWriter).
+ * Values that were not reported are left out. Numbers are sent as zigzag varint difference to the last value
+ * of the same field and type (0 initially), so a steady signal costs about two bytes per value.
+ * Signal values are sent in steps of 0.01 dB.
+ *
+ * | type         | tag: field                                                                 |
+ * |--------------|----------------------------------------------------------------------------|
+ * | Signal       | 1: tech, 2: rsrp, 3: rsrq, 4: rssi, 5: sinr                                |
+ * | Location     | 1: tech, 2: mcc (bytes), 3: mnc (bytes), 4: ci, 5: tac                     |
+ * | CellInfo     | 1: tech, 2: serving, 3: ci, 4: pci, 5: arfcn, 6: Signal, 7: Location       |
+ * | TrafficStats | 1: rx_bytes, 2: tx_bytes                                                   |
+ * | IPConfig     | 1: ip_type, 2: address, 3: prefix, 4: gateway, 5: dns1, 6: dns2 (no delta) |
+ *
+ * `tech`, `serving` and `ip_type` are plain varints. Signal and Location of a CellInfo are nested records
+ * with their own baselines. The stream must be decoded in order by a DeltaDecoder.
+ *
+ * A record is written completely or not at all: if it doesn't fit, encode() returns false, drops the partial
+ * record from out and leaves the baselines as they were. So out only holds complete records that the decoder
+ * can follow, and the same sample has to be encoded again into the next buffer (skipping it is fine as well).
+ *
+ * @code
+ * std::array<uint8_t, 1024> buffer{};
+ * BinaryWriter out{buffer};
+ * DeltaEncoder encoder;
+ * for (const auto& cell : modem.cell_info()) {
+ *     if (!encoder.encode(out, cell)) {
+ *         send(out.data(), out.size());  // full: send the complete records, then start over
+ *         out.clear();
+ *         encoder.encode(out, cell);
+ *     }
+ * }
+ * @endcode
+ * @note the stream can't be decoded if the encoder (or decoder) is reset on one side only
+ */
+class DeltaEncoder {
+public:
+    /** @brief Append a record for the sample, false if it doesn't fit (or out overflowed already): nothing written. */
+    auto encode(BinaryWriter& out, const Signal& signal) -> bool;
+    auto encode(BinaryWriter& out, const Location& location) -> bool;
+    auto encode(BinaryWriter& out, const CellInfo& cell) -> bool;
+    auto encode(BinaryWriter& out, const TrafficStats& stats) -> bool;
+    auto encode(BinaryWriter& out, const IPConfig& config) -> bool;
+
+    /** @brief Forget the previous samples, e.g. at the start of a new stream. */
+    void reset() { baselines_ = {}; }
+
+private:
+    DeltaBaselines baselines_;
+};
+
+/**
+ * @brief Decodes the records of a DeltaEncoder, in order.
+ *
+ * Unknown tags are skipped. Each decode() returns false on truncated or malformed input.
+ */
+class DeltaDecoder {
+public:
+    /** @brief Read the next record into the sample, which is overwritten. */
+    [[nodiscard]] auto decode(BinaryReader& in, Signal& signal) -> bool;
+    [[nodiscard]] auto decode(BinaryReader& in, Location& location) -> bool;
+    [[nodiscard]] auto decode(BinaryReader& in, CellInfo& cell) -> bool;
+    [[nodiscard]] auto decode(BinaryReader& in, TrafficStats& stats) -> bool;
+    [[nodiscard]] auto decode(BinaryReader& in, IPConfig& config) -> bool;
+
+    /** @brief Forget the previous samples, e.g. at the start of a new stream. */
+    void reset() { baselines_ = {}; }
+
+private:
+    DeltaBaselines baselines_;
+};
+
+} // namespace ezcellular
@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "executor.h"
+
+#include <algorithm> // std::max
+#include <utility>   // std::move
+
+namespace ezcellular {
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::size_t threads) {
+    threads = std::max<std::size_t>(threads, 1);
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this]() { run(); });
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPoolExecutor::execute(Task task) {
+    {
+        std::lock_guard lock{mutex_};
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPoolExecutor::run() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock lock{mutex_};
+            cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;  // stopped and all done
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        try {
+            task();
+        } catch (...) {
+            // nobody to report to, keep the thread alive
+        }
+    }
+}
+
+} // namespace ezcellular
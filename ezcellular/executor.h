@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <condition_variable> // std::condition_variable
+#include <cstddef>    // std::size_t
+#include <deque>      // std::deque
+#include <functional> // std::function
+#include <mutex>      // std::mutex
+#include <thread>     // std::thread
+#include <vector>     // std::vector
+
+namespace ezcellular {
+
+/**
+ * @brief Runs the observer callbacks, see ModemManager::set_executor().
+ *
+ * Implement this interface to run the callbacks on an existing thread pool or event loop.
+ */
+class Executor {
+public:
+    /** @brief a task to run */
+    using Task = std::function<void()>;
+
+    virtual ~Executor() = default;
+
+    /**
+     * @brief Run the task, now or later, on any thread.
+     * @note called on the D-Bus event loop thread, so it should not block
+     */
+    virtual void execute(Task task) = 0;
+};
+
+/**
+ * @brief Runs the tasks directly on the calling thread, i.e. the D-Bus event loop thread.
+ */
+class InlineExecutor final : public Executor {
+public:
+    /** @brief run task immediately */
+    void execute(Task task) override { task(); }
+};
+
+/**
+ * @brief Runs the tasks on a fixed number of background threads.
+ *
+ * Exceptions thrown by tasks are discarded.
+ */
+class ThreadPoolExecutor final : public Executor {
+public:
+    /**
+     * @brief Start the threads.
+     * @param threads number of threads, at least 1
+     */
+    explicit ThreadPoolExecutor(std::size_t threads = 1);
+    /** @brief Stop the threads after all queued tasks are done. */
+    ~ThreadPoolExecutor() override;
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor(ThreadPoolExecutor&&) = delete;
+    ThreadPoolExecutor& operator=(ThreadPoolExecutor&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /** @brief queue the task for one of the threads */
+    void execute(Task task) override;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+
+    void run();
+};
+
+/**
+ * @brief What to do if an observer can't keep up with the updates.
+ */
+enum class OverflowPolicy {
+    DROP_OLDEST, ///< drop the oldest pending update if the queue is full
+    COALESCE,    ///< only keep the newest pending update, the queue size is ignored
+};
+
+/**
+ * @brief Options for the queue of each observer, see ModemManager::set_executor().
+ */
+struct DispatchOptions {
+    std::size_t queue_size = 16;                      ///< max. number of pending updates per observer
+    OverflowPolicy policy = OverflowPolicy::DROP_OLDEST; ///< what to do if the queue is full
+};
+
+} // namespace ezcellular
@@ -11,12 +11,23 @@
 #pragma once
 
 // IWYU pragma: begin_exports
+#include "cell_scanner.h"
 #include "connection.h"
+#include "encoding.h"
 #include "exception.h"
 #include "enums.h"
+#include "executor.h"
+#include "filters.h"
 #include "helpers.h"
+#include "metrics.h"
 #include "modem.h"
+#include "modem_health.h"
 #include "modem_manager.h"
+#include "network_clock.h"
+#include "recorder.h"
+#include "shared_state.h"
 #include "sim.h"
 #include "structs.h"
+#include "subscription.h"
+#include "traffic_source.h"
 // IWYU pragma: end_exports
@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <chrono>  // std::chrono::milliseconds
+#include <cmath>   // std::abs
+#include <cstdint> // uint64_t
+
+namespace ezcellular {
+
+/**
+ * @brief Threshold for one metric, see SignalFilter.
+ *
+ * A change exceeds it if the value moved by more than `absolute`,
+ * or by more than `relative` times the last delivered value. Both 0 disables the threshold.
+ */
+struct Deadband {
+    double absolute = 0.0; ///< absolute change, e.g. 2.0 dB
+    double relative = 0.0; ///< change as fraction of the last delivered value, e.g. 0.1 for 10 %
+
+    /// whether any threshold is set
+    [[nodiscard]] auto enabled() const -> bool { return absolute > 0.0 || relative > 0.0; }
+
+    /// whether the change from last to current exceeds the threshold
+    [[nodiscard]] auto exceeded(double last, double current) const -> bool {
+        auto delta = std::abs(current - last);
+        return (absolute > 0.0 && delta > absolute) || (relative > 0.0 && delta > relative * std::abs(last));
+    }
+};
+
+/**
+ * @brief Which updates Modem::observe_signal() delivers.
+ *
+ * An update is delivered if any metric with a Deadband exceeds it, relative to the last delivered update,
+ * or if a metric with a Deadband appears or disappears. Metrics without a Deadband are not compared.
+ * Without any Deadband, every update is delivered.
+ */
+struct SignalFilter {
+    Deadband rsrp; ///< see Signal::rsrp
+    Deadband rsrq; ///< see Signal::rsrq
+    Deadband rssi; ///< see Signal::rssi
+    Deadband sinr; ///< see Signal::sinr
+    std::chrono::milliseconds min_interval{0}; ///< drop updates arriving sooner after the last delivered one
+};
+
+/**
+ * @brief Which updates Modem::observe_location() delivers.
+ */
+struct LocationFilter {
+    bool key_change_only = false; ///< only deliver the update if any identifier (e.g. ci, tac) changed
+    std::chrono::milliseconds min_interval{0}; ///< drop updates arriving sooner after the last delivered one
+};
+
+/**
+ * @brief Which updates Connection::observe_traffic_stats() delivers.
+ */
+struct TrafficStatsFilter {
+    uint64_t min_delta_bytes = 0; ///< only deliver if RX or TX moved by at least this many bytes, 0 for every update
+    std::chrono::milliseconds min_interval{0}; ///< drop updates arriving sooner after the last delivered one
+};
+
+} // namespace ezcellular
@@ -5,9 +5,9 @@
 #include "helpers.h"
 
 #include <cstdint>  // uint32_t, ...
-#include <memory>   // std::shared_ptr
 #include <optional> // std::optional
 #include <string>   // std::string, operator<<
+#include <vector>   // std::vector
 
 #include "enums.h"
 
@@ -78,6 +78,43 @@ auto operator<<(std::ostream& os, const LockState& state) -> std::ostream& {
     return os;
 }
 
+using StateChangeReason = Modem::StateChangeReason;
+auto operator<<(std::ostream& os, const StateChangeReason& reason) -> std::ostream& {
+    switch (reason) {
+        case StateChangeReason::USER_REQUESTED: os << "USER_REQUESTED"; break;
+        case StateChangeReason::SUSPEND: os << "SUSPEND"; break;
+        case StateChangeReason::FAILURE: os << "FAILURE"; break;
+        default: os << "UNKNOWN"; break;
+    }
+    return os;
+}
+
+auto operator<<(std::ostream& os, const Health& health) -> std::ostream& {
+    switch (health) {
+        case Health::DOWN: os << "DOWN"; break;
+        case Health::LOCKED: os << "LOCKED"; break;
+        case Health::SEARCHING: os << "SEARCHING"; break;
+        case Health::DEGRADED: os << "DEGRADED"; break;
+        case Health::REGISTERED: os << "REGISTERED"; break;
+        case Health::CONNECTED: os << "CONNECTED"; break;
+    }
+    return os;
+}
+
+auto operator<<(std::ostream& os, const HealthReason& reason) -> std::ostream& {
+    switch (reason) {
+        case HealthReason::STATE_CHANGED: os << "STATE_CHANGED"; break;
+        case HealthReason::USER_REQUESTED: os << "USER_REQUESTED"; break;
+        case HealthReason::SUSPEND: os << "SUSPEND"; break;
+        case HealthReason::FAILURE: os << "FAILURE"; break;
+        case HealthReason::SIGNAL_LOST: os << "SIGNAL_LOST"; break;
+        case HealthReason::SIGNAL_RESTORED: os << "SIGNAL_RESTORED"; break;
+        case HealthReason::BEARER_CONNECTED: os << "BEARER_CONNECTED"; break;
+        case HealthReason::BEARER_DISCONNECTED: os << "BEARER_DISCONNECTED"; break;
+    }
+    return os;
+}
+
 /* ------- structs ------- */
 
 /**
@@ -98,130 +135,79 @@ static auto join_string(const std::vector<std::string>& parts, const std::string
     return concated.erase(concated.length() - delim.length(), delim.length()); // remove last delim
 }
 
-auto operator<<(std::ostream& os, const SignalBase* sq)->std::ostream& {
+auto operator<<(std::ostream& os, const Signal& sq) -> std::ostream& {
     os << R"("signal": )";
 
-    if (sq == nullptr) {
+    if (sq.empty()) {
         os << "null";
         return os;
     }
 
-    // concat values
-    // assumes that all values are doubles!!
     std::vector<std::string> parts;
-    for (const auto& [key, value] : *sq) {
-        if (key != "tech") {
-            parts.emplace_back(std::string{"\""} + key + "\": " + std::to_string(std::any_cast<double>(value)));
+    auto maybe_add = [&parts](const char* key, const std::optional<double>& value) {
+        if (value) {
+            parts.emplace_back(std::string{"\""} + key + "\": " + std::to_string(*value));
         }
-    }
-    os << "{" << join_string(parts) << "}";
-    return os;
-}
+    };
+    maybe_add("rsrp", sq.rsrp);
+    maybe_add("rsrq", sq.rsrq);
+    maybe_add("rssi", sq.rssi);
+    maybe_add("sinr", sq.sinr);
 
-auto operator<<(std::ostream& os, const Signal& sq) -> std::ostream& {
-    os << sq.get();
+    os << "{" << join_string(parts) << "}";
     return os;
 }
 
-auto operator<<(std::ostream& os, const LocationBase* loc) -> std::ostream& {
+auto operator<<(std::ostream& os, const Location& loc) -> std::ostream& {
     os << R"("location": )";
 
-    if (loc == nullptr) {
+    if (loc.empty()) {
         os << "null";
         return os;
     }
 
     std::vector<std::string> parts;
 
-    if (loc->has_key("mcc")) {
-        parts.push_back(R"("mcc": ")" + loc->mcc() + '"');
+    if (!loc.mcc.empty()) {
+        parts.push_back(R"("mcc": ")" + loc.mcc + '"');
     }
-    if (loc->has_key("mnc")) {
-        parts.push_back(R"("mnc": ")" + loc->mnc() + '"');
+    if (!loc.mnc.empty()) {
+        parts.push_back(R"("mnc": ")" + loc.mnc + '"');
     }
-    if (loc->has_key("ci")) {
-        parts.push_back(R"("ci": )" + std::to_string(loc->ci()));
+    if (loc.ci) {
+        parts.push_back(R"("ci": )" + std::to_string(*loc.ci));
     }
-
-    switch (loc->tech()) {
-        case Technology::LTE:
-        case Technology::NR5G: {
-                auto lte_nr = static_cast<const LocationLTE&>(*loc); // both compatible
-                if (lte_nr.has_key("tac")) {
-                    parts.push_back(R"("tac": )" + std::to_string(lte_nr.tac()));
-                }
-                break;
-            }
-        default:
-            break;
+    if (loc.tac) {
+        parts.push_back(R"("tac": )" + std::to_string(*loc.tac));
     }
 
     os << "{" << join_string(parts) << "}";
     return os;
 }
 
-auto operator<<(std::ostream& os, const Location& loc) -> std::ostream& {
-    os << loc.get();
-    return os;
-}
-
-auto operator<<(std::ostream& os, const CellInfoBase* ci) -> std::ostream& {
+auto operator<<(std::ostream& os, const CellInfo& ci) -> std::ostream& {
     os << "\"cell_info\": ";
 
-    if (ci == nullptr) {
-        os << "null";
-        return os;
-    }
-
     // common
-    os << "{\n  \"serving\": " << std::boolalpha << ci->serving();
-
-    switch (ci->tech()) {
-        case Technology::LTE: {
-                auto lte = static_cast<const CellInfoLTE&>(*ci);
-                if (lte.signal()) {
-                    os << ",\n  " << lte.signal();
-                }
-                if (lte.location()) {
-                    os << ",\n  " << lte.location();
-                }
-                if (lte.has_key("pci")) {
-                    os << ",\n  \"pci\": " << lte.pci();
-                }
-                if (lte.has_key("earfcn")) {
-                    os << ",\n  \"earfcn\": " << lte.earfcn();
-                }
-                break;
-            }
-        case Technology::NR5G: {
-                auto nr = static_cast<const CellInfoNR5G&>(*ci);
-                if (nr.signal()) {
-                    os << ",\n  " << nr.signal();
-                }
-                if (nr.location()) {
-                    os << ",\n  " << nr.location();
-                }
-                if (nr.has_key("pci")) {
-                    os << ",\n  \"pci\": " << nr.pci();
-                }
-                if (nr.has_key("nrarfcn")) {
-                    os << ",\n  \"nrarfcn\": " << nr.nrarfcn();
-                }
-                break;
-            }
-        default:
-            break;
+    os << "{\n  \"serving\": " << std::boolalpha << ci.serving;
+
+    if (!ci.signal.empty()) {
+        os << ",\n  " << ci.signal;
+    }
+    if (!ci.location.empty()) {
+        os << ",\n  " << ci.location;
+    }
+    if (ci.pci) {
+        os << ",\n  \"pci\": " << *ci.pci;
+    }
+    if (ci.arfcn) {
+        os << ",\n  " << (ci.tech == Technology::NR5G ? "\"nrarfcn\"" : "\"earfcn\"") << ": " << *ci.arfcn;
     }
 
     os << "}";
     return os;
 }
 
-auto operator<<(std::ostream& os, const CellInfo& ci) -> std::ostream& {
-    os << ci.get();
-    return os;
-}
-
 auto operator<<(std::ostream& os, const IPConfig& ipconfig) -> std::ostream& {
     os << R"({"address": ")" << ipconfig.address << "/" << ipconfig.prefix << R"(", )"
         << R"("gateway": ")" << ipconfig.gateway << R"(", )"
@@ -234,4 +220,9 @@ auto operator<<(std::ostream& os, const TrafficStats& stats) -> std::ostream& {
     return os;
 }
 
+auto operator<<(std::ostream& os, const TrafficRate& rate) -> std::ostream& {
+    os << "{\"rx_bytes_per_sec\": " << rate.rx_bytes_per_sec << ", \"tx_bytes_per_sec\": " << rate.tx_bytes_per_sec << "}";
+    return os;
+}
+
 } // namespace ezcellular
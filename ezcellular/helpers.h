@@ -6,6 +6,7 @@
 
 #include "enums.h"
 #include "modem.h"
+#include "modem_health.h"
 #include "structs.h"
 
 #include <ostream>  // std::ostream
@@ -21,16 +22,18 @@ auto operator<<(std::ostream&, const IPType&) -> std::ostream&;
 auto operator<<(std::ostream&, const Modem::ModemState&) -> std::ostream&;
 auto operator<<(std::ostream&, const Modem::PowerState&) -> std::ostream&;
 auto operator<<(std::ostream&, const Modem::LockState&) -> std::ostream&;
+auto operator<<(std::ostream&, const Modem::StateChangeReason&) -> std::ostream&;
+
+auto operator<<(std::ostream&, const Health&) -> std::ostream&;
+auto operator<<(std::ostream&, const HealthReason&) -> std::ostream&;
 
 // structs
-auto operator<<(std::ostream&, const SignalBase*) -> std::ostream& ;
 auto operator<<(std::ostream&, const Signal&) -> std::ostream&;
-auto operator<<(std::ostream&, const LocationBase*) -> std::ostream&;
 auto operator<<(std::ostream&, const Location&) -> std::ostream&;
-auto operator<<(std::ostream&, const CellInfoBase*) -> std::ostream&;
 auto operator<<(std::ostream&, const CellInfo&) -> std::ostream&;
 
 auto operator<<(std::ostream&, const IPConfig&) -> std::ostream&;
 auto operator<<(std::ostream&, const TrafficStats&) -> std::ostream&;
+auto operator<<(std::ostream&, const TrafficRate&) -> std::ostream&;
 
 } // namespace ezcellular
@@ -0,0 +1,119 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>       // std::array
+#include <chrono>      // std::chrono
+#include <cstddef>     // std::size_t
+#include <cstdint>     // int64_t
+#include <optional>    // std::optional
+#include <string_view> // std::string_view
+
+#include "structs.h"  // NetworkTime
+
+/*
+ * ISO-8601 parsing without iostreams or locales, internal, not part of the public API
+ */
+
+namespace ezcellular {
+
+/** @brief days since 1970-01-01 of a date in the proleptic Gregorian calendar, see H. Hinnant's `days_from_civil` */
+constexpr auto days_from_civil(int64_t year, unsigned month, unsigned day) -> int64_t {
+    year -= month <= 2 ? 1 : 0;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const auto year_of_era = static_cast<unsigned>(year - era * 400);                   // [0, 399]
+    const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+/**
+ * @brief Parse an ISO-8601 date and time, as reported by ModemManager, e.g. `2023-06-01T14:00:00+02:00`.
+ *
+ * Accepts `YYYY-MM-DDTHH:MM:SS`, optionally followed by a fraction of seconds and `Z` or an offset
+ * `+HH`, `+HHMM` or `+HH:MM`. A time without offset is taken as UTC.
+ * @return the time (NetworkTime::received is left empty), or an empty optional if str is no such time
+ */
+inline auto parse_iso8601(std::string_view str) -> std::optional<NetworkTime> {
+    std::size_t pos = 0;
+    // exactly count digits
+    auto number = [&](std::size_t count, unsigned& value) {
+        value = 0;
+        for (std::size_t i = 0; i < count; ++i, ++pos) {
+            if (pos == str.size() || str[pos] < '0' || str[pos] > '9') {
+                return false;
+            }
+            value = value * 10 + static_cast<unsigned>(str[pos] - '0');
+        }
+        return true;
+    };
+    auto skip = [&](char c) {
+        if (pos < str.size() && str[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    };
+
+    unsigned year{}, month{}, day{}, hour{}, minute{}, second{};  // NOLINT(*-isolate-declaration)
+    if (!number(4, year) || !skip('-') || !number(2, month) || !skip('-') || !number(2, day)
+        || !(skip('T') || skip(' ')) || !number(2, hour) || !skip(':') || !number(2, minute) || !skip(':')
+        || !number(2, second)) {
+        return {};
+    }
+    static constexpr std::array<unsigned, 12> DAYS_IN_MONTH{31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (month < 1 || month > 12 || day < 1 || day > DAYS_IN_MONTH[month - 1] || (month == 2 && day == 29 && !leap)
+        || hour > 23 || minute > 59 || second > 60) {
+        return {};
+    }
+
+    // fraction of seconds, up to ns
+    std::chrono::nanoseconds fraction{0};
+    if (skip('.') || skip(',')) {
+        int64_t scale = 100'000'000;
+        std::size_t digits = 0;
+        for (; pos < str.size() && str[pos] >= '0' && str[pos] <= '9'; ++pos, ++digits) {
+            fraction += std::chrono::nanoseconds{(str[pos] - '0') * scale};
+            scale /= 10;
+        }
+        if (digits == 0) {
+            return {};
+        }
+    }
+
+    NetworkTime time{};
+    if (skip('Z')) {
+        time.utc_offset = std::chrono::minutes{0};
+    } else if (pos < str.size() && (str[pos] == '+' || str[pos] == '-')) {
+        int sign = str[pos++] == '-' ? -1 : 1;
+        unsigned offset_hours{}, offset_minutes{};  // NOLINT(*-isolate-declaration)
+        if (!number(2, offset_hours)) {
+            return {};
+        }
+        if (pos < str.size()) {
+            skip(':');
+            if (!number(2, offset_minutes)) {
+                return {};
+            }
+        }
+        if (offset_hours > 23 || offset_minutes > 59) {
+            return {};
+        }
+        time.utc_offset = std::chrono::minutes{sign * static_cast<int>(offset_hours * 60 + offset_minutes)};
+    }
+    if (pos != str.size()) {
+        return {};  // trailing characters
+    }
+
+    auto days = days_from_civil(year, month, day);
+    std::chrono::seconds local{days * 86400 + hour * 3600 + minute * 60 + second};
+    auto utc = local - time.utc_offset.value_or(std::chrono::minutes{0});
+    time.utc = std::chrono::system_clock::time_point{
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(utc + fraction)};
+    return time;
+}
+
+} // namespace ezcellular
@@ -0,0 +1,68 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "location_decoder.h"
+
+#include <algorithm> // std::all_of
+#include <array>     // std::array
+#include <string>    // std::string
+
+#include <ModemManager/ModemManager.h>  // MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI
+
+namespace ezcellular {
+
+auto LocationDecoder::decode(Technology tech, const std::map<uint32_t, sdbus::Variant>& location_dict) -> Location {
+    auto it = location_dict.find(MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI); // cell info
+    if (it == location_dict.end()) {
+        return {};  // empty location
+    }
+    return decode_lac_ci(tech, it->second.get<std::string>());
+}
+
+// common helper for decode_lac_ci: whether str consists of min..max decimal digits
+static auto is_digits(std::string_view str, size_t min, size_t max) -> bool {
+    return str.size() >= min && str.size() <= max
+           && std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+auto LocationDecoder::decode_lac_ci(Technology tech, std::string_view lac_ci) -> Location {
+    if (tech != Technology::LTE && tech != Technology::NR5G) {
+        return {};  // not supported yet
+    }
+
+    // split into the 5 fields, without copying
+    std::array<std::string_view, 5> fields{};  // MCC, MNC, LAC, CI, TAC
+    size_t n_fields = 0;
+    for (;;) {
+        auto comma = lac_ci.find(',');
+        if (n_fields == fields.size()) {
+            return {};  // too many fields
+        }
+        fields[n_fields++] = lac_ci.substr(0, comma);
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        lac_ci.remove_prefix(comma + 1);
+    }
+    if (n_fields != fields.size()) {
+        return {};  // parsing failed
+    }
+
+    // parse, the LAC is not used for LTE/NR
+    auto ci = parse_hex<uint64_t>(fields[3]);  // the NCI of NR has 36 bits
+    auto tac = parse_hex(fields[4]);
+    if (!is_digits(fields[0], 3, 3) || !is_digits(fields[1], 2, 3) || !ci || !tac) {
+        return {};  // parsing failed
+    }
+
+    Location loc{};
+    loc.tech = tech;
+    loc.mcc = fields[0];
+    loc.mnc = fields[1];
+    loc.ci = ci;
+    loc.tac = tac;
+    return loc;
+}
+
+} // namespace ezcellular
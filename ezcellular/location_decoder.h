@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <atomic>      // std::atomic
+#include <cstdint>     // uint32_t
+#include <map>         // std::map
+#include <string_view> // std::string_view
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::Variant
+
+#include "enums.h"    // Technology
+#include "structs.h"  // Location
+
+namespace ezcellular {
+
+/**
+ * @brief Decodes `.Modem.Location` updates, without any bus call of its own.
+ *
+ * The access technology needed for decoding is kept current by feeding the `AccessTechnologies` updates
+ * of the same modem into set_technology(), e.g. from the PropertiesChanged signal that carries them anyway.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class LocationDecoder {
+public:
+    /** @param tech the access technology at the time the decoder is set up */
+    explicit LocationDecoder(Technology tech) : state_{pack(tech, false)} {}
+
+    /** @brief update the access technology, e.g. from a signal */
+    void set_technology(Technology tech) { state_.store(pack(tech, true), std::memory_order_relaxed); }
+    /**
+     * @brief Set the access technology read when subscribing, unless set_technology() was called meanwhile.
+     *
+     * The updates are subscribed before the value is read, so that none is lost in between;
+     * an update that arrived while reading is newer than the value read.
+     */
+    void set_initial_technology(Technology tech) {
+        auto current = state_.load(std::memory_order_relaxed);
+        while (!updated(current) && !state_.compare_exchange_weak(current, pack(tech, false),
+                                                                  std::memory_order_relaxed)) {
+        }
+    }
+    /** @brief the access technology used for decoding */
+    [[nodiscard]] auto technology() const -> Technology {
+        return static_cast<Technology>(state_.load(std::memory_order_relaxed) >> 1);
+    }
+
+    /** @brief decode a `.Modem.Location` dictionary with the current access technology */
+    [[nodiscard]] auto decode(const std::map<uint32_t, sdbus::Variant>& location_dict) const -> Location {
+        return decode(technology(), location_dict);
+    }
+
+    /** @brief decode a `.Modem.Location` dictionary, an empty Location if there is none or it is not supported */
+    static auto decode(Technology tech, const std::map<uint32_t, sdbus::Variant>& location_dict) -> Location;
+
+    /**
+     * @brief decode the 3GPP LAC/CI location string, i.e. "MCC,MNC,LAC,CI,TAC" (LAC, CI and TAC in hex)
+     * @return the Location, empty if tech is not supported or the string is malformed
+     */
+    static auto decode_lac_ci(Technology tech, std::string_view lac_ci) -> Location;
+
+private:
+    // the technology, shifted left by one, and whether it came from set_technology() in the lowest bit
+    std::atomic<uint32_t> state_;
+
+    static constexpr auto pack(Technology tech, bool updated) -> uint32_t {
+        return (static_cast<uint32_t>(tech) << 1) | (updated ? 1U : 0U);
+    }
+    static constexpr auto updated(uint32_t state) -> bool { return (state & 1U) != 0; }
+};
+
+} // namespace ezcellular
@@ -0,0 +1,323 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "metrics.h"
+
+#include <algorithm>     // std::lower_bound, std::max
+#include <array>         // std::array
+#include <atomic>        // std::atomic
+#include <chrono>        // std::chrono
+#include <map>           // std::map
+#include <functional>    // std::hash
+#include <memory>        // std::unique_ptr
+#include <mutex>         // std::mutex
+#include <sstream>       // std::ostringstream
+#include <string_view>   // std::string_view
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::pair
+
+#include "call_metrics.h"  // CallTimer, DispatchMetrics
+
+namespace ezcellular {
+
+namespace {
+
+std::atomic<bool> metrics_enabled{false};
+
+// the counters of a thread are spread over a fixed number of shards, so that threads rarely share a cache line
+constexpr std::size_t SHARDS = 16;
+
+auto shard_index() -> std::size_t {
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+auto bucket_of(std::chrono::steady_clock::duration elapsed) -> std::size_t {
+    std::chrono::duration<double> seconds = elapsed;
+    const auto& bounds = LatencyHistogram::BOUNDS_SEC;
+    // lower bound: a value equal to a bound is in its bucket (le = less or equal)
+    return static_cast<std::size_t>(std::lower_bound(bounds.begin(), bounds.end(), seconds.count()) - bounds.begin());
+}
+
+// a LatencyHistogram (plus error count) that is updated without locking
+class ShardedHistogram {
+public:
+    void record(std::chrono::steady_clock::duration elapsed, bool error) {
+        auto& shard = shards_[shard_index()];
+        shard.buckets[bucket_of(elapsed)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum_ns.fetch_add(static_cast<uint64_t>(std::chrono::nanoseconds{elapsed}.count()),
+                               std::memory_order_relaxed);
+        if (error) {
+            shard.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // add up all shards
+    [[nodiscard]] auto collect(uint64_t& errors) const -> LatencyHistogram {
+        LatencyHistogram histogram{};
+        uint64_t sum_ns = 0;
+        errors = 0;
+        for (const auto& shard : shards_) {
+            for (std::size_t i = 0; i < histogram.buckets.size(); ++i) {
+                auto count = shard.buckets[i].load(std::memory_order_relaxed);
+                histogram.buckets[i] += count;
+                histogram.count += count;
+            }
+            sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+            errors += shard.errors.load(std::memory_order_relaxed);
+        }
+        histogram.sum_sec = static_cast<double>(sum_ns) / 1e9;
+        return histogram;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::BOUNDS_SEC.size() + 1> buckets{};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> errors{0};
+    };
+    std::array<Shard, SHARDS> shards_{};
+};
+
+ShardedHistogram dispatch_histogram;
+std::atomic<int64_t> queue_depth{0};
+std::atomic<int64_t> max_queue_depth{0};
+std::atomic<uint64_t> dropped_updates{0};
+
+} // namespace
+
+/**
+ * @brief The metrics of one D-Bus method, registered on first use and never removed.
+ */
+class CallSite {
+public:
+    CallSite(std::string interface, std::string member)
+        : interface_{std::move(interface)}, member_{std::move(member)} {}
+
+    /** @brief the site of interface and member, created if needed */
+    static auto get(std::string_view interface, std::string_view member) -> CallSite*;
+    /** @brief all sites, sorted by interface and member */
+    static auto all() -> std::vector<CallMetrics>;
+
+    void record(std::chrono::steady_clock::duration elapsed, bool error) { histogram_.record(elapsed, error); }
+
+private:
+    std::string interface_;
+    std::string member_;
+    ShardedHistogram histogram_;
+
+    using Registry = std::map<std::pair<std::string, std::string>, std::unique_ptr<CallSite>>;
+    static auto registry() -> std::pair<std::mutex&, Registry&>;
+};
+
+auto CallSite::registry() -> std::pair<std::mutex&, Registry&> {
+    static std::mutex mutex;
+    static Registry sites;
+    return {mutex, sites};
+}
+
+namespace {
+
+// the views refer to the strings of the CallSite, which is never removed
+using CallSiteKey = std::pair<std::string_view, std::string_view>;
+
+struct CallSiteKeyHash {
+    auto operator()(const CallSiteKey& key) const noexcept -> std::size_t {
+        auto hash = std::hash<std::string_view>{}(key.first);
+        return hash ^ (std::hash<std::string_view>{}(key.second) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+    }
+};
+
+} // namespace
+
+auto CallSite::get(std::string_view interface, std::string_view member) -> CallSite* {
+    // each thread remembers the sites it used, so the registry is only locked on the first call of each method;
+    // the lookup doesn't allocate, most sites are resolved just once anyway (see CallSiteRef)
+    thread_local std::unordered_map<CallSiteKey, CallSite*, CallSiteKeyHash> cache;
+    if (auto it = cache.find({interface, member}); it != cache.end()) {
+        return it->second;
+    }
+
+    auto [mutex, sites] = registry();
+    std::lock_guard lock{mutex};
+    auto& site = sites[{std::string{interface}, std::string{member}}];
+    if (!site) {
+        site = std::make_unique<CallSite>(std::string{interface}, std::string{member});
+    }
+    cache.emplace(CallSiteKey{site->interface_, site->member_}, site.get());
+    return site.get();
+}
+
+// --- CallSiteRef ---
+
+auto CallSiteRef::get() -> CallSite* {
+    auto* site = site_.load(std::memory_order_acquire);
+    if (site == nullptr) {
+        site = CallSite::get(interface_, member_);  // racing threads get the same site
+        site_.store(site, std::memory_order_release);
+    }
+    return site;
+}
+
+auto CallSite::all() -> std::vector<CallMetrics> {
+    std::vector<CallMetrics> calls;
+    auto [mutex, sites] = registry();
+    std::lock_guard lock{mutex};
+    calls.reserve(sites.size());
+    for (const auto& [key, site] : sites) {
+        CallMetrics metrics{};
+        metrics.interface = site->interface_;
+        metrics.member = site->member_;
+        metrics.latency = site->histogram_.collect(metrics.errors);
+        metrics.calls = metrics.latency.count;
+        calls.push_back(std::move(metrics));
+    }
+    return calls;  // sorted by the map
+}
+
+// --- CallTimer ---
+
+auto CallTimer::start(CallSiteRef& site) -> CallTimer {
+    CallTimer timer{};
+    if (metrics_enabled.load(std::memory_order_relaxed)) {
+        timer.site_ = site.get();
+        timer.start_ = std::chrono::steady_clock::now();
+    }
+    return timer;
+}
+
+auto CallTimer::start(std::string_view interface, std::string_view member) -> CallTimer {
+    CallTimer timer{};
+    if (metrics_enabled.load(std::memory_order_relaxed)) {
+        timer.site_ = CallSite::get(interface, member);
+        timer.start_ = std::chrono::steady_clock::now();
+    }
+    return timer;
+}
+
+void CallTimer::finish(bool error) const {
+    if (site_ != nullptr) {
+        site_->record(std::chrono::steady_clock::now() - start_, error);
+    }
+}
+
+// --- DispatchMetrics ---
+
+auto DispatchMetrics::start() -> std::chrono::steady_clock::time_point {
+    if (!metrics_enabled.load(std::memory_order_relaxed)) {
+        return {};
+    }
+    return std::chrono::steady_clock::now();
+}
+
+void DispatchMetrics::finish(std::chrono::steady_clock::time_point start) {
+    if (start != std::chrono::steady_clock::time_point{}) {
+        dispatch_histogram.record(std::chrono::steady_clock::now() - start, false);
+    }
+}
+
+// only updates queued while enabled are counted, the queues remember how many of theirs are
+auto DispatchMetrics::queued() -> bool {
+    if (!metrics_enabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    auto depth = queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto max = max_queue_depth.load(std::memory_order_relaxed);
+    while (depth > max && !max_queue_depth.compare_exchange_weak(max, depth, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+void DispatchMetrics::taken(int64_t count) {
+    queue_depth.fetch_sub(count, std::memory_order_relaxed);
+}
+
+void DispatchMetrics::dropped(int64_t count) {
+    if (metrics_enabled.load(std::memory_order_relaxed)) {
+        dropped_updates.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+    }
+}
+
+// --- Metrics ---
+
+void Metrics::enable(bool enabled) {
+    metrics_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto Metrics::enabled() -> bool {
+    return metrics_enabled.load(std::memory_order_relaxed);
+}
+
+auto Metrics::snapshot() -> MetricsSnapshot {
+    MetricsSnapshot snapshot{};
+    snapshot.calls = CallSite::all();
+    uint64_t errors{};
+    snapshot.dispatch = dispatch_histogram.collect(errors);
+    snapshot.queue_depth = static_cast<uint64_t>(std::max<int64_t>(queue_depth.load(std::memory_order_relaxed), 0));
+    snapshot.max_queue_depth = static_cast<uint64_t>(max_queue_depth.load(std::memory_order_relaxed));
+    snapshot.dropped_updates = dropped_updates.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+// common helper for to_prometheus: histogram samples with cumulative buckets
+static void write_histogram(std::ostringstream& out, const std::string& name, const std::string& labels,
+                            const LatencyHistogram& histogram) {
+    auto sep = labels.empty() ? "" : ",";
+    uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < histogram.buckets.size(); ++i) {
+        cumulative += histogram.buckets[i];
+        out << name << "_bucket{" << labels << sep << "le=\"";
+        if (i < LatencyHistogram::BOUNDS_SEC.size()) {
+            out << LatencyHistogram::BOUNDS_SEC[i];
+        } else {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative << '\n';
+    }
+    auto braces = labels.empty() ? std::string{} : "{" + labels + "}";
+    out << name << "_sum" << braces << ' ' << histogram.sum_sec << '\n';
+    out << name << "_count" << braces << ' ' << histogram.count << '\n';
+}
+
+auto Metrics::to_prometheus(const std::string& prefix) -> std::string {
+    auto snap = snapshot();
+    std::ostringstream out;
+
+    out << "# HELP " << prefix << "_dbus_calls_total Finished D-Bus calls\n"
+        << "# TYPE " << prefix << "_dbus_calls_total counter\n";
+    for (const auto& call : snap.calls) {
+        out << prefix << "_dbus_calls_total{interface=\"" << call.interface << "\",member=\"" << call.member
+            << "\"} " << call.calls << '\n';
+    }
+    out << "# HELP " << prefix << "_dbus_errors_total Failed D-Bus calls\n"
+        << "# TYPE " << prefix << "_dbus_errors_total counter\n";
+    for (const auto& call : snap.calls) {
+        out << prefix << "_dbus_errors_total{interface=\"" << call.interface << "\",member=\"" << call.member
+            << "\"} " << call.errors << '\n';
+    }
+    out << "# HELP " << prefix << "_dbus_call_seconds Time until the D-Bus reply\n"
+        << "# TYPE " << prefix << "_dbus_call_seconds histogram\n";
+    for (const auto& call : snap.calls) {
+        write_histogram(out, prefix + "_dbus_call_seconds",
+                        "interface=\"" + call.interface + "\",member=\"" + call.member + "\"", call.latency);
+    }
+
+    out << "# HELP " << prefix << "_observer_dispatch_seconds Run time of the observer callbacks\n"
+        << "# TYPE " << prefix << "_observer_dispatch_seconds histogram\n";
+    write_histogram(out, prefix + "_observer_dispatch_seconds", {}, snap.dispatch);
+    out << "# HELP " << prefix << "_observer_queue_depth Updates queued for observers\n"
+        << "# TYPE " << prefix << "_observer_queue_depth gauge\n"
+        << prefix << "_observer_queue_depth " << snap.queue_depth << '\n'
+        << "# HELP " << prefix << "_observer_queue_depth_max Highest number of updates queued for observers\n"
+        << "# TYPE " << prefix << "_observer_queue_depth_max gauge\n"
+        << prefix << "_observer_queue_depth_max " << snap.max_queue_depth << '\n'
+        << "# HELP " << prefix << "_observer_dropped_total Updates dropped by the overflow policy\n"
+        << "# TYPE " << prefix << "_observer_dropped_total counter\n"
+        << prefix << "_observer_dropped_total " << snap.dropped_updates << '\n';
+
+    return out.str();
+}
+
+} // namespace ezcellular
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>   // std::array
+#include <cstddef> // std::size_t
+#include <cstdint> // uint64_t
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+namespace ezcellular {
+
+/**
+ * @brief Latency distribution, see Metrics.
+ */
+struct LatencyHistogram {
+    /** @brief upper bounds of the buckets in seconds, the last bucket (+Inf) is implicit */
+    static constexpr std::array<double, 16> BOUNDS_SEC{
+        0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+        0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 10.0,
+    };
+
+    std::array<uint64_t, BOUNDS_SEC.size() + 1> buckets{}; ///< number of values per bucket (not cumulative)
+    uint64_t count = 0;   ///< number of values
+    double sum_sec = 0.0; ///< sum of all values in seconds
+};
+
+/**
+ * @brief Statistics of one D-Bus method, see Metrics.
+ *
+ * Property reads and writes are reported as member `Get`/`Set` of the property's interface.
+ */
+struct CallMetrics {
+    std::string interface;    ///< D-Bus interface, e.g. `org.freedesktop.ModemManager1.Modem`
+    std::string member;       ///< method, e.g. `GetCellInfo`
+    uint64_t calls = 0;       ///< number of finished calls, including failed ones
+    uint64_t errors = 0;      ///< number of failed calls
+    LatencyHistogram latency; ///< time until the reply, i.e. how long a blocking call blocked
+};
+
+/**
+ * @brief Point-in-time copy of all metrics, see Metrics::snapshot().
+ */
+struct MetricsSnapshot {
+    std::vector<CallMetrics> calls;   ///< per D-Bus method, sorted by interface and member
+    LatencyHistogram dispatch;        ///< run time of the observer callbacks
+    uint64_t queue_depth = 0;         ///< updates queued for observers while enabled, see ModemManager::set_executor()
+    uint64_t max_queue_depth = 0;     ///< highest queue_depth so far
+    uint64_t dropped_updates = 0;     ///< updates dropped by the OverflowPolicy
+};
+
+/**
+ * @brief Opt-in instrumentation of the D-Bus calls and the observer dispatching of the library.
+ *
+ * Disabled by default, which costs a single relaxed atomic load per call.
+ * Once enabled, each OS thread updates its own cache-line aligned counters without locking;
+ * they are only added up by snapshot().
+ *
+ * @code
+ * Metrics::enable();
+ * // ...
+ * std::cout << Metrics::to_prometheus();
+ * @endcode
+ */
+class Metrics {
+public:
+    /** @brief Start (or stop) collecting, the collected metrics are kept. */
+    static void enable(bool enabled = true);
+    /** @brief whether metrics are collected */
+    [[nodiscard]] static auto enabled() -> bool;
+
+    /** @brief the current values */
+    [[nodiscard]] static auto snapshot() -> MetricsSnapshot;
+    /**
+     * @brief the current values in the Prometheus text exposition format
+     * @param prefix of all metric names
+     */
+    [[nodiscard]] static auto to_prometheus(const std::string& prefix = "ezcellular") -> std::string;
+};
+
+} // namespace ezcellular
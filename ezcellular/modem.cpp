@@ -5,19 +5,32 @@
 #include "modem.h"
 
 #include <algorithm> // std::any_of
-#include <array>     // std::array
-#include <cstdio>    // std::sscanf
-#include <ctime>     // std::tm
-#include <iomanip>   // get_time
+#include <chrono>    // std::chrono
+#include <ctime>     // std::time_t
+#include <exception> // std::exception_ptr
+#include <functional> // std::function
 #include <iterator>  // std::back_inserter
+#include <future>    // std::promise
 #include <map>       // std::map
-#include <sstream>   // istringstream
+#include <mutex>     // std::mutex
+#include <optional>  // std::optional
+#include <sstream>   // ostringstream
 #include <utility>   // std::move
 
 #include "any_map.h"  // sdbus_variant_map
+#include "call_metrics.h"  // ScopedCall, CallTimer
 #include "dbus_constants.h"
+#include "dbus_helpers.h"  // get_all_async, value_or
+#include "dispatcher.h"    // ObserverQueue
 #include "helpers.h" // enums -> ostream
 #include "exception.h"
+#include "iso8601.h"  // parse_iso8601
+#include "location_decoder.h"  // LocationDecoder
+#include "observer_filter.h"  // SignalGate, LocationGate
+#include "property_cache.h"
+#include "proxy_pool.h"
+#include "signal_hub.h"
+#include "signal_rate.h"
 
 namespace ezcellular {
 
@@ -31,34 +44,125 @@ static void assert_state(const Modem& modem, Modem::ModemState required_state, c
     }
 }
 
-Modem::Modem(std::weak_ptr<sdbus::IConnection> conn, const sdbus::ObjectPath& dbus_path)
-    : conn_{std::move(conn)}, dbus_proxy_{sdbus::createProxy(*conn_.lock(), DBus::MM_BUS_NAME, dbus_path)} {}
+/**
+ * @brief Values that are fixed for the lifetime of the D-Bus object of a modem, fetched once.
+ *
+ * Empty strings are not known yet, see DBus::fetch_once().
+ */
+struct ModemIdentity {
+    std::mutex mutex;  ///< protects the members below
+    std::string manufacturer;
+    std::string model;
+    std::string imei;
+    std::string revision;
+    sdbus::ObjectPath sim_path;               ///< the SIM that sim_proxy and sim belong to
+    std::shared_ptr<sdbus::IProxy> sim_proxy; ///< pooled, see ProxyPool
+    std::shared_ptr<SIM::Identity> sim;       ///< shared by all SIM objects of sim_path
+};
+
+/**
+ * @brief The D-Bus object of a modem, shared by all copies of a Modem
+ */
+struct Modem::Object {
+    sdbus::ObjectPath path;          ///< the modem's object path
+    std::once_flag created;          ///< whether hub is set
+    std::shared_ptr<SignalHub> hub;  ///< the only signal handlers on the modem's proxy, from the ProxyPool
+    std::shared_ptr<SignalRate> signal_rate = std::make_shared<SignalRate>();  ///< refresh rate of .Modem.Signal
+    ModemIdentity identity;          ///< manufacturer, IMEI etc.
+};
+
+// common helper: take the identity from an ObjectManager payload, if it contains it
+static void take_identity(ModemIdentity& identity,
+                          const std::map<std::string, sdbus_variant_map>& interfaces_and_properties) {
+    auto seed = [&](std::string& value, const DBus::Prop<std::string>& prop) {
+        if (auto it = interfaces_and_properties.find(prop.interface()); it != interfaces_and_properties.end()) {
+            if (auto seeded = DBus::value_or(it->second, prop, ""); !seeded.empty()) {
+                value = std::move(seeded);
+            }
+        }
+    };
+    std::lock_guard lock{identity.mutex};
+    seed(identity.manufacturer, DBus::MODEM_MANUFACTURER);
+    seed(identity.model, DBus::MODEM_MODEL);
+    seed(identity.imei, DBus::MODEM3GPP_IMEI);
+    seed(identity.revision, DBus::MODEM_REVISION);
+}
+
+// signal refresh rate, if none is set yet
+static constexpr uint32_t DEFAULT_SIGNAL_RATE_SEC = 5;
+
+Modem::Modem(std::weak_ptr<sdbus::IConnection> conn, const sdbus::ObjectPath& dbus_path,
+             std::shared_ptr<Dispatcher> dispatcher, std::shared_ptr<ProxyPool> proxies)
+    : conn_{std::move(conn)}, object_{std::make_shared<Object>()}, dispatcher_{std::move(dispatcher)},
+      proxies_{proxies ? std::move(proxies) : std::make_shared<ProxyPool>(conn_)} {
+    object_->path = dbus_path;
+}
+
+// (private) the proxy is only created once needed, e.g. not for modems that are merely listed
+auto Modem::hub() const -> const std::shared_ptr<SignalHub>& {
+    std::call_once(object_->created, [this]() { object_->hub = proxies_->hub(DBus::MM_BUS_NAME, object_->path); });
 
-Modem::Modem(std::weak_ptr<sdbus::IConnection> conn, std::shared_ptr<sdbus::IProxy> proxy)
-    : conn_{std::move(conn)}, dbus_proxy_{std::move(proxy)} {}
+    // a seeded cache is kept up to date by the (replayed) signals from now on
+    if (cache_ && !cache_->attached()) {
+        cache_->attach(object_->hub);
+    }
+    return object_->hub;
+}
+
+// (private) start keeping a seeded cache up to date, see hub()
+void Modem::attach_cache() const {
+    if (cache_ && !cache_->attached()) {
+        static_cast<void>(hub());
+    }
+}
+
+auto Modem::proxy() const -> sdbus::IProxy& {
+    return hub()->proxy();
+}
+
+auto Modem::object_path() const -> const sdbus::ObjectPath& {
+    return object_->path;
+}
 
 /* properties */
 
+// (private) common helper, uses the property cache if enabled
+template<typename T>
+auto Modem::property(const DBus::Prop<T>& prop) const -> T {
+    if (cache_) {
+        attach_cache();
+        if (auto value = cache_->get(prop)) {
+            return *value;
+        }
+    }
+    return DBus::get_property(proxy(), prop);
+}
+
+// (private) common helper for the identity, which is only fetched if not known yet
+auto Modem::identity(std::string& value, const DBus::Prop<std::string>& prop) const -> std::string {
+    return DBus::fetch_once(object_->identity.mutex, value, [&]() { return property(prop); });
+}
+
 auto Modem::manufacturer() const -> std::string {
-    return dbus_proxy_->getProperty("Manufacturer").onInterface(DBus::MM_IF_MODEM);
+    return identity(object_->identity.manufacturer, DBus::MODEM_MANUFACTURER);
 }
 
 auto Modem::model() const -> std::string {
-    return dbus_proxy_->getProperty("Model").onInterface(DBus::MM_IF_MODEM);
+    return identity(object_->identity.model, DBus::MODEM_MODEL);
 }
 
 auto Modem::imei() const -> std::string {
     // not needed anymore since MM commit 6f00fb86 (2023-02-13) (included with release 1.21.4)
     //assert_state(*this, ModemState::ENABLED, "IMEI");
-    return dbus_proxy_->getProperty("Imei").onInterface(DBus::MM_IF_MODEM_MODEM3GPP);
+    return identity(object_->identity.imei, DBus::MODEM3GPP_IMEI);
 }
 
 auto Modem::firmware_version() const -> std::string {
-    return dbus_proxy_->getProperty("Revision").onInterface(DBus::MM_IF_MODEM);
+    return identity(object_->identity.revision, DBus::MODEM_REVISION);
 }
 
 auto Modem::phone_number() const -> std::optional<std::string> {
-    std::vector<std::string> numbers = dbus_proxy_->getProperty("OwnNumbers").onInterface(DBus::MM_IF_MODEM);
+    std::vector<std::string> numbers = property(DBus::MODEM_OWN_NUMBERS);
     if (!numbers.empty()) {
         return numbers[0];
     }
@@ -68,7 +172,7 @@ auto Modem::phone_number() const -> std::optional<std::string> {
 // --- PowerState ---
 
 auto Modem::power_state() const -> PowerState {
-    uint32_t state = dbus_proxy_->getProperty("PowerState").onInterface(DBus::MM_IF_MODEM);
+    uint32_t state = property(DBus::MODEM_POWER_STATE);
     return static_cast<PowerState>(state);
 }
 
@@ -76,7 +180,9 @@ auto Modem::power_state() const -> PowerState {
 void Modem::set_power_state(PowerState state) const {
     // needs to be DISABLED according to docs
     assert_state(*this, ModemState::DISABLED, "change power state");
-    dbus_proxy_->callMethod("SetPowerState").onInterface(DBus::MM_IF_MODEM).withArguments(static_cast<uint32_t>(state));
+    static CallSiteRef site{DBus::MM_IF_MODEM, "SetPowerState"};
+    ScopedCall call{site};
+    proxy().callMethod("SetPowerState").onInterface(DBus::MM_IF_MODEM).withArguments(static_cast<uint32_t>(state));
 }
 
 void Modem::power_off() const {
@@ -94,15 +200,19 @@ void Modem::power_on() const {
 // --- ModemState ---
 
 void Modem::enable(bool enable) const {
-    dbus_proxy_->callMethod("Enable").onInterface(DBus::MM_IF_MODEM).withArguments(enable);
+    static CallSiteRef site{DBus::MM_IF_MODEM, "Enable"};
+    ScopedCall call{site};
+    proxy().callMethod("Enable").onInterface(DBus::MM_IF_MODEM).withArguments(enable);
 }
 
 void Modem::reset() {
-    dbus_proxy_->callMethod("Reset").onInterface(DBus::MM_IF_MODEM);
+    static CallSiteRef site{DBus::MM_IF_MODEM, "Reset"};
+    ScopedCall call{site};
+    proxy().callMethod("Reset").onInterface(DBus::MM_IF_MODEM);
 }
 
 auto Modem::state() const -> Modem::ModemState {
-    int32_t state = dbus_proxy_->getProperty("State").onInterface(DBus::MM_IF_MODEM);
+    int32_t state = property(DBus::MODEM_STATE);
     return static_cast<ModemState>(state);
 }
 
@@ -123,82 +233,171 @@ auto Modem::connected() const -> bool {
     return state() == ModemState::CONNECTED;
 }
 
-void Modem::observe_modem_state(Modem::ModemStateObserver observer) {
+auto Modem::observe_modem_state(Modem::ModemStateObserver observer) const -> Subscription {
+    auto queue = ObserverQueue::create(dispatcher_);
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-    auto callback = [&, observer](int32_t old_s, int32_t new_s, [[maybe_unused]] uint32_t reason) {
+    auto callback = [queue, observer](int32_t old_s, int32_t new_s, [[maybe_unused]] uint32_t reason) {
         // forward both states to observer
         auto old_ = static_cast<Modem::ModemState>(old_s);
         auto new_ = static_cast<Modem::ModemState>(new_s);
-        return observer(old_, new_);
+        queue->post([observer, old_, new_]() { observer(old_, new_); });
     };
 
-    dbus_proxy_->uponSignal("StateChanged").onInterface(DBus::MM_IF_MODEM).call(callback);
-    dbus_proxy_->finishRegistration();
+    return hub()->subscribe_state_changed(callback);
+}
+
+auto Modem::observe_modem_state(Modem::ModemStateReasonObserver observer) const -> Subscription {
+    auto queue = ObserverQueue::create(dispatcher_);
+    // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+    auto callback = [queue, observer](int32_t old_s, int32_t new_s, uint32_t reason_) {
+        auto old_ = static_cast<Modem::ModemState>(old_s);
+        auto new_ = static_cast<Modem::ModemState>(new_s);
+        auto reason = static_cast<Modem::StateChangeReason>(reason_);
+        queue->post([observer, old_, new_, reason]() { observer(old_, new_, reason); });
+    };
+
+    return hub()->subscribe_state_changed(callback);
 }
 
 auto Modem::lock_state() const -> Modem::LockState {
-    uint32_t state = dbus_proxy_->getProperty("UnlockRequired").onInterface(DBus::MM_IF_MODEM);
+    uint32_t state = property(DBus::MODEM_UNLOCK_REQUIRED);
     return static_cast<LockState>(state);
 }
 
 auto Modem::active_sim() const -> std::optional<SIM> {
-    sdbus::ObjectPath objpath = dbus_proxy_->getProperty("Sim").onInterface(DBus::MM_IF_MODEM);
+    sdbus::ObjectPath objpath = property(DBus::MODEM_SIM);
     if (objpath == "/") {
         return {}; // empty optional
     }
-    return SIM{conn_, objpath};
+
+    // the proxy and identity are kept until the SIM changes
+    auto& identity = object_->identity;
+    {
+        std::lock_guard lock{identity.mutex};
+        if (identity.sim_path == objpath && identity.sim_proxy) {
+            return SIM{identity.sim_proxy, identity.sim};
+        }
+    }
+    auto sim_proxy = proxies_->hub(DBus::MM_BUS_NAME, objpath, object_path())->shared_proxy();
+    std::lock_guard lock{identity.mutex};
+    if (identity.sim_path != objpath || !identity.sim_proxy) {
+        identity.sim_path = objpath;
+        identity.sim_proxy = std::move(sim_proxy);
+        identity.sim = std::make_shared<SIM::Identity>();
+    }
+    return SIM{identity.sim_proxy, identity.sim};
 }
 
 /* Connection */
 
-auto Modem::active_connection() const -> std::optional<Connection> {
-    auto conns = connections();
-    auto result = std::find_if(conns.begin(), conns.end(), [](Connection& conn) { return conn.active(); });
+// (private) common helper for active_connection, connections; drops the proxies of deleted bearers
+auto Modem::bearer_paths() const -> std::vector<sdbus::ObjectPath> {
+    std::vector<sdbus::ObjectPath> paths = property(DBus::MODEM_BEARERS);
+    proxies_->retain(object_path(), DBus::MM_OBJ_BEARER_PREFIX, paths);  // not the SIM, it has the same owner
+    return paths;
+}
 
-    if (result == conns.end()) {
-        return {};  // empty optional
+auto Modem::active_connection() const -> std::optional<Connection> {
+    // the proxies are pooled, so only the bearers up to the active one are queried
+    for (const auto& path : bearer_paths()) {
+        auto conn = Connection{conn_, path, dispatcher_, proxies_, object_path()};
+        if (conn.active()) {
+            return conn;
+        }
     }
 
-    return std::move(*result);
+    return {};  // empty optional
 }
 
 auto Modem::connections() const -> std::vector<Connection> {
     std::vector<Connection> conns;
-    std::vector<sdbus::ObjectPath> paths = dbus_proxy_->getProperty("Bearers").onInterface(DBus::MM_IF_MODEM);
+    auto paths = bearer_paths();
 
-    std::transform(paths.begin(), paths.end(), std::back_inserter(conns),
-                   [&](const sdbus::ObjectPath& p) { return Connection{conn_, p}; });
+    std::transform(paths.begin(), paths.end(), std::back_inserter(conns), [&](const sdbus::ObjectPath& p) {
+        return Connection{conn_, p, dispatcher_, proxies_, object_path()};
+    });
     return conns;
 }
 
-auto Modem::connect(std::string apn, IPType ip_type) -> void {
+// common helper for connect, connect_async: whether a bearer was set up with the requested APN and IP type
+static auto bearer_matches(const sdbus_variant_map& bearer_props, const std::string& apn, IPType ip_type) -> bool {
+    auto settings = DBus::value_or(bearer_props, DBus::BEARER_PROPERTIES, {});
+    return DBus::value_or<std::string>(settings, "apn", {}) == apn
+        && DBus::value_or<uint32_t>(settings, "ip-type", 0) == static_cast<uint32_t>(ip_type);
+}
+
+// common helper for connect, connect_async: the D-Bus timeout for a call that must reply before deadline
+static auto remaining_usec(std::chrono::steady_clock::time_point deadline) -> uint64_t {
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+        throw ConnectionException{"connect: timed out"};
+    }
+    return static_cast<uint64_t>(remaining.count());
+}
+
+auto Modem::connect(const std::string& apn, IPType ip_type, std::chrono::milliseconds timeout) -> Connection {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
     sdbus_variant_map properties = {{"apn", apn}, {"ip-type", static_cast<uint32_t>(ip_type)}};
 
-    // 1. create bearer
-    sdbus::ObjectPath bearer_path;
-    dbus_proxy_->callMethod("CreateBearer").onInterface(DBus::MM_IF_MODEM).withArguments(properties).storeResultsTo(bearer_path);
+    try {
+        // 1. reuse a bearer with the same settings
+        std::optional<sdbus::ObjectPath> bearer_path;
+        for (const auto& path : bearer_paths()) {
+            sdbus_variant_map bearer_props;
+            try {
+                static CallSiteRef site{DBus::MM_IF_BEARER, "GetAll"};
+                ScopedCall call{site};
+                proxies_->hub(DBus::MM_BUS_NAME, path, object_path())->proxy()
+                    .callMethod("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES)
+                    .withArguments(std::string{DBus::MM_IF_BEARER}).withTimeout(remaining_usec(deadline))
+                    .storeResultsTo(bearer_props);
+            } catch (const sdbus::Error&) {
+                continue;  // vanished in the meantime, so it can't be reused
+            }
+            if (bearer_matches(bearer_props, apn, ip_type)) {
+                if (DBus::value_or(bearer_props, DBus::BEARER_CONNECTED, false)) {
+                    return Connection{conn_, path, dispatcher_, proxies_, object_path()};
+                }
+                bearer_path = path;
+                break;
+            }
+        }
 
-    // 2. connect bearer
-    auto bearer_proxy = sdbus::createProxy(*conn_.lock(), DBus::MM_BUS_NAME, bearer_path);
-    bearer_proxy->callMethod("Connect").onInterface(DBus::MM_IF_BEARER);
+        // 2. otherwise create one
+        if (!bearer_path) {
+            bearer_path.emplace();
+            static CallSiteRef site{DBus::MM_IF_MODEM, "CreateBearer"};
+            ScopedCall call{site};
+            proxy().callMethod("CreateBearer").onInterface(DBus::MM_IF_MODEM).withArguments(properties)
+                .withTimeout(remaining_usec(deadline)).storeResultsTo(*bearer_path);
+        }
 
-    // 3. ???
+        // 3. connect bearer
+        {
+            static CallSiteRef site{DBus::MM_IF_BEARER, "Connect"};
+            ScopedCall call{site};
+            proxies_->hub(DBus::MM_BUS_NAME, *bearer_path, object_path())->proxy()
+                .callMethod("Connect").onInterface(DBus::MM_IF_BEARER).withTimeout(remaining_usec(deadline));
+        }
+        return Connection{conn_, *bearer_path, dispatcher_, proxies_, object_path()};
+    } catch (const sdbus::Error& err) {
+        throw ConnectionException{"connect: " + err.getMessage()};
+    }
 }
 
 auto Modem::operator_plmn() const -> std::string {
-    return dbus_proxy_->getProperty("OperatorCode").onInterface(DBus::MM_IF_MODEM_MODEM3GPP);
+    return property(DBus::MODEM3GPP_OPERATOR_CODE);
 }
 
 auto Modem::operator_name() const -> std::string {
-    return dbus_proxy_->getProperty("OperatorName").onInterface(DBus::MM_IF_MODEM_MODEM3GPP);
+    return property(DBus::MODEM3GPP_OPERATOR_NAME);
 }
 
 /* Signal */
 
-auto Modem::technology() const -> Technology {
+// common helper for technology, snapshot
+static auto mm_tech_to_Technology(uint32_t mm_tech) -> Technology {
     // TODO: check if AccessTechnologies might be a bitmask, e.g. in case of 5G NSA
-    uint32_t mm_tech = dbus_proxy_->getProperty("AccessTechnologies").onInterface(DBus::MM_IF_MODEM);
-
     switch (mm_tech) {
         case MM_MODEM_ACCESS_TECHNOLOGY_GSM:
         case MM_MODEM_ACCESS_TECHNOLOGY_GSM_COMPACT:
@@ -220,20 +419,19 @@ auto Modem::technology() const -> Technology {
     }
 }
 
+auto Modem::technology() const -> Technology {
+    uint32_t mm_tech = property(DBus::MODEM_ACCESS_TECHNOLOGIES);
+    return mm_tech_to_Technology(mm_tech);
+}
+
 // common helper for signal, observe_signal, cell_info
 static auto dbus_signal_to_Signal(Technology tech, const sdbus_variant_map& signal) -> Signal {
-    try {
-        switch (tech) {
-            case Technology::LTE:
-                return SignalLTE::from_variant_map(signal);
-            case Technology::NR5G:
-                return SignalNR5G::from_variant_map(signal);
-            default:
-                throw ModemException{"signal: current technology unknown or not supported yet"};
-        }
-    } catch (std::out_of_range&) {
-        // some value is not set in response, return "empty" value (shared_ptr with nullptr)
-        return {nullptr};
+    switch (tech) {
+        case Technology::LTE:
+        case Technology::NR5G:
+            return Signal::from_variant_map(tech, signal);
+        default:
+            throw ModemException{"signal: current technology unknown or not supported yet"};
     }
 }
 
@@ -241,10 +439,10 @@ auto Modem::signal() const -> Signal {
     // 0. Must be registered
     assert_state(*this, ModemState::REGISTERED, "access signal quality");
 
-    // setup refresh if not done already to get any values
-    if (0 == dbus_proxy_->getProperty("Rate").onInterface(DBus::MM_IF_MODEM_SIGNAL).get<uint32_t>()) {
-        dbus_proxy_->callMethod("Setup").onInterface(DBus::MM_IF_MODEM_SIGNAL).withArguments(5U);
-    }
+    // setup refresh if not done already to get any values, the Rate is only read the first time
+    static_cast<void>(object_->signal_rate->ensure(proxy(), [this]() {
+        return property(DBus::SIGNAL_RATE);
+    }, DEFAULT_SIGNAL_RATE_SEC));
 
     // fetch info for current RAT
     auto tech = technology();
@@ -252,11 +450,11 @@ auto Modem::signal() const -> Signal {
 
     switch (tech) {
         case Technology::LTE: {
-                signal = dbus_proxy_->getProperty("Lte").onInterface(DBus::MM_IF_MODEM_SIGNAL);
+                signal = property(DBus::SIGNAL_LTE);
                 return dbus_signal_to_Signal(tech, signal);
             }
         case Technology::NR5G: {
-                signal = dbus_proxy_->getProperty("Nr5g").onInterface(DBus::MM_IF_MODEM_SIGNAL);
+                signal = property(DBus::SIGNAL_NR5G);
                 return dbus_signal_to_Signal(tech, signal);
             }
         default:
@@ -264,96 +462,76 @@ auto Modem::signal() const -> Signal {
     }
 }
 
-void Modem::observe_signal(SignalObserver observer, uint32_t interval_sec) {
+// (private) common helper for observe_signal, ModemHealth: keeps the interval as long as the handle is alive
+auto Modem::request_signal_rate(uint32_t interval_sec) const -> Subscription {
+    return object_->signal_rate->request(hub()->shared_proxy(), [this]() {
+        return property(DBus::SIGNAL_RATE);
+    }, interval_sec);
+}
+
+auto Modem::observe_signal(SignalObserver observer, uint32_t interval_sec, const SignalFilter& filter) const
+    -> Subscription {
     // 0. Must be registered
     assert_state(*this, ModemState::REGISTERED, "observe signal quality");
 
-    // 1. setup polling
-    dbus_proxy_->callMethod("Setup").onInterface(DBus::MM_IF_MODEM_SIGNAL).withArguments(interval_sec).dontExpectReply();
+    // 1. setup polling, at the smallest interval requested by all observers of this modem
+    auto rate = request_signal_rate(interval_sec);
 
     // 2. register callback
-    auto callback = [observer](const std::string& interfaceName,
-                               const sdbus_variant_map& changedProperties,
-                               [[maybe_unused]] const std::vector<std::string>& invalidatedProperties) {
-        if (interfaceName == DBus::MM_IF_MODEM_SIGNAL) {
-            sdbus_variant_map dbus_signal; // signal values from D-Bus attribute. tech specific.
-
-            if (auto it = changedProperties.find("Lte"); it != changedProperties.end()) {
-                dbus_signal = it->second;
-                auto signal = dbus_signal_to_Signal(Technology::LTE, dbus_signal);
-                return observer(signal);
-            }
-            if (auto it = changedProperties.find("Nr5g"); it != changedProperties.end()) {
-                dbus_signal = it->second;
-                auto signal = dbus_signal_to_Signal(Technology::NR5G, dbus_signal);
-                return observer(signal);
-            }
+    //    filtered on the D-Bus thread, so that dropped updates are never queued
+    auto queue = ObserverQueue::create(dispatcher_);
+    auto gate = std::make_shared<SignalGate>(filter);
+    auto deliver = [queue, gate, observer](const Signal& signal) {
+        if (gate->admit(signal)) {
+            queue->post([observer, signal]() { observer(signal); });
         }
     };
+    auto callback = [deliver](const sdbus_variant_map& changedProperties,
+                              [[maybe_unused]] const std::vector<std::string>& invalidatedProperties) {
+        sdbus_variant_map dbus_signal; // signal values from D-Bus attribute. tech specific.
 
-    dbus_proxy_->uponSignal("PropertiesChanged").onInterface(DBus::DBUS_IF_PROPERTIES).call(callback);
-    dbus_proxy_->finishRegistration();
+        if (auto it = changedProperties.find(DBus::SIGNAL_LTE.name()); it != changedProperties.end()) {
+            dbus_signal = it->second;
+            return deliver(dbus_signal_to_Signal(Technology::LTE, dbus_signal));
+        }
+        if (auto it = changedProperties.find(DBus::SIGNAL_NR5G.name()); it != changedProperties.end()) {
+            dbus_signal = it->second;
+            return deliver(dbus_signal_to_Signal(Technology::NR5G, dbus_signal));
+        }
+    };
+
+    auto subscription = std::make_shared<Subscription>(hub()->subscribe_interface(DBus::MM_IF_MODEM_SIGNAL, callback));
+    auto rate_request = std::make_shared<Subscription>(std::move(rate));
+    return Subscription{[subscription, rate_request]() {
+        subscription->reset();
+        rate_request->reset();  // restores the previous rate, if this was the fastest request
+    }};
 }
 
-auto Modem::cell_info() const -> std::vector<CellInfo> {
+// common helper for cell_info, cell_info_async
+static auto dbus_cell_info_to_CellInfos(const std::vector<sdbus_variant_map>& result) -> std::vector<CellInfo> {
     std::vector<CellInfo> infos;
-    std::vector<sdbus_variant_map> result;
-
-    dbus_proxy_->callMethod("GetCellInfo").onInterface(DBus::MM_IF_MODEM).storeResultsTo(result);
+    infos.reserve(result.size());
 
     for (const auto& res : result) {
-        uint32_t cell_type = res.at("cell-type");
-
-        if (cell_type == MM_CELL_TYPE_LTE) {
-            auto lte = CellInfoLTE::from_variant_map(res);
-            infos.push_back(std::move(lte));
-        }
-        if (cell_type == MM_CELL_TYPE_5GNR) {
-            auto nr = CellInfoNR5G::from_variant_map(res);
-            infos.push_back(std::move(nr));
+        if (auto info = CellInfo::from_variant_map(res)) {
+            infos.push_back(std::move(*info));
         }
     }
 
     return infos;
 }
 
-// common helper
-static auto dbus_location_to_Location(const Modem& modem,
-                                      const std::map<uint32_t, sdbus::Variant>& location_dict) -> Location {
-    auto it = location_dict.find(MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI); // cell info
-    if (it == location_dict.end()) {
-        return {nullptr};
-    }
-
-    auto loc_data = it->second.get<std::string>();
-    std::array<char, 4> mcc{}; // MCC: 3 chars + '\0'
-    std::array<char, 4> mnc{}; // MNC: 2 or 3 chars + '\0'
-    uint32_t ci{};
-    uint32_t tac{};
-
-    auto rat = modem.technology();
-    auto lte_nr_loc = std::shared_ptr<LocationLTE>(nullptr); // LTE and NR compatible
-
-    if (rat == Technology::LTE) {
-        lte_nr_loc = std::make_shared<LocationLTE>();
-    } else if (rat != Technology::NR5G) {
-        lte_nr_loc = std::make_shared<LocationNR5G>();
-    } else {
-        return {nullptr};  // not supported yet
-    }
+auto Modem::cell_info() const -> std::vector<CellInfo> {
+    std::vector<sdbus_variant_map> result;
 
-    // parse
-    if (std::sscanf(loc_data.c_str(), "%3[0-9],%3[0-9],%*X,%X,%X",
-                    mcc.data(), mnc.data(), &ci, &tac) != 4) {
-        return {nullptr};  // parsing failed
+    {
+        static CallSiteRef site{DBus::MM_IF_MODEM, "GetCellInfo"};
+        ScopedCall call{site};
+        proxy().callMethod("GetCellInfo").onInterface(DBus::MM_IF_MODEM).storeResultsTo(result);
     }
 
-    lte_nr_loc->insert({"mcc", std::string{mcc.data()}});
-    lte_nr_loc->insert({"mnc", std::string{mnc.data()}});
-    lte_nr_loc->insert({"ci", ci});
-    lte_nr_loc->insert({"tac", tac});
-
-    return lte_nr_loc;
+    return dbus_cell_info_to_CellInfos(result);
 }
 
 /* Location */
@@ -363,59 +541,639 @@ auto Modem::location() const -> Location {
     assert_state(*this, ModemState::REGISTERED, "access cell location");
 
     //MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI
-    dbus_proxy_->callMethod("GetLocation").onInterface(DBus::MM_IF_MODEM_LOCATION).storeResultsTo(location_res);
+    {
+        static CallSiteRef site{DBus::MM_IF_MODEM_LOCATION, "GetLocation"};
+        ScopedCall call{site};
+        proxy().callMethod("GetLocation").onInterface(DBus::MM_IF_MODEM_LOCATION).storeResultsTo(location_res);
+    }
 
-    return dbus_location_to_Location(*this, location_res);
+    return LocationDecoder::decode(technology(), location_res);
 }
 
-void Modem::observe_location(const LocationObserver& observer) const {
+auto Modem::observe_location(LocationObserver observer, const LocationFilter& filter) const -> Subscription {
     assert_state(*this, ModemState::REGISTERED, "observe cell location");
 
     // 1. enable Location property and the property update signal
     uint32_t location_LAC_CI = MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI; // location source type to enable, unsigned
-    dbus_proxy_->callMethod("Setup").onInterface(DBus::MM_IF_MODEM_LOCATION).withArguments(location_LAC_CI, true);
-
-    // 2. setup signal observer
-    auto callback = [this, &observer](const std::string& interfaceName,
-                                      const sdbus_variant_map& changedProperties,
-                                      [[maybe_unused]] const std::vector<std::string>& invalidatedProperties) {
-        if (interfaceName != DBus::MM_IF_MODEM_LOCATION) {
-            return;  // we are only interested in the .Modem.Location interface
+    {
+        static CallSiteRef site{DBus::MM_IF_MODEM_LOCATION, "Setup"};
+        ScopedCall call{site};
+        proxy().callMethod("Setup").onInterface(DBus::MM_IF_MODEM_LOCATION).withArguments(location_LAC_CI, true);
+    }
+
+    // 2. keep the access technology for decoding current from its own PropertiesChanged,
+    //    subscribed before reading it, so that no change is missed in between;
+    //    the value read is only taken if no change arrived meanwhile, which would be newer
+    auto decoder = std::make_shared<LocationDecoder>(Technology::UNKNOWN);
+    auto tech_subscription = hub()->watch(DBus::MODEM_ACCESS_TECHNOLOGIES, [decoder](uint32_t mm_tech) {
+        decoder->set_technology(mm_tech_to_Technology(mm_tech));
+    });
+    decoder->set_initial_technology(technology());
+
+    // 3. setup signal observer, only for the .Modem.Location property. No bus calls in here.
+    auto queue = ObserverQueue::create(dispatcher_);
+    auto gate = std::make_shared<LocationGate>(filter);
+    auto callback = [decoder, queue, gate, observer = std::move(observer)](const DBus::LocationDict& dbus_loc) {
+        // found update! filter on the raw identifiers, before anything is decoded
+        auto it = dbus_loc.find(MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI);
+        auto lac_ci = it != dbus_loc.end() ? it->second.get<std::string>() : std::string{};
+        if (!gate->admit(lac_ci)) {
+            return;
         }
-        auto loc_it = changedProperties.find("Location");
-        if (loc_it != changedProperties.end()) {
-            // found update!
-            auto dbus_loc = loc_it->second.get<std::map<uint32_t, sdbus::Variant>>(); // "cast" map value
-            auto loc = dbus_location_to_Location(*this, dbus_loc);
-            // call observer
-            observer(loc);
+        Location loc{};
+        if (it != dbus_loc.end()) {
+            loc = LocationDecoder::decode_lac_ci(decoder->technology(), lac_ci);
         }
+        // call observer
+        queue->post([observer, loc]() { observer(loc); });
     };
 
-    dbus_proxy_->uponSignal("PropertiesChanged").onInterface(DBus::DBUS_IF_PROPERTIES).call(callback);
-    dbus_proxy_->finishRegistration();
+    auto location_subscription = std::make_shared<Subscription>(
+        hub()->watch(DBus::LOCATION_LOCATION, callback));
+    auto tech = std::make_shared<Subscription>(std::move(tech_subscription));
+    return Subscription{[location_subscription, tech]() {
+        location_subscription->reset();
+        tech->reset();
+    }};
 }
 
 auto Modem::network_time() const -> std::string {
     std::string time_str;
     assert_state(*this, ModemState::ENABLED, "get network time");
-    dbus_proxy_->callMethod("GetNetworkTime").onInterface(DBus::MM_IF_MODEM_TIME).storeResultsTo(time_str);
+    {
+        static CallSiteRef site{DBus::MM_IF_MODEM_TIME, "GetNetworkTime"};
+        ScopedCall call{site};
+        proxy().callMethod("GetNetworkTime").onInterface(DBus::MM_IF_MODEM_TIME).storeResultsTo(time_str);
+    }
     return time_str;
 }
 
+// common helper for network_time_epoch, network_time_epoch_async
+static auto iso8601_to_epoch(const std::string& time_str) -> std::time_t {
+    // the time is local time of the network plus its offset, epoch time is UTC
+    auto time = parse_iso8601(time_str);
+    if (!time) {
+        return 0;  // not a valid time
+    }
+    return std::chrono::system_clock::to_time_t(time->utc);
+}
+
+auto Modem::observe_network_time(NetworkTimeObserver observer) const -> Subscription {
+    auto queue = ObserverQueue::create(dispatcher_);
+    return hub()->subscribe_network_time([queue, observer](const std::string& time_str) {
+        // taken on arrival, so that the time is not skewed by a busy executor
+        auto received = std::chrono::steady_clock::now();
+        if (auto time = parse_iso8601(time_str)) {
+            time->received = received;
+            queue->post([observer, time = *time]() { observer(time); });
+        }
+    });
+}
+
 auto Modem::network_time_epoch() const -> std::time_t {
-    std::tm tm{};
-    auto time_str = network_time();
-
-    // parse time string using get_time into tm and then convert to time_t
-    // ignore the timezone as epoch time is UTC
-    std::istringstream iss_time{time_str};
-    iss_time >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-    if (iss_time.fail()) {
-        return 0;  // get_time() failed
-    }
-    // use POSIX timegm here, as mktime interprets tm using the local timezone :eyes:
-    return ::timegm(&tm);
+    return iso8601_to_epoch(network_time());
+}
+
+/* Snapshot */
+
+// common helper for snapshot, snapshot_async
+static auto slots_to_ModemSnapshot(const DBus::PropertySlots& props, const DBus::LocationDict& location_dict)
+    -> ModemSnapshot {
+    using ModemState = Modem::ModemState;
+    using PowerState = Modem::PowerState;
+    using LockState = Modem::LockState;
+    ModemSnapshot snap{};
+    snap.timestamp = std::chrono::steady_clock::now();
+
+    // .Modem
+    snap.manufacturer = DBus::value_or(props, DBus::MODEM_MANUFACTURER, {});
+    snap.model = DBus::value_or(props, DBus::MODEM_MODEL, {});
+    snap.firmware_version = DBus::value_or(props, DBus::MODEM_REVISION, {});
+    snap.state = static_cast<ModemState>(DBus::value_or(props, DBus::MODEM_STATE, MM_MODEM_STATE_UNKNOWN));
+    snap.power_state = static_cast<PowerState>(
+        DBus::value_or(props, DBus::MODEM_POWER_STATE, MM_MODEM_POWER_STATE_UNKNOWN));
+    snap.lock_state = static_cast<LockState>(DBus::value_or(props, DBus::MODEM_UNLOCK_REQUIRED, MM_MODEM_LOCK_UNKNOWN));
+    snap.technology = mm_tech_to_Technology(
+        DBus::value_or(props, DBus::MODEM_ACCESS_TECHNOLOGIES, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN));
+
+    // .Modem.Modem3gpp
+    snap.imei = DBus::value_or(props, DBus::MODEM3GPP_IMEI, {});
+    snap.operator_plmn = DBus::value_or(props, DBus::MODEM3GPP_OPERATOR_CODE, {});
+    snap.operator_name = DBus::value_or(props, DBus::MODEM3GPP_OPERATOR_NAME, {});
+
+    // .Modem.Signal, only contains values if refreshing was set up, see signal()
+    if (snap.technology == Technology::LTE || snap.technology == Technology::NR5G) {
+        const auto& prop = snap.technology == Technology::LTE ? DBus::SIGNAL_LTE : DBus::SIGNAL_NR5G;
+        snap.signal = dbus_signal_to_Signal(snap.technology, DBus::value_or(props, prop, {}));
+    }
+
+    // .Modem.Location
+    snap.location = LocationDecoder::decode(snap.technology, location_dict);
+
+    return snap;
+}
+
+auto Modem::snapshot() const -> ModemSnapshot {
+    if (cache_) {
+        // everything is already here, in the slots of the cache
+        attach_cache();
+        auto props = cache_->slots();
+        return slots_to_ModemSnapshot(props, DBus::value_or(props, DBus::LOCATION_LOCATION, {}));
+    }
+
+    // blocking calls, not snapshot_async().get(): that would wait forever if no thread dispatches the replies,
+    // i.e. in EventLoopMode::EXTERNAL or on the event loop thread itself
+    // missing interfaces or a failing GetLocation (e.g. not registered) just leave the values empty
+    DBus::PropertySlots props;
+    for (const auto* iface : {DBus::MM_IF_MODEM, DBus::MM_IF_MODEM_MODEM3GPP, DBus::MM_IF_MODEM_SIGNAL}) {
+        DBus::fill_slots(props, iface, DBus::get_all(proxy(), iface));
+    }
+    DBus::LocationDict location_dict;
+    try {
+        static CallSiteRef site{DBus::MM_IF_MODEM_LOCATION, "GetLocation"};
+        ScopedCall call{site};
+        proxy().callMethod("GetLocation").onInterface(DBus::MM_IF_MODEM_LOCATION).storeResultsTo(location_dict);
+    } catch (const sdbus::Error&) {
+        location_dict.clear();
+    }
+    return slots_to_ModemSnapshot(props, location_dict);
+}
+
+auto Modem::snapshot_async() const -> std::future<ModemSnapshot> {
+    // collects the four replies, the last one builds the snapshot
+    struct SnapshotJoin {
+        std::mutex mutex;
+        int pending = 4;
+        DBus::PropertySlots props;
+        DBus::LocationDict location_dict;
+        std::promise<ModemSnapshot> promise;
+
+        void done() {  // expects mutex to be locked
+            if (--pending == 0) {
+                DBus::set_promise_from(promise, [&]() { return slots_to_ModemSnapshot(props, location_dict); });
+            }
+        }
+    };
+    auto join = std::make_shared<SnapshotJoin>();
+    auto future = join->promise.get_future();
+
+    // issue all calls at once, the replies are collected on the event loop thread
+    // missing interfaces or a failing GetLocation (e.g. not registered) just leave the values empty
+    auto get_all = [&](CallSiteRef& site, const std::string& iface) {
+        proxy().callMethodAsync("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES).withArguments(iface)
+            .uponReplyInvoke([join, iface, timer = CallTimer::start(site)](const sdbus::Error* err,
+                                                                          const sdbus_variant_map& props) {
+                timer.finish(err != nullptr);
+                std::lock_guard lock{join->mutex};
+                if (err == nullptr) {
+                    DBus::fill_slots(join->props, iface, props);
+                }
+                join->done();
+            });
+    };
+    static CallSiteRef modem_site{DBus::MM_IF_MODEM, "GetAll"};
+    static CallSiteRef modem3gpp_site{DBus::MM_IF_MODEM_MODEM3GPP, "GetAll"};
+    static CallSiteRef signal_site{DBus::MM_IF_MODEM_SIGNAL, "GetAll"};
+    static CallSiteRef location_site{DBus::MM_IF_MODEM_LOCATION, "GetLocation"};
+    get_all(modem_site, DBus::MM_IF_MODEM);
+    get_all(modem3gpp_site, DBus::MM_IF_MODEM_MODEM3GPP);
+    get_all(signal_site, DBus::MM_IF_MODEM_SIGNAL);
+
+    proxy().callMethodAsync("GetLocation").onInterface(DBus::MM_IF_MODEM_LOCATION)
+        .uponReplyInvoke([join, timer = CallTimer::start(location_site)](const sdbus::Error* err,
+                                                                        const DBus::LocationDict& dict) {
+            timer.finish(err != nullptr);
+            std::lock_guard lock{join->mutex};
+            if (err == nullptr) {
+                join->location_dict = dict;
+            }
+            join->done();
+        });
+
+    return future;
+}
+
+/* Asynchronous variants */
+
+// (private) common helper, uses the property cache if enabled
+template<typename T, typename Fn>
+auto Modem::property_async(const DBus::Prop<T>& prop, Fn transform) const {
+    if (cache_) {
+        attach_cache();
+        if (auto value = cache_->get(prop)) {
+            std::promise<std::invoke_result_t<Fn, T>> promise;
+            DBus::set_promise_from(promise, [&]() { return transform(std::move(*value)); });
+            return promise.get_future();
+        }
+    }
+    return DBus::get_property_async(proxy(), prop, std::move(transform));
+}
+
+// properties, identity transformation
+static auto same = [](auto value) { return value; };
+
+// (private) see identity()
+auto Modem::identity_async(std::string& value, const DBus::Prop<std::string>& prop) const
+    -> std::future<std::string> {
+    return DBus::fetch_once_async(object_, object_->identity.mutex, value, [&](auto remember) {
+        return property_async(prop, std::move(remember));
+    });
+}
+
+auto Modem::manufacturer_async() const -> std::future<std::string> {
+    return identity_async(object_->identity.manufacturer, DBus::MODEM_MANUFACTURER);
+}
+
+auto Modem::model_async() const -> std::future<std::string> {
+    return identity_async(object_->identity.model, DBus::MODEM_MODEL);
+}
+
+auto Modem::imei_async() const -> std::future<std::string> {
+    return identity_async(object_->identity.imei, DBus::MODEM3GPP_IMEI);
+}
+
+auto Modem::firmware_version_async() const -> std::future<std::string> {
+    return identity_async(object_->identity.revision, DBus::MODEM_REVISION);
+}
+
+auto Modem::phone_number_async() const -> std::future<std::optional<std::string>> {
+    return property_async(DBus::MODEM_OWN_NUMBERS,
+        [](const std::vector<std::string>& numbers) -> std::optional<std::string> {
+            if (!numbers.empty()) {
+                return numbers[0];
+            }
+            return {};  // empty optional
+        });
+}
+
+auto Modem::power_state_async() const -> std::future<PowerState> {
+    return property_async(DBus::MODEM_POWER_STATE,
+                                    [](uint32_t state) { return static_cast<PowerState>(state); });
+}
+
+auto Modem::set_power_state_async(PowerState state) const -> std::future<void> {
+    static CallSiteRef site{DBus::MM_IF_MODEM, "SetPowerState"};
+    return DBus::call_async<>(
+        proxy().callMethodAsync("SetPowerState").onInterface(DBus::MM_IF_MODEM)
+            .withArguments(static_cast<uint32_t>(state)),
+        []() {}, CallTimer::start(site));
+}
+
+auto Modem::state_async() const -> std::future<ModemState> {
+    return property_async(DBus::MODEM_STATE,
+                                   [](int32_t state) { return static_cast<ModemState>(state); });
+}
+
+auto Modem::enable_async(bool enable) const -> std::future<void> {
+    static CallSiteRef site{DBus::MM_IF_MODEM, "Enable"};
+    return DBus::call_async<>(
+        proxy().callMethodAsync("Enable").onInterface(DBus::MM_IF_MODEM).withArguments(enable),
+        []() {}, CallTimer::start(site));
+}
+
+auto Modem::reset_async() -> std::future<void> {
+    static CallSiteRef site{DBus::MM_IF_MODEM, "Reset"};
+    return DBus::call_async<>(proxy().callMethodAsync("Reset").onInterface(DBus::MM_IF_MODEM), []() {},
+                              CallTimer::start(site));
+}
+
+/**
+ * @brief State of one connect_async(), shared by the replies of its D-Bus calls.
+ *
+ * The calls are made on pooled proxies and only a weak reference to the pool is kept,
+ * as a proxy can't be released from within its own callback.
+ */
+struct ConnectJob {
+    std::promise<Connection> promise;
+    std::chrono::steady_clock::time_point deadline;
+    std::string apn;
+    IPType ip_type{};
+    std::weak_ptr<ProxyPool> pool;
+    std::string modem_path;
+    std::function<Connection(const sdbus::ObjectPath&)> make_connection;  // has access to the private ctor
+
+    std::mutex mutex;  // protects the members below, while the bearers are inspected
+    std::size_t pending = 0;
+    std::vector<sdbus_variant_map> bearer_props;  // per bearer, empty if its GetAll failed
+
+    void fail(std::exception_ptr error) { promise.set_exception(std::move(error)); }
+    void fail(const sdbus::Error& err) {
+        fail(std::make_exception_ptr(ConnectionException{"connect: " + err.getMessage()}));
+    }
+    // the hub of a bearer or the modem in the pool, nullptr once the pool is gone
+    [[nodiscard]] auto hub(const sdbus::ObjectPath& path, const std::string& owner) -> std::shared_ptr<SignalHub> {
+        auto locked = pool.lock();
+        if (!locked) {
+            fail(std::make_exception_ptr(ConnectionException{"DBus connection lost"}));
+            return nullptr;
+        }
+        return locked->hub(DBus::MM_BUS_NAME, path, owner);
+    }
+};
+
+// common helper for connect_async: 3. connect the chosen bearer
+static void connect_bearer_async(const std::shared_ptr<ConnectJob>& job, const sdbus::ObjectPath& path) {
+    try {
+        auto hub = job->hub(path, job->modem_path);
+        if (!hub) {
+            return;
+        }
+        static CallSiteRef site{DBus::MM_IF_BEARER, "Connect"};
+        hub->proxy().callMethodAsync("Connect").onInterface(DBus::MM_IF_BEARER)
+            .withTimeout(remaining_usec(job->deadline))
+            .uponReplyInvoke([job, path, timer = CallTimer::start(site)](
+                    const sdbus::Error* err) {
+                timer.finish(err != nullptr);
+                if (err != nullptr) {
+                    job->fail(*err);
+                    return;
+                }
+                DBus::set_promise_from(job->promise, [&]() { return job->make_connection(path); });
+            });
+    } catch (...) {
+        job->fail(std::current_exception());
+    }
+}
+
+// common helper for connect_async: 2. create a bearer if none can be reused
+static void create_bearer_async(const std::shared_ptr<ConnectJob>& job) {
+    try {
+        auto hub = job->hub(job->modem_path, {});
+        if (!hub) {
+            return;
+        }
+        sdbus_variant_map properties = {{"apn", job->apn}, {"ip-type", static_cast<uint32_t>(job->ip_type)}};
+        static CallSiteRef site{DBus::MM_IF_MODEM, "CreateBearer"};
+        hub->proxy().callMethodAsync("CreateBearer").onInterface(DBus::MM_IF_MODEM).withArguments(properties)
+            .withTimeout(remaining_usec(job->deadline))
+            .uponReplyInvoke([job, timer = CallTimer::start(site)](
+                    const sdbus::Error* err, const sdbus::ObjectPath& path) {
+                timer.finish(err != nullptr);
+                if (err != nullptr) {
+                    job->fail(*err);
+                    return;
+                }
+                connect_bearer_async(job, path);
+            });
+    } catch (...) {
+        job->fail(std::current_exception());
+    }
+}
+
+// common helper for connect_async: pick a bearer once all of them are inspected
+static void choose_bearer(const std::shared_ptr<ConnectJob>& job, const std::vector<sdbus::ObjectPath>& paths) {
+    std::optional<std::size_t> match;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (!bearer_matches(job->bearer_props[i], job->apn, job->ip_type)) {
+            continue;
+        }
+        if (DBus::value_or(job->bearer_props[i], DBus::BEARER_CONNECTED, false)) {
+            DBus::set_promise_from(job->promise, [&]() { return job->make_connection(paths[i]); });
+            return;
+        }
+        if (!match) {
+            match = i;
+        }
+    }
+
+    if (match) {
+        connect_bearer_async(job, paths[*match]);
+    } else {
+        create_bearer_async(job);
+    }
+}
+
+// common helper for connect_async: 1. inspect all bearers at once
+static void inspect_bearers_async(const std::shared_ptr<ConnectJob>& job, const std::vector<sdbus::ObjectPath>& paths) {
+    if (paths.empty()) {
+        create_bearer_async(job);
+        return;
+    }
+
+    try {
+        std::vector<std::shared_ptr<SignalHub>> hubs;
+        for (const auto& path : paths) {
+            auto hub = job->hub(path, job->modem_path);
+            if (!hub) {
+                return;
+            }
+            hubs.push_back(std::move(hub));
+        }
+        auto timeout = remaining_usec(job->deadline);
+        job->bearer_props.resize(paths.size());
+        job->pending = paths.size();
+
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            static CallSiteRef site{DBus::MM_IF_BEARER, "GetAll"};
+            hubs[i]->proxy().callMethodAsync("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES)
+                .withArguments(std::string{DBus::MM_IF_BEARER}).withTimeout(timeout)
+                .uponReplyInvoke([job, paths, i, timer = CallTimer::start(site)](
+                        const sdbus::Error* err, const sdbus_variant_map& props) {
+                    timer.finish(err != nullptr);
+                    {
+                        std::lock_guard lock{job->mutex};
+                        if (err == nullptr) {
+                            job->bearer_props[i] = props;
+                        }
+                        if (--job->pending > 0) {
+                            return;
+                        }
+                    }
+                    // a bearer that vanished in the meantime is simply not reused
+                    choose_bearer(job, paths);
+                });
+        }
+    } catch (...) {
+        job->fail(std::current_exception());
+    }
+}
+
+auto Modem::connect_async(const std::string& apn, IPType ip_type, std::chrono::milliseconds timeout)
+    -> std::future<Connection> {
+    auto job = std::make_shared<ConnectJob>();
+    auto future = job->promise.get_future();
+    job->deadline = std::chrono::steady_clock::now() + timeout;
+    job->apn = apn;
+    job->ip_type = ip_type;
+    job->pool = proxies_;
+    job->modem_path = object_path();
+    job->make_connection = [conn = conn_, dispatcher = dispatcher_, pool = job->pool, modem_path = job->modem_path](
+            const sdbus::ObjectPath& path) {
+        auto locked = pool.lock();
+        if (!locked) {
+            throw ConnectionException{"DBus connection lost"};
+        }
+        return Connection{conn, path, dispatcher, std::move(locked), modem_path};
+    };
+
+    // chain: 1. bearers -> 2. CreateBearer if none matches -> 3. Connect, each from the previous reply
+    try {
+        static CallSiteRef site{DBus::MM_IF_MODEM, "Get"};
+        proxy().callMethodAsync("Get").onInterface(DBus::DBUS_IF_PROPERTIES)
+            .withArguments(DBus::MODEM_BEARERS.interface(), DBus::MODEM_BEARERS.name())
+            .withTimeout(remaining_usec(job->deadline))
+            .uponReplyInvoke([job, timer = CallTimer::start(site)](
+                    const sdbus::Error* err, const sdbus::Variant& bearers) {
+                timer.finish(err != nullptr);
+                if (err != nullptr) {
+                    job->fail(*err);
+                    return;
+                }
+                inspect_bearers_async(job, bearers.get<std::vector<sdbus::ObjectPath>>());
+            });
+    } catch (...) {
+        job->fail(std::current_exception());
+    }
+
+    return future;
+}
+
+auto Modem::lock_state_async() const -> std::future<LockState> {
+    return property_async(DBus::MODEM_UNLOCK_REQUIRED,
+                                    [](uint32_t state) { return static_cast<LockState>(state); });
+}
+
+auto Modem::operator_plmn_async() const -> std::future<std::string> {
+    return property_async(DBus::MODEM3GPP_OPERATOR_CODE, same);
+}
+
+auto Modem::operator_name_async() const -> std::future<std::string> {
+    return property_async(DBus::MODEM3GPP_OPERATOR_NAME, same);
+}
+
+auto Modem::technology_async() const -> std::future<Technology> {
+    return property_async(DBus::MODEM_ACCESS_TECHNOLOGIES, mm_tech_to_Technology);
+}
+
+auto Modem::signal_async() const -> std::future<Signal> {
+    auto join = DBus::AsyncJoin<Signal, sdbus::Variant, sdbus_variant_map>::create(
+        [proxy = hub()->shared_proxy(), rate = object_->signal_rate](
+                const sdbus::Variant& mm_tech, const sdbus_variant_map& signal_props) -> Signal {
+            // setup refresh if not done already, values will be available with the next update
+            auto current_rate = [&]() { return DBus::value_or(signal_props, DBus::SIGNAL_RATE, 0); };
+            if (!rate->ensure(*proxy, current_rate, DEFAULT_SIGNAL_RATE_SEC)) {
+                return {};  // empty signal
+            }
+
+            auto tech = mm_tech_to_Technology(mm_tech.get<uint32_t>());
+            switch (tech) {
+                case Technology::LTE:
+                    return dbus_signal_to_Signal(tech, DBus::value_or(signal_props, DBus::SIGNAL_LTE, {}));
+                case Technology::NR5G:
+                    return dbus_signal_to_Signal(tech, DBus::value_or(signal_props, DBus::SIGNAL_NR5G, {}));
+                default:
+                    throw ModemException{"signal: current technology unknown or not supported yet"};
+            }
+        });
+
+    // fetch the technology and all signal values at once
+    static CallSiteRef get_site{DBus::MM_IF_MODEM, "Get"};
+    static CallSiteRef get_all_site{DBus::MM_IF_MODEM_SIGNAL, "GetAll"};
+    proxy().callMethodAsync("Get").onInterface(DBus::DBUS_IF_PROPERTIES)
+        .withArguments(DBus::MODEM_ACCESS_TECHNOLOGIES.interface(), DBus::MODEM_ACCESS_TECHNOLOGIES.name())
+        .uponReplyInvoke(join->first(CallTimer::start(get_site)));
+    proxy().callMethodAsync("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES)
+        .withArguments(std::string{DBus::MM_IF_MODEM_SIGNAL})
+        .uponReplyInvoke(join->second(CallTimer::start(get_all_site)));
+
+    return join->get_future();
+}
+
+auto Modem::cell_info_async() const -> std::future<std::vector<CellInfo>> {
+    static CallSiteRef site{DBus::MM_IF_MODEM, "GetCellInfo"};
+    return DBus::call_async<std::vector<sdbus_variant_map>>(
+        proxy().callMethodAsync("GetCellInfo").onInterface(DBus::MM_IF_MODEM),
+        dbus_cell_info_to_CellInfos, CallTimer::start(site));
+}
+
+auto Modem::location_async() const -> std::future<Location> {
+    auto join = DBus::AsyncJoin<Location, sdbus::Variant, std::map<uint32_t, sdbus::Variant>>::create(
+        [](const sdbus::Variant& mm_tech, const std::map<uint32_t, sdbus::Variant>& location_dict) {
+            return LocationDecoder::decode(mm_tech_to_Technology(mm_tech.get<uint32_t>()), location_dict);
+        });
+
+    // fetch the technology and the location at once
+    static CallSiteRef get_site{DBus::MM_IF_MODEM, "Get"};
+    static CallSiteRef location_site{DBus::MM_IF_MODEM_LOCATION, "GetLocation"};
+    proxy().callMethodAsync("Get").onInterface(DBus::DBUS_IF_PROPERTIES)
+        .withArguments(DBus::MODEM_ACCESS_TECHNOLOGIES.interface(), DBus::MODEM_ACCESS_TECHNOLOGIES.name())
+        .uponReplyInvoke(join->first(CallTimer::start(get_site)));
+    proxy().callMethodAsync("GetLocation").onInterface(DBus::MM_IF_MODEM_LOCATION)
+        .uponReplyInvoke(join->second(CallTimer::start(location_site)));
+
+    return join->get_future();
+}
+
+auto Modem::network_time_async() const -> std::future<std::string> {
+    static CallSiteRef site{DBus::MM_IF_MODEM_TIME, "GetNetworkTime"};
+    return DBus::call_async<std::string>(
+        proxy().callMethodAsync("GetNetworkTime").onInterface(DBus::MM_IF_MODEM_TIME), same,
+        CallTimer::start(site));
+}
+
+auto Modem::network_time_epoch_async() const -> std::future<std::time_t> {
+    static CallSiteRef site{DBus::MM_IF_MODEM_TIME, "GetNetworkTime"};
+    return DBus::call_async<std::string>(
+        proxy().callMethodAsync("GetNetworkTime").onInterface(DBus::MM_IF_MODEM_TIME), iso8601_to_epoch,
+        CallTimer::start(site));
+}
+
+/* Property cache */
+
+// (private) the interfaces mirrored by the property cache
+auto Modem::cache_interfaces() -> const std::vector<std::string>& {
+    static const std::vector<std::string> interfaces = {
+        DBus::MM_IF_MODEM,
+        DBus::MM_IF_MODEM_MODEM3GPP,
+        DBus::MM_IF_MODEM_LOCATION,
+        DBus::MM_IF_MODEM_SIGNAL,
+        DBus::MM_IF_MODEM_TIME,
+    };
+    return interfaces;
+}
+
+// (private) the identity never changes, so it can be taken from any payload
+void Modem::seed_identity(const std::map<std::string, sdbus_variant_map>& interfaces_and_properties) const {
+    take_identity(object_->identity, interfaces_and_properties);
+}
+
+// (private) only for a replay: the capture is all there is, so its values are served instead of asking D-Bus
+void Modem::seed_property_cache(const std::map<std::string, sdbus_variant_map>& interfaces_and_properties) {
+    cache_ = std::make_shared<PropertyCache>(interfaces_and_properties, cache_interfaces());
+    seed_identity(interfaces_and_properties);
+}
+
+void Modem::update_property_cache(const std::map<std::string, sdbus_variant_map>& interfaces_and_properties) const {
+    if (cache_) {
+        cache_->merge(interfaces_and_properties);
+    }
+    seed_identity(interfaces_and_properties);
+}
+
+void Modem::enable_property_cache() {
+    if (cache_) {
+        return;  // already enabled
+    }
+
+    if (conn_.expired()) {
+        throw ModemException{"DBus connection lost"};
+    }
+    cache_ = std::make_shared<PropertyCache>(hub(), cache_interfaces());
+}
+
+auto Modem::property_cache_enabled() const -> bool {
+    return static_cast<bool>(cache_);
+}
+
+auto Modem::cache_generation() const -> uint64_t {
+    return cache_ ? cache_->generation() : 0;
+}
+
+auto Modem::cache_age() const -> std::chrono::steady_clock::duration {
+    if (!cache_) {
+        return std::chrono::steady_clock::duration::zero();
+    }
+    return std::chrono::steady_clock::now() - cache_->last_update();
 }
 
 } // namespace ezcellular
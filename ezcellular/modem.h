@@ -4,9 +4,12 @@
 */
 #pragma once
 
+#include <chrono>   // std::chrono::steady_clock
 #include <cstdint>  // int8_t, ...
 #include <ctime>    // time_t, timegm()
 #include <functional>  // std::function
+#include <future>   // std::future
+#include <map>      // std::map
 #include <memory>   // std::shared_ptr, std::weak_ptr
 #include <optional> // std::optional
 #include <string>   // std::string
@@ -17,11 +20,22 @@
 
 #include "connection.h"
 #include "enums.h"
+#include "filters.h"
 #include "sim.h"
 #include "structs.h"
+#include "subscription.h"
 
 namespace ezcellular {
 
+class Dispatcher; // IWYU pragma: keep
+class PropertyCache; // IWYU pragma: keep
+namespace DBus {
+template<typename T> class Prop; // IWYU pragma: keep
+} // namespace DBus
+class ProxyPool; // IWYU pragma: keep
+class SignalHub; // IWYU pragma: keep
+struct ModemSnapshot;
+
 /**
  * @brief The central Modem object.
  *
@@ -58,9 +72,19 @@ public:
      * @brief Details about the reason for a Modem with ModemState::LOCKED.
      */
     enum class LockState : int8_t;
+    /**
+     * @enum StateChangeReason
+     * @brief Why the ModemState changed, see observe_modem_state().
+     */
+    enum class StateChangeReason : uint32_t;
 
     // ---- properties and observers ----
 
+    /*
+     * The identity (manufacturer, model, IMEI, firmware version) doesn't change for the lifetime of the modem object.
+     * It is taken from the ObjectManager payload or fetched once, and then shared by all copies of the Modem.
+     */
+
     /** @brief The manufacturer name of the modem. */
     [[nodiscard]] auto manufacturer() const -> std::string;
     /** @brief The model name of the modem. */
@@ -114,8 +138,17 @@ public:
     /**
      * @brief Register a callback for ModemState updates.
      * @param observer a ModemStateObserver to register
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
      */
-    void observe_modem_state(ModemStateObserver observer);
+    [[nodiscard]] auto observe_modem_state(ModemStateObserver observer) const -> Subscription;
+    /** @brief type for callbacks needed for observe_modem_state() that want to know why the state changed */
+    using ModemStateReasonObserver = std::function<void(ModemState, ModemState, StateChangeReason)>;
+    /**
+     * @brief Register a callback for ModemState updates, along with the reason of each change.
+     * @param observer a ModemStateReasonObserver to register
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
+     */
+    [[nodiscard]] auto observe_modem_state(ModemStateReasonObserver observer) const -> Subscription;
     /**
      * @brief Enable or disable the Modem to register.
      * @param enable whether to enable or disable
@@ -139,6 +172,8 @@ public:
     [[nodiscard]] auto lock_state() const -> LockState;
     /**
      * @brief The currenty active SIM card.
+     *
+     * The SIMs returned share their proxy and identity (IMSI, ICCID), until the modem reports another SIM.
      * @return an std::optional with a SIM object if available, empty otherwise (e.g. no SIM card present)
      */
     [[nodiscard]] auto active_sim() const -> std::optional<SIM>;
@@ -158,14 +193,23 @@ public:
      * @return A std::vector Connection object, empty if there are none.
     */
     [[nodiscard]] auto connections() const -> std::vector<Connection>;
+    /** @brief default timeout of connect() */
+    static constexpr std::chrono::milliseconds DEFAULT_CONNECT_TIMEOUT{60'000};
     /**
-     * @brief Try to connect to the given APN.
+     * @brief Connect to the given APN.
+     *
+     * An existing bearer with the same APN and IP type is reused (and returned right away if it is connected already),
+     * so reconnecting doesn't pile up bearers. Only if there is none, a new bearer is created.
      * @param apn The access point name to connect to.
      * @param ip_type The IP address type for the bearer (e.g. IPv4, IPv6 or both)
+     * @param timeout for all D-Bus calls together, most of it is usually spent in the network attach
      * @todo use networkmanager to apply assigned IPs to linux network interface
      * @note Requires that the modem is ready to connect to a network.
+     * @throws ConnectionException if the bearer couldn't be connected in time
+     * @return the connected Connection
     */
-    void connect(std::string apn, IPType ip_type = IPType::IPV4_AND_IPV6);
+    auto connect(const std::string& apn, IPType ip_type = IPType::IPV4_AND_IPV6,
+                 std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT) -> Connection;
 
     /**
      * @brief The network operator PLMN.
@@ -196,9 +240,13 @@ public:
     /**
      * @brief Register a callback for periodic Signal updates.
      * @param observer the SignalObserver to register
-     * @param interval_sec the update interval in seconds
+     * @param interval_sec the update interval in seconds. With several observers, the smallest interval is used
+     *        for all of them. The previous interval is restored once the observers are unregistered.
+     * @param filter drops updates that don't change the signal significantly, see SignalFilter
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
      */
-    void observe_signal(SignalObserver observer, uint32_t interval_sec);
+    [[nodiscard]] auto observe_signal(SignalObserver observer, uint32_t interval_sec,
+                                      const SignalFilter& filter = {}) const -> Subscription;
 
     /**
      * @brief Cell information
@@ -216,9 +264,14 @@ public:
     using LocationObserver = std::function<void(Location)>;
     /**
      * @brief Register a callback for Location updates.
+     *
+     * The access technology is tracked from its change notifications, so updates are decoded without extra bus calls.
      * @param observer the LocationObserver to register
+     * @param filter e.g. drops updates that don't change the cell, see LocationFilter
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
      */
-    void observe_location(const LocationObserver& observer) const;
+    [[nodiscard]] auto observe_location(LocationObserver observer, const LocationFilter& filter = {}) const
+        -> Subscription;
 
     // Time
 
@@ -230,25 +283,168 @@ public:
     [[nodiscard]] auto network_time() const -> std::string;
     /**
      * @brief Same as network_time() but returning a std::time_t.
-     * @return the time reported by the modem as std::time_t (aka "epoch time" or "unix timestamp")
+     * @note for frequent timestamps, use a NetworkClock instead (no D-Bus call per timestamp)
+     * @return the time reported by the modem as std::time_t (aka "epoch time" or "unix timestamp"),
+     *         i.e. in UTC with the offset of the local time applied. 0 if the time is not valid.
     */
     [[nodiscard]] auto network_time_epoch() const -> std::time_t;
+    /** @brief type for callbacks needed for observe_network_time() */
+    using NetworkTimeObserver = std::function<void(NetworkTime)>;
+    /**
+     * @brief Register a callback for time updates of the network (`NetworkTimeChanged`), e.g. after registration.
+     * @note not all modems report them, see NetworkClock for a clock that is also synced on demand
+     * @param observer the NetworkTimeObserver to register
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
+     */
+    [[nodiscard]] auto observe_network_time(NetworkTimeObserver observer) const -> Subscription;
+
+    // Snapshot
+
+    /**
+     * @brief Fetch the most relevant state of the modem at once.
+     *
+     * Uses a few blocking `GetAll` calls (one per interface) instead of one call per value, each with the
+     * default method timeout. It doesn't depend on the event loop, so it can also be used in
+     * EventLoopMode::EXTERNAL and from within observer callbacks. snapshot_async() pipelines the calls instead.
+     * If the property cache is enabled, no D-Bus calls are made at all.
+     * @note Unlike signal(), this does not set up signal refreshing, see ModemSnapshot::signal.
+     * @return a ModemSnapshot
+     */
+    [[nodiscard]] auto snapshot() const -> ModemSnapshot;
+
+    // Asynchronous variants
+
+    /**
+     * @name Asynchronous variants
+     *
+     * Non-blocking versions of the methods above. They return immediately with a std::future,
+     * the replies are processed by the D-Bus event loop thread of the ModemManager.
+     * This way, many requests can be in flight at once, e.g. across several modems.
+     *
+     * Errors are reported through the future, i.e. get() then throws the sdbus::Error or ModemException.
+     * @note Unlike the synchronous methods, the ModemState is not checked beforehand,
+     *       but errors reported by ModemManager are forwarded.
+     * @note Don't wait for the future from within an observer callback, as this blocks the event loop (deadlock).
+     * @{
+     */
+    /** @brief see manufacturer() */
+    [[nodiscard]] auto manufacturer_async() const -> std::future<std::string>;
+    /** @brief see model() */
+    [[nodiscard]] auto model_async() const -> std::future<std::string>;
+    /** @brief see imei() */
+    [[nodiscard]] auto imei_async() const -> std::future<std::string>;
+    /** @brief see firmware_version() */
+    [[nodiscard]] auto firmware_version_async() const -> std::future<std::string>;
+    /** @brief see phone_number() */
+    [[nodiscard]] auto phone_number_async() const -> std::future<std::optional<std::string>>;
+    /** @brief see power_state() */
+    [[nodiscard]] auto power_state_async() const -> std::future<PowerState>;
+    /** @brief see power_off(), power_low() and power_on() */
+    [[nodiscard]] auto set_power_state_async(PowerState state) const -> std::future<void>;
+    /** @brief see state() */
+    [[nodiscard]] auto state_async() const -> std::future<ModemState>;
+    /** @brief see enable() */
+    [[nodiscard]] auto enable_async(bool enable) const -> std::future<void>;
+    /** @brief see reset() */
+    [[nodiscard]] auto reset_async() -> std::future<void>;
+    /** @brief see connect() */
+    [[nodiscard]] auto connect_async(const std::string& apn, IPType ip_type = IPType::IPV4_AND_IPV6,
+                                     std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT)
+        -> std::future<Connection>;
+    /** @brief see lock_state() */
+    [[nodiscard]] auto lock_state_async() const -> std::future<LockState>;
+    /** @brief see operator_plmn() */
+    [[nodiscard]] auto operator_plmn_async() const -> std::future<std::string>;
+    /** @brief see operator_name() */
+    [[nodiscard]] auto operator_name_async() const -> std::future<std::string>;
+    /** @brief see technology() */
+    [[nodiscard]] auto technology_async() const -> std::future<Technology>;
+    /** @brief see signal() */
+    [[nodiscard]] auto signal_async() const -> std::future<Signal>;
+    /** @brief see cell_info() */
+    [[nodiscard]] auto cell_info_async() const -> std::future<std::vector<CellInfo>>;
+    /** @brief see location() */
+    [[nodiscard]] auto location_async() const -> std::future<Location>;
+    /** @brief see network_time() */
+    [[nodiscard]] auto network_time_async() const -> std::future<std::string>;
+    /** @brief see network_time_epoch() */
+    [[nodiscard]] auto network_time_epoch_async() const -> std::future<std::time_t>;
+    /**
+     * @brief see snapshot(), with all calls in flight at once
+     * @warning The future is only fulfilled once the event loop dispatched all replies: in EventLoopMode::EXTERNAL,
+     *          keep calling ModemManager::process_pending() while waiting, and never wait on the event loop thread
+     *          (e.g. in an observer callback). Use snapshot() there.
+     */
+    [[nodiscard]] auto snapshot_async() const -> std::future<ModemSnapshot>;
+    /** @} */
+
+    // Property cache
+
+    /**
+     * @brief Serve property getters from a local cache instead of querying every value via D-Bus.
+     *
+     * The cache is filled once using one `GetAll` call per interface
+     * and then kept up to date by the `PropertiesChanged` signals of the modem.
+     * Values that are not in the cache are still fetched via D-Bus.
+     * @note Only affects this object and copies made from it afterwards.
+     * @note Opt-in, as the values are read from D-Bus now. The `GetManagedObjects` payload that lists the modems
+     *       is only used for their identity (e.g. imei()), which doesn't change. Only Modems of a replay
+     *       (see ModemManager::from_capture()) have a cache from the start, seeded from the capture.
+     */
+    void enable_property_cache();
+    /** @brief Whether the property cache is enabled, see enable_property_cache(). */
+    [[nodiscard]] auto property_cache_enabled() const -> bool;
+    /**
+     * @brief Generation counter of the property cache.
+     *
+     * Incremented with every update received from the modem.
+     * If two calls return the same value, the cached values did not change in between.
+     * @return the generation, always 0 if the cache is not enabled
+     */
+    [[nodiscard]] auto cache_generation() const -> uint64_t;
+    /**
+     * @brief Time passed since the last update of the property cache.
+     * @return the age of the newest cached value, zero if the cache is not enabled
+     */
+    [[nodiscard]] auto cache_age() const -> std::chrono::steady_clock::duration;
 
 private:
     // make constructors private to enforce creation using a ModemManager instance (ModemManagerOMProxy to be precise)
-    explicit Modem(std::weak_ptr<sdbus::IConnection>, const sdbus::ObjectPath&);
-    explicit Modem(std::weak_ptr<sdbus::IConnection>, std::shared_ptr<sdbus::IProxy>);
+    explicit Modem(std::weak_ptr<sdbus::IConnection>, const sdbus::ObjectPath&,
+                   std::shared_ptr<Dispatcher> dispatcher = nullptr, std::shared_ptr<ProxyPool> proxies = nullptr);
 
+    friend class ModemHealth;
     friend class ModemManager;
     friend class ModemManagerOMProxy;
     std::weak_ptr<sdbus::IConnection> conn_;
-    std::shared_ptr<sdbus::IProxy> dbus_proxy_;
+    struct Object;
+    std::shared_ptr<Object> object_;  // the D-Bus object, its proxy is created on first use
+    std::shared_ptr<PropertyCache> cache_;  // only set if enabled, or seeded by a replay
+    std::shared_ptr<Dispatcher> dispatcher_;  // runs the observers, see ModemManager::set_executor()
+    std::shared_ptr<ProxyPool> proxies_;  // proxies of the modem, its bearers and SIM, see ModemManager
 
     // user provided observers
     ModemStateObserver user_modemstate_observer_;
 
     // common helper methods
+    [[nodiscard]] auto hub() const -> const std::shared_ptr<SignalHub>&;
+    void attach_cache() const;
+    [[nodiscard]] auto proxy() const -> sdbus::IProxy&;
+    [[nodiscard]] auto object_path() const -> const sdbus::ObjectPath&;
+    static auto cache_interfaces() -> const std::vector<std::string>&;
+    void seed_identity(const std::map<std::string, sdbus_variant_map>& interfaces_and_properties) const;
+    void seed_property_cache(const std::map<std::string, sdbus_variant_map>& interfaces_and_properties);
+    void update_property_cache(const std::map<std::string, sdbus_variant_map>& interfaces_and_properties) const;
     void set_power_state(PowerState state) const;
+    [[nodiscard]] auto bearer_paths() const -> std::vector<sdbus::ObjectPath>;
+    [[nodiscard]] auto request_signal_rate(uint32_t interval_sec) const -> Subscription;
+    [[nodiscard]] auto identity(std::string& value, const DBus::Prop<std::string>& prop) const -> std::string;
+    [[nodiscard]] auto identity_async(std::string& value, const DBus::Prop<std::string>& prop) const
+        -> std::future<std::string>;
+    template<typename T>
+    [[nodiscard]] auto property(const DBus::Prop<T>& prop) const -> T;
+    template<typename T, typename Fn>
+    [[nodiscard]] auto property_async(const DBus::Prop<T>& prop, Fn transform) const;
 
 public:
     enum class ModemState : int8_t {
@@ -283,6 +479,33 @@ public:
         SIM_PUK2 = MM_MODEM_LOCK_SIM_PUK2  ///< modem is locked, SIM PUK2 is required to unlock
     };
 
+    enum class StateChangeReason : uint32_t {
+        UNKNOWN = MM_MODEM_STATE_CHANGE_REASON_UNKNOWN,               ///< no reason given, e.g. the network was lost
+        USER_REQUESTED = MM_MODEM_STATE_CHANGE_REASON_USER_REQUESTED, ///< requested, e.g. via enable()
+        SUSPEND = MM_MODEM_STATE_CHANGE_REASON_SUSPEND,               ///< the system is suspended or resumed
+        FAILURE = MM_MODEM_STATE_CHANGE_REASON_FAILURE,               ///< the modem failed
+    };
+
+};
+
+/**
+ * @brief Point-in-time copy of the most relevant Modem state.
+ * @see Modem::snapshot()
+ */
+struct ModemSnapshot {
+    std::chrono::steady_clock::time_point timestamp; ///< when the values were collected
+    std::string manufacturer;          ///< see Modem::manufacturer()
+    std::string model;                 ///< see Modem::model()
+    std::string imei;                  ///< see Modem::imei()
+    std::string firmware_version;      ///< see Modem::firmware_version()
+    Modem::ModemState state;           ///< see Modem::state()
+    Modem::PowerState power_state;     ///< see Modem::power_state()
+    Modem::LockState lock_state;       ///< see Modem::lock_state()
+    Technology technology;             ///< see Modem::technology()
+    std::string operator_plmn;         ///< see Modem::operator_plmn(), empty if not registered
+    std::string operator_name;         ///< see Modem::operator_name(), empty if not registered
+    Signal signal;                     ///< see Modem::signal(), Signal::empty() if not available or not set up
+    Location location;                 ///< see Modem::location(), Location::empty() if not available
 };
 
 } // namespace ezcellular
@@ -0,0 +1,315 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "modem_health.h"
+
+#include <algorithm> // std::any_of, std::find
+#include <optional>  // std::optional
+#include <utility>   // std::move
+
+#include "call_metrics.h"     // CallSiteRef, CallTimer
+#include "dbus_constants.h"
+#include "dbus_helpers.h"     // get_property
+#include "dbus_properties.h"  // Prop
+#include "dispatcher.h"       // ObserverQueue
+#include "proxy_pool.h"
+#include "signal_hub.h"
+#include "structs.h"          // Signal
+
+namespace ezcellular {
+
+using ModemState = Modem::ModemState;
+using Clock = std::chrono::steady_clock;
+
+static auto to_HealthReason(Modem::StateChangeReason reason) -> HealthReason {
+    switch (reason) {
+        case Modem::StateChangeReason::USER_REQUESTED: return HealthReason::USER_REQUESTED;
+        case Modem::StateChangeReason::SUSPEND: return HealthReason::SUSPEND;
+        case Modem::StateChangeReason::FAILURE: return HealthReason::FAILURE;
+        default: return HealthReason::STATE_CHANGED;
+    }
+}
+
+// whether the signal of one technology is lost, the threshold depends on whether it was lost before (hysteresis)
+static auto lost(const Signal& signal, const HealthOptions& options, bool was_lost) -> bool {
+    if (signal.empty()) {
+        return true;
+    }
+    if (!signal.rsrp) {
+        return false;  // reported, but without a RSRP to compare
+    }
+    auto threshold = was_lost ? options.min_rsrp + options.hysteresis : options.min_rsrp;
+    return *signal.rsrp < threshold;
+}
+
+ModemHealth::ModemHealth(const Modem& modem, const HealthOptions& options)
+    : modem_{modem}, machine_{std::make_shared<Machine>()} {
+    machine_->options = options;
+    machine_->dispatcher = modem_.dispatcher_;
+    rate_request_ = modem_.request_signal_rate(options.signal_interval_sec);
+
+    // 1. subscribe first, so that no update is missed while the initial values are read
+    auto& hub = modem_.hub();
+    std::weak_ptr<Machine> weak_machine = machine_;
+
+    // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+    state_subscription_ = hub->subscribe_state_changed([weak_machine](int32_t, int32_t new_state, uint32_t reason) {
+        auto time = Clock::now();
+        if (auto machine = weak_machine.lock()) {
+            std::lock_guard lock{machine->mutex};
+            machine->state = static_cast<ModemState>(new_state);
+            machine->state_known = true;
+            machine->transition(to_HealthReason(static_cast<Modem::StateChangeReason>(reason)), time);
+        }
+    });
+
+    signal_subscription_ = hub->subscribe_interface(DBus::MM_IF_MODEM_SIGNAL,
+        [weak_machine](const sdbus_variant_map& changed, [[maybe_unused]] const std::vector<std::string>& invalidated) {
+            auto time = Clock::now();
+            auto machine = weak_machine.lock();
+            if (!machine) {
+                return;
+            }
+            // with several technologies (e.g. 5G NSA), the signal is only lost if it is lost on all of them
+            std::lock_guard lock{machine->mutex};
+            std::optional<bool> now_lost;
+            auto check = [&](Technology tech, const DBus::Prop<sdbus_variant_map>& prop) {
+                if (auto it = changed.find(prop.name()); it != changed.end()) {
+                    auto signal = Signal::from_variant_map(tech, it->second.get<sdbus_variant_map>());
+                    now_lost = now_lost.value_or(true) && lost(signal, machine->options, machine->signal_lost);
+                }
+            };
+            check(Technology::LTE, DBus::SIGNAL_LTE);
+            check(Technology::NR5G, DBus::SIGNAL_NR5G);
+            if (now_lost) {
+                machine->signal_known = true;
+            }
+            if (!now_lost || *now_lost == machine->signal_lost) {
+                return;
+            }
+            machine->signal_lost = *now_lost;
+            machine->transition(*now_lost ? HealthReason::SIGNAL_LOST : HealthReason::SIGNAL_RESTORED, time);
+        });
+
+    std::weak_ptr<ProxyPool> weak_pool = modem_.proxies_;
+    bearers_subscription_ = hub->watch(DBus::MODEM_BEARERS,
+        [weak_machine, weak_pool, modem_path = std::string{modem_.object_path()}](
+                const std::vector<sdbus::ObjectPath>& paths) {
+            auto machine = weak_machine.lock();
+            auto pool = weak_pool.lock();
+            if (machine && pool) {
+                update_bearers(machine, *pool, modem_path, paths);
+            }
+        });
+
+    // 2. initial values, the state from the property cache if enabled. Values the handlers set meanwhile are newer.
+    auto state = modem_.state();
+    auto initially_lost = initial_signal_lost(hub->proxy(), options);
+    auto paths = modem_.bearer_paths();
+    std::map<std::string, bool> bearers;
+    std::map<std::string, Subscription> subscriptions;
+    for (const auto& path : paths) {
+        subscriptions[path] = watch_bearer(machine_, *modem_.proxies_, modem_.object_path(), path);
+        auto bearer_hub = modem_.proxies_->hub(DBus::MM_BUS_NAME, path, modem_.object_path());
+        bearers[path] = DBus::get_property(bearer_hub->proxy(), DBus::BEARER_CONNECTED);
+    }
+
+    std::lock_guard lock{machine_->mutex};
+    if (!machine_->state_known) {
+        machine_->state = state;
+    }
+    if (!machine_->signal_known) {
+        machine_->signal_lost = initially_lost;
+    }
+    for (auto& [path, connected] : bearers) {
+        // a bearer that was added in the meantime is already watched by the handler of the Bearers property
+        if (machine_->bearers.emplace(path, connected).second) {
+            machine_->bearer_subscriptions[path] = std::move(subscriptions[path]);
+        }
+    }
+    machine_->health = machine_->evaluate();
+}
+
+ModemHealth::~ModemHealth() {
+    bearers_subscription_.reset();
+    // destroyed without holding the mutex, as unsubscribing waits for a running handler (which takes it)
+    std::map<std::string, Subscription> subscriptions;
+    {
+        std::lock_guard lock{machine_->mutex};
+        subscriptions.swap(machine_->bearer_subscriptions);
+    }
+}
+
+auto ModemHealth::current() const -> Health {
+    std::lock_guard lock{machine_->mutex};
+    return machine_->health;
+}
+
+auto ModemHealth::bearer_connected() const -> bool {
+    std::lock_guard lock{machine_->mutex};
+    const auto& bearers = machine_->bearers;
+    return std::any_of(bearers.begin(), bearers.end(), [](const auto& bearer) { return bearer.second; });
+}
+
+auto ModemHealth::signal_lost() const -> bool {
+    std::lock_guard lock{machine_->mutex};
+    return machine_->signal_lost;
+}
+
+auto ModemHealth::observe(HealthObserver observer) -> Subscription {
+    std::lock_guard lock{machine_->mutex};
+    auto id = machine_->next_id++;
+    machine_->observers.emplace(id, std::make_pair(ObserverQueue::create(machine_->dispatcher), std::move(observer)));
+
+    return Subscription{[weak_machine = std::weak_ptr<Machine>{machine_}, id]() {
+        if (auto machine = weak_machine.lock()) {
+            std::lock_guard lock{machine->mutex};
+            machine->observers.erase(id);
+        }
+    }};
+}
+
+auto ModemHealth::Machine::evaluate() const -> Health {
+    switch (state) {
+        case ModemState::LOCKED:
+            return Health::LOCKED;
+        case ModemState::ENABLED:
+        case ModemState::SEARCHING:
+            return Health::SEARCHING;
+        case ModemState::REGISTERED:
+        case ModemState::DISCONNECTING:
+        case ModemState::CONNECTING:
+        case ModemState::CONNECTED: {
+            if (signal_lost) {
+                return Health::DEGRADED;
+            }
+            bool connected = std::any_of(bearers.begin(), bearers.end(), [](const auto& bearer) {
+                return bearer.second;
+            });
+            return connected ? Health::CONNECTED : Health::REGISTERED;
+        }
+        default:
+            return Health::DOWN;
+    }
+}
+
+void ModemHealth::Machine::transition(HealthReason reason, Clock::time_point time) {
+    auto next = evaluate();
+    if (next == health) {
+        return;  // edge-triggered: only transitions are delivered
+    }
+
+    HealthEvent event{health, next, reason, state, time};
+    health = next;
+    for (const auto& entry : observers) {
+        const auto& [queue, observer] = entry.second;
+        queue->post([observer = observer, event]() { observer(event); });
+    }
+}
+
+// (private) whether the current signal values are lost, false if there are none (e.g. no refresh rate is set)
+auto ModemHealth::initial_signal_lost(sdbus::IProxy& proxy, const HealthOptions& options) -> bool {
+    std::optional<bool> now_lost;
+    auto check = [&](Technology tech, const DBus::Prop<sdbus_variant_map>& prop) {
+        sdbus_variant_map values;
+        try {
+            values = DBus::get_property(proxy, prop);
+        } catch (const sdbus::Error&) {
+            return;  // e.g. no .Modem.Signal interface
+        }
+        auto signal = Signal::from_variant_map(tech, values);
+        if (!signal.empty()) {  // unlike in an update, no values doesn't mean lost here
+            now_lost = now_lost.value_or(true) && lost(signal, options, false);
+        }
+    };
+    check(Technology::LTE, DBus::SIGNAL_LTE);
+    check(Technology::NR5G, DBus::SIGNAL_NR5G);
+    return now_lost.value_or(false);
+}
+
+// (private) watch the Connected property of a bearer, the returned handle must be stored in bearer_subscriptions
+auto ModemHealth::watch_bearer(const std::shared_ptr<Machine>& machine, ProxyPool& proxies,
+                               const std::string& modem_path, const std::string& path) -> Subscription {
+    auto hub = proxies.hub(DBus::MM_BUS_NAME, path, modem_path);
+    return hub->watch(DBus::BEARER_CONNECTED, [weak_machine = std::weak_ptr<Machine>{machine}, path](bool connected) {
+        bearer_changed(weak_machine, path, connected);
+    });
+}
+
+// (private) read the Connected property of a watched bearer once, without blocking the event loop
+void ModemHealth::read_bearer(const std::shared_ptr<Machine>& machine, ProxyPool& proxies,
+                              const std::string& modem_path, const std::string& path) {
+    static CallSiteRef site{DBus::MM_IF_BEARER, "Get"};
+    auto hub = proxies.hub(DBus::MM_BUS_NAME, path, modem_path);
+    hub->proxy().callMethodAsync("Get").onInterface(DBus::DBUS_IF_PROPERTIES)
+        .withArguments(DBus::BEARER_CONNECTED.interface(), DBus::BEARER_CONNECTED.name())
+        .uponReplyInvoke([weak_machine = std::weak_ptr<Machine>{machine}, path, timer = CallTimer::start(site)](
+                const sdbus::Error* err, const sdbus::Variant& value) {
+            timer.finish(err != nullptr);
+            if (err != nullptr || !value.containsValueOfType<bool>()) {
+                return;  // e.g. the bearer is gone again, its removal is handled by update_bearers()
+            }
+            // after the match was registered, so a later change arrives after this reply
+            bearer_changed(weak_machine, path, value.get<bool>());
+        });
+}
+
+// (private) a new value of the Connected property of a bearer, from its signal or read_bearer()
+void ModemHealth::bearer_changed(const std::weak_ptr<Machine>& weak_machine, const std::string& path, bool connected) {
+    auto time = Clock::now();
+    auto machine = weak_machine.lock();
+    if (!machine) {
+        return;
+    }
+    std::lock_guard lock{machine->mutex};
+    auto it = machine->bearers.find(path);
+    if (it == machine->bearers.end() || it->second == connected) {
+        return;
+    }
+    it->second = connected;
+    machine->transition(connected ? HealthReason::BEARER_CONNECTED : HealthReason::BEARER_DISCONNECTED, time);
+}
+
+// (private) follow the bearers of the modem, called with each new value of the Bearers property
+void ModemHealth::update_bearers(const std::shared_ptr<Machine>& machine, ProxyPool& proxies,
+                                 const std::string& modem_path, const std::vector<sdbus::ObjectPath>& paths) {
+    auto time = Clock::now();
+    std::vector<std::string> added;
+    std::map<std::string, Subscription> removed;  // destroyed without holding the mutex, see ~ModemHealth()
+
+    std::unique_lock lock{machine->mutex};
+    for (auto it = machine->bearers.begin(); it != machine->bearers.end();) {
+        if (std::find(paths.begin(), paths.end(), it->first) == paths.end()) {
+            removed[it->first] = std::move(machine->bearer_subscriptions[it->first]);
+            machine->bearer_subscriptions.erase(it->first);
+            it = machine->bearers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& path : paths) {
+        if (machine->bearers.count(path) == 0) {
+            added.push_back(path);
+        }
+    }
+    if (!removed.empty()) {
+        machine->transition(HealthReason::BEARER_DISCONNECTED, time);
+    }
+    lock.unlock();
+
+    // a new bearer may have connected before its match was registered: watch it, then read its state once
+    for (const auto& path : added) {
+        auto subscription = watch_bearer(machine, proxies, modem_path, path);
+        {
+            std::lock_guard guard{machine->mutex};
+            if (!machine->bearers.emplace(path, false).second) {
+                continue;  // added by another update meanwhile, which reads it
+            }
+            machine->bearer_subscriptions[path] = std::move(subscription);
+        }
+        read_bearer(machine, proxies, modem_path, path);
+    }
+}
+
+} // namespace ezcellular
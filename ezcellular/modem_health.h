@@ -0,0 +1,173 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <chrono>     // std::chrono::steady_clock
+#include <cstdint>    // uint8_t, uint32_t
+#include <functional> // std::function
+#include <map>        // std::map
+#include <memory>     // std::shared_ptr
+#include <mutex>      // std::mutex
+#include <string>     // std::string
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+#include "modem.h"
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+class Dispatcher; // IWYU pragma: keep
+class ObserverQueue; // IWYU pragma: keep
+class ProxyPool; // IWYU pragma: keep
+
+/**
+ * @brief How usable a modem is, from worst to best, see ModemHealth.
+ */
+enum class Health : uint8_t {
+    DOWN,       ///< failed, disabled or not ready (yet), see Modem::ModemState
+    LOCKED,     ///< the SIM needs to be unlocked, see Modem::lock_state()
+    SEARCHING,  ///< enabled, but not registered in a network
+    DEGRADED,   ///< registered, but the signal is lost or below HealthOptions::min_rsrp
+    REGISTERED, ///< registered, no data connection
+    CONNECTED,  ///< registered, with a connected bearer (see Connection::active())
+};
+
+/**
+ * @brief Why the Health changed, see HealthEvent.
+ */
+enum class HealthReason : uint8_t {
+    STATE_CHANGED,       ///< the ModemState changed, see Modem::StateChangeReason::UNKNOWN
+    USER_REQUESTED,      ///< the ModemState changed on request, e.g. via Modem::enable()
+    SUSPEND,             ///< the ModemState changed as the system is suspended or resumed
+    FAILURE,             ///< the ModemState changed as the modem failed
+    SIGNAL_LOST,         ///< the signal disappeared or dropped below HealthOptions::min_rsrp
+    SIGNAL_RESTORED,     ///< the signal recovered, see HealthOptions::hysteresis
+    BEARER_CONNECTED,    ///< a bearer connected
+    BEARER_DISCONNECTED, ///< the last connected bearer disconnected (or was deleted)
+};
+
+/**
+ * @brief A transition of the Health of a modem, see ModemHealth::observe().
+ */
+struct HealthEvent {
+    Health previous;                            ///< the health before
+    Health current;                             ///< the health now, never equal to previous
+    HealthReason reason;                        ///< the update that caused the transition
+    Modem::ModemState state;                    ///< the ModemState at the time of the transition
+    std::chrono::steady_clock::time_point time; ///< when the update was received
+};
+
+/**
+ * @brief When ModemHealth considers the signal lost, see Health::DEGRADED.
+ */
+struct HealthOptions {
+    double min_rsrp = -120.0; ///< lost below this RSRP (in dBm), used if the modem reports a RSRP
+    double hysteresis = 3.0;  ///< restored once the RSRP is this much (in dB) above min_rsrp again
+    /**
+     * @brief Signal update interval to request, see Modem::observe_signal().
+     *
+     * 0 leaves the interval to other observers, signal values only arrive if such an interval is set.
+     * Without signal values, the signal is not considered lost.
+     */
+    uint32_t signal_interval_sec = 0;
+};
+
+/**
+ * @brief Event-driven health of one modem: a small state machine fed by the signals of the modem.
+ *
+ * Instead of polling Modem::state(), Modem::signal() or Modem::active_connection(), the health is derived from
+ * the `StateChanged` signal (with its reason), the `PropertiesChanged` signals of `.Modem.Signal` and of the bearers.
+ * Only transitions are delivered, e.g. a lost registration costs a single callback.
+ *
+ * The health is initialized once on construction, from the state (via the property cache, if enabled, see
+ * Modem::enable_property_cache()) and the signal values of the modem, and the `Connected` property of each bearer.
+ * Updates received while these are read take precedence.
+ *
+ * @code
+ * ModemHealth health{*modem};
+ * auto subscription = health.observe([](const HealthEvent& event) {
+ *     if (event.current < Health::REGISTERED) {
+ *         std::cerr << "modem unhealthy: " << event.current << " (" << event.reason << ")\n";
+ *     }
+ * });
+ * @endcode
+ * @note must not be constructed from within an observer callback (reads the initial values)
+ */
+class ModemHealth {
+public:
+    /** @brief type for callbacks needed for observe() */
+    using HealthObserver = std::function<void(const HealthEvent&)>;
+
+    /**
+     * @brief Start following the modem.
+     * @param modem the modem, copied
+     * @param options see HealthOptions
+     */
+    explicit ModemHealth(const Modem& modem, const HealthOptions& options = {});
+    /** @brief Stop following the modem, pending transitions are still delivered. */
+    ~ModemHealth();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    ModemHealth(const ModemHealth&) = delete;
+    ModemHealth& operator=(const ModemHealth&) = delete;
+    ModemHealth(ModemHealth&&) = delete;
+    ModemHealth& operator=(ModemHealth&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /** @brief the current health */
+    [[nodiscard]] auto current() const -> Health;
+    /** @brief whether at least one bearer is connected */
+    [[nodiscard]] auto bearer_connected() const -> bool;
+    /** @brief whether the signal is lost, see Health::DEGRADED */
+    [[nodiscard]] auto signal_lost() const -> bool;
+
+    /**
+     * @brief Register a callback for health transitions.
+     * @param observer a HealthObserver to register, run by the executor of the modem (see ModemManager)
+     * @return the handle of the observer, the observer is unregistered when it is destroyed
+     */
+    [[nodiscard]] auto observe(HealthObserver observer) -> Subscription;
+
+private:
+    // the state machine, shared with the signal handlers
+    struct Machine {
+        HealthOptions options;
+        std::shared_ptr<Dispatcher> dispatcher;  // runs the observers, see Modem
+
+        std::mutex mutex;  // protects the members below
+        Modem::ModemState state{};
+        bool state_known = false;  // set by a StateChanged signal, newer than the initial value
+        bool signal_lost = false;
+        bool signal_known = false;  // set by a signal update, newer than the initial value
+        std::map<std::string, bool> bearers;  // object path -> connected
+        std::map<std::string, Subscription> bearer_subscriptions;  // object path -> watch of Connected
+        Health health = Health::DOWN;
+        std::map<uint64_t, std::pair<std::shared_ptr<ObserverQueue>, HealthObserver>> observers;
+        uint64_t next_id = 1;
+
+        [[nodiscard]] auto evaluate() const -> Health;  // must hold mutex
+        void transition(HealthReason reason, std::chrono::steady_clock::time_point time);  // must hold mutex
+    };
+
+    Modem modem_;
+    std::shared_ptr<Machine> machine_;
+    Subscription rate_request_;
+    Subscription state_subscription_;
+    Subscription signal_subscription_;
+    Subscription bearers_subscription_;
+
+    static auto initial_signal_lost(sdbus::IProxy& proxy, const HealthOptions& options) -> bool;
+    // the handlers only keep the machine and the pool, not the modem, which owns them
+    static auto watch_bearer(const std::shared_ptr<Machine>& machine, ProxyPool& proxies,
+                             const std::string& modem_path, const std::string& path) -> Subscription;
+    static void read_bearer(const std::shared_ptr<Machine>& machine, ProxyPool& proxies,
+                            const std::string& modem_path, const std::string& path);
+    static void bearer_changed(const std::weak_ptr<Machine>& weak_machine, const std::string& path, bool connected);
+    static void update_bearers(const std::shared_ptr<Machine>& machine, ProxyPool& proxies,
+                               const std::string& modem_path, const std::vector<sdbus::ObjectPath>& paths);
+};
+
+} // namespace ezcellular
@@ -4,13 +4,37 @@
 */
 #include "modem_manager.h"
 
-#include <algorithm> // std::remove_if
-#include <map>       // std::map
-#include <string>    // std::string
-#include <utility>   // std::pair, std::move
+#include <algorithm>    // std::find, std::max, std::min
+#include <array>        // std::array
+#include <cerrno>       // errno
+#include <chrono>       // std::chrono::steady_clock
+#include <exception>    // std::current_exception
+#include <future>       // std::promise
+#include <limits>       // std::numeric_limits
+#include <map>          // std::map
+#include <memory>       // std::shared_ptr
+#include <mutex>        // std::mutex
+#include <string>       // std::string
+#include <system_error> // std::system_error
+#include <thread>       // std::thread, std::this_thread::sleep_until
+#include <utility>      // std::pair, std::move
 
+#include <poll.h>        // poll
+#include <sys/eventfd.h> // eventfd
+#include <time.h>        // clock_gettime
+#include <unistd.h>      // write, close
+
+#include "any_map.h"  // sdbus_variant_map
+#include "capture.h"  // CaptureTap, CaptureReader
 #include "dbus_constants.h"
+#include "dbus_helpers.h"  // get_property
+#include "dispatcher.h"
 #include "exception.h"
+#include "modem_registry.h"
+#include "modem_waiters.h"
+#include "proxy_pool.h"
+#include "signal_hub.h"
+#include "snapshot_slots.h"  // SnapshotSlots
 
 namespace ezcellular {
 
@@ -30,10 +54,21 @@ public:
     /**
      * @brief Constructor. Only to be invoked through the ModemManager class.
      * @param conn the D-Bus connection to use
+     * @param dispatcher passed on to the Modems
+     * @param proxies passed on to the Modems, evicted from once an object is removed
+     * @param replay if set, the modems are taken from this capture instead, and no signals are received
+     * @throws ModemManagerException if the capture holds no `GetManagedObjects` reply
      */
-    explicit ModemManagerOMProxy(std::shared_ptr<sdbus::IConnection> conn)
-        : ProxyInterfaces{*conn, DBus::MM_BUS_NAME, DBus::MM_OBJ_MODEMMANAGER}, conn_{std::move(conn)} {
+    explicit ModemManagerOMProxy(std::shared_ptr<sdbus::IConnection> conn, std::shared_ptr<Dispatcher> dispatcher,
+                                 std::shared_ptr<ProxyPool> proxies, CaptureReader* replay = nullptr)
+        : ProxyInterfaces{*conn, DBus::MM_BUS_NAME, DBus::MM_OBJ_MODEMMANAGER}, conn_{std::move(conn)},
+          dispatcher_{std::move(dispatcher)}, proxies_{std::move(proxies)} {
+        if (replay != nullptr) {
+            handleCaptured(*replay);
+            return;
+        }
         registerProxy();
+        registered_ = true;
         handleExisting();
     }
 
@@ -45,121 +80,555 @@ public:
     // NOLINTEND(*-trailing-return-type)
 
     virtual ~ModemManagerOMProxy() {
-        unregisterProxy();
+        if (registered_) {
+            unregisterProxy();
+        }
     }
 
     /**
-     * @brief Returns a (non-owning) reference to all Modems present
+     * @brief Returns a snapshot of the registry of all Modems present.
+     *
+     * The snapshot is immutable and stays valid as long as it is referenced, even if modems come and go meanwhile.
+     * Lock-free, may be called from any thread; never waits for a writer (see SnapshotSlots).
      */
-    auto getModems() -> std::vector<Modem>& {
-        return modems_;
+    auto registry() const -> std::shared_ptr<const ModemRegistry> {
+        return registry_.load();
     }
 
     /**
-     * @brief Register to be notified when a modem becomes available
-     *
-     * @param imei the modem's IMEI or ANY_IMEI
-     * @note will cancel waiting for other modems
-     * @return std::future<Modem>
+     * @brief The pending waiters, notified when a modem becomes available
      */
+    auto waiters() const -> const std::shared_ptr<ModemWaiters>& {
+        return waiters_;
+    }
 
-    auto await_modem(std::string imei) {
-        if (awaited_modem_) {
-            awaited_modem_->second.set_exception(
-                std::make_exception_ptr(ModemManagerException{"Cancelled, awaiting other modem now."}));
+    /**
+     * @brief Record the current `GetManagedObjects` reply, the starting point of a replay.
+     * @note blocks on a D-Bus call
+     */
+    void capture_existing() {
+        auto managed_objs = GetManagedObjects();
+        proxies_->capture()->record(CaptureKind::REPLY, DBus::MM_OBJ_MODEMMANAGER, DBus::DBUS_IF_OBJECT_MANAGER,
+                                    "GetManagedObjects", managed_objs);
+    }
+
+    /** @brief Handle an InterfacesAdded signal, also used for replay. */
+    void interfaces_added(const sdbus::ObjectPath& objectPath,
+                          const ModemRegistry::InterfacesAndProperties& interfacesAndProperties) {
+        std::lock_guard lock{write_mutex_};
+
+        // waiters wait for a modem to appear: not for new interfaces of a known one, unless its IMEI is new
+        const auto& current = registry_.current();
+        bool appeared = current.by_path(objectPath) == nullptr;
+        bool imei_known = !current.imei_of(objectPath).empty();
+
+        auto next = std::make_shared<ModemRegistry>(current);
+        const auto* modem = add_to(*next, objectPath, interfacesAndProperties);
+        if (modem == nullptr) {
+            return;
+        }
+        auto notified = *modem;  // copy, before next is published
+        auto imei = next->imei_of(objectPath);
+        publish(std::move(next));
+        if (appeared || (!imei_known && !imei.empty())) {
+            waiters_->notify(notified, objectPath, imei, appeared);
+        }
+    }
+
+    /** @brief Handle an InterfacesRemoved signal, also used for replay. */
+    void interfaces_removed(const sdbus::ObjectPath& objectPath, const std::vector<std::string>& interfaces) {
+        // the object is gone with its .Modem interface, other interfaces may come and go with the modem state
+        if (std::find(interfaces.begin(), interfaces.end(), DBus::MM_IF_MODEM) == interfaces.end()) {
+            return;
+        }
+        {
+            std::lock_guard lock{write_mutex_};
+            if (registry_.current().by_path(objectPath) != nullptr) {
+                auto next = std::make_shared<ModemRegistry>(registry_.current());
+                next->erase(objectPath);
+                publish(std::move(next));
+            }
         }
-        awaited_modem_ = std::make_pair<std::string, std::promise<Modem>>(std::move(imei), {});
-        return awaited_modem_->second.get_future();
+        proxies_->evict(objectPath);  // along with its bearers and SIM, Modem copies keep theirs alive
     }
 
 private:
+    using ManagedObjects = std::map<sdbus::ObjectPath, ModemRegistry::InterfacesAndProperties>;
+
     std::shared_ptr<sdbus::IConnection> conn_;
-    std::vector<Modem> modems_;
-    std::optional<std::pair<std::string, std::promise<Modem>>> awaited_modem_;
+    std::shared_ptr<Dispatcher> dispatcher_;
+    std::shared_ptr<ProxyPool> proxies_;
+    // read-copy-update: readers load the current snapshot, writers publish a modified copy
+    SnapshotSlots<ModemRegistry> registry_{std::make_shared<const ModemRegistry>()};
+    std::mutex write_mutex_;  // serializes writers only, e.g. if the event loop is processed on several threads
+    std::shared_ptr<ModemWaiters> waiters_ = std::make_shared<ModemWaiters>();  // shared with pending resets
+    bool registered_ = false;  // whether signals are received, not when replaying
 
+    // the payload contains all properties, so no further D-Bus call and no proxy is needed per modem
     void handleExisting() {
-        auto managed_objs = GetManagedObjects();
+        add_existing(GetManagedObjects());
+    }
+
+    // the same from the first GetManagedObjects reply of a capture, the records before it are replayed anyway
+    void handleCaptured(CaptureReader& capture) {
+        CaptureRecord record;
+        bool malformed = false;
+        while (capture.next(record, malformed)) {
+            if (record.kind == CaptureKind::REPLY && record.member == "GetManagedObjects") {
+                ManagedObjects managed_objs;
+                if (decode_value(record.payload, managed_objs) && record.payload.at_end()) {
+                    add_existing(managed_objs);
+                    capture.rewind();
+                    return;
+                }
+            }
+        }
+        throw ModemManagerException("capture holds no GetManagedObjects reply");
+    }
+
+    void add_existing(const ManagedObjects& managed_objs) {
+        std::lock_guard lock{write_mutex_};
+        auto next = std::make_shared<ModemRegistry>(registry_.current());
         for (const auto& [path, ifacesAndProps] : managed_objs) {  // structured binding (C++17)
-            onInterfacesAdded(path, ifacesAndProps);
+            add_to(*next, path, ifacesAndProps);
         }
+        publish(std::move(next));
     }
 
-    // called, if a new modem is added
-    void onInterfacesAdded(const sdbus::ObjectPath& objectPath,
-                           [[maybe_unused]] const std::map<std::string, std::map<std::string, sdbus::Variant>>& interfacesAndProperties) override {
-        Modem new_modem{conn_, objectPath};  // private ctor, but friend class
+    // publish a modified copy of the registry, must hold write_mutex_
+    void publish(std::shared_ptr<const ModemRegistry> next) {
+        registry_.store(std::move(next));
+    }
 
-        if (awaited_modem_) {
-            auto awaited_imei = awaited_modem_->first;
-            auto new_imei = new_modem.imei();
+    // add a modem to the registry, or update an existing one. Returns the modem, nullptr if the object is none.
+    auto add_to(ModemRegistry& registry, const sdbus::ObjectPath& objectPath,
+                const ModemRegistry::InterfacesAndProperties& interfacesAndProperties) -> const Modem* {
+        // the IMEI is part of the payload, no need to ask the modem (blocking the event loop)
+        auto imei = ModemRegistry::imei_from_payload(interfacesAndProperties);
 
-            if (awaited_imei == ANY_IMEI || awaited_imei == new_imei) {
-                awaited_modem_->second.set_value(new_modem);  // fulfill future
-                awaited_modem_.reset(); // make the std::optional empty
-            }
+        if (const auto* known = registry.by_path(objectPath)) {
+            known->update_property_cache(interfacesAndProperties);
+            registry.update_imei(objectPath, imei);
+            return known;
+        }
+        if (interfacesAndProperties.count(DBus::MM_IF_MODEM) == 0) {
+            return nullptr;  // not a modem
         }
 
-        modems_.push_back(std::move(new_modem));  // emplace_back() would not be able to access the private ctor
+        // private ctor, but friend class
+        Modem modem{conn_, objectPath, dispatcher_, proxies_};
+        if (registered_) {
+            modem.seed_identity(interfacesAndProperties);  // the values would be stale once read, see Modem
+        } else {
+            modem.seed_property_cache(interfacesAndProperties);  // replay: kept current by the replayed signals
+        }
+        return &registry.insert(objectPath, std::move(modem), imei);
+    }
+
+    // called, if a new modem is added, or interfaces are added to an existing one (e.g. once it's initialized)
+    void onInterfacesAdded(const sdbus::ObjectPath& objectPath,
+                           const std::map<std::string, std::map<std::string, sdbus::Variant>>& interfacesAndProperties) override {
+        proxies_->capture()->record(CaptureKind::SIGNAL, DBus::MM_OBJ_MODEMMANAGER, DBus::DBUS_IF_OBJECT_MANAGER,
+                                    "InterfacesAdded", objectPath, interfacesAndProperties);
+        interfaces_added(objectPath, interfacesAndProperties);
     }
 
     void onInterfacesRemoved(const sdbus::ObjectPath& objectPath,
-                             [[maybe_unused]] const std::vector<std::string>& interfaces) override {
-        (void) std::remove_if(modems_.begin(), modems_.end(), [&](const Modem& m) {
-            return m.dbus_proxy_->getObjectPath() == objectPath;
-        });
+                             const std::vector<std::string>& interfaces) override {
+        proxies_->capture()->record(CaptureKind::SIGNAL, DBus::MM_OBJ_MODEMMANAGER, DBus::DBUS_IF_OBJECT_MANAGER,
+                                    "InterfacesRemoved", objectPath, interfaces);
+        interfaces_removed(objectPath, interfaces);
+    }
+};
+
+/**
+ * @brief Processes the messages of a connection on its own thread, for EventLoopMode::INTERNAL_THREAD.
+ *
+ * Unlike `IConnection::enterEventLoopAsync()`, stopping it doesn't stop the event loop of the connection,
+ * which may be shared with others.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class EventLoopThread {
+public:
+    /** @brief Start processing conn, which must outlive this object. */
+    explicit EventLoopThread(sdbus::IConnection& conn) : conn_{conn} {
+        stop_fd_ = ::eventfd(0, EFD_CLOEXEC);
+        if (stop_fd_ < 0) {
+            throw std::system_error{errno, std::generic_category(), "eventfd"};
+        }
+        thread_ = std::thread{&EventLoopThread::run, this};
+    }
+    /** @brief Stop and join the thread, messages received in the meantime are processed by the next loop. */
+    ~EventLoopThread() {
+        uint64_t one = 1;
+        static_cast<void>(::write(stop_fd_, &one, sizeof(one)));
+        thread_.join();
+        ::close(stop_fd_);
+    }
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    EventLoopThread(const EventLoopThread&) = delete;
+    EventLoopThread& operator=(const EventLoopThread&) = delete;
+    EventLoopThread(EventLoopThread&&) = delete;
+    EventLoopThread& operator=(EventLoopThread&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+private:
+    // wake up at least this often: a blocking call on another thread may queue messages without the fd getting ready
+    static constexpr int MAX_POLL_TIMEOUT_MS = 100;
+
+    sdbus::IConnection& conn_;
+    int stop_fd_ = -1;
+    std::thread thread_;
+
+    void run() {
+        for (;;) {
+            while (conn_.processPendingRequest()) {
+            }
+            auto poll_data = conn_.getEventLoopPollData();
+            int timeout_ms = ModemManager::poll_timeout_ms(poll_data);
+            if (timeout_ms < 0 || timeout_ms > MAX_POLL_TIMEOUT_MS) {
+                timeout_ms = MAX_POLL_TIMEOUT_MS;
+            }
+            std::array<pollfd, 2> fds{{{poll_data.fd, poll_data.events, 0}, {stop_fd_, POLLIN, 0}}};
+            if (::poll(fds.data(), fds.size(), timeout_ms) < 0 && errno != EINTR) {
+                return;
+            }
+            if ((fds[1].revents & POLLIN) != 0) {
+                return;  // stopped
+            }
+        }
     }
 };
 
 ModemManager::ModemManager()
-    : conn_{sdbus::createSystemBusConnection()} {
+    : ModemManager{sdbus::createSystemBusConnection(), EventLoopMode::INTERNAL_THREAD, true} {}
+
+ModemManager::ModemManager(std::shared_ptr<sdbus::IConnection> conn, EventLoopMode mode)
+    : ModemManager{std::move(conn), mode, false} {}
+
+// (private) own_connection: whether the connection was created for this instance, so its event loop can be used
+ModemManager::ModemManager(std::shared_ptr<sdbus::IConnection> conn, EventLoopMode mode, bool own_connection)
+    : conn_{std::move(conn)}, mode_{mode}, dispatcher_{std::make_shared<Dispatcher>()},
+      proxies_{std::make_shared<ProxyPool>(conn_)} {
+    auto start = std::chrono::steady_clock::now();
+
+    if (!conn_) {
+        throw ModemManagerException("No D-Bus connection given");
+    }
 
     try {
-        mm_proxy_ = std::make_unique<ModemManagerOMProxy>(conn_);
+        mm_proxy_ = std::make_unique<ModemManagerOMProxy>(conn_, dispatcher_, proxies_);
     } catch (const sdbus::Error&) {
         throw ModemManagerException("Failed to connect to ModemManager D-Bus API, is ModemManager running?");
     }
+    startup_duration_ = std::chrono::steady_clock::now() - start;  // the registry is complete now
+
+    if (mode_ == EventLoopMode::INTERNAL_THREAD) {
+        if (own_connection) {
+            // process event loop on separate thread
+            conn_->enterEventLoopAsync();
+            owns_event_loop_ = true;
+        } else {
+            loop_ = std::make_unique<EventLoopThread>(*conn_);  // the caller's connection, leave its loop alone
+        }
+    }
+}
+
+// (private) offline, see from_capture()
+ModemManager::ModemManager(std::shared_ptr<sdbus::IConnection> conn, std::shared_ptr<CaptureReader> replay)
+    : conn_{std::move(conn)}, mode_{EventLoopMode::EXTERNAL}, dispatcher_{std::make_shared<Dispatcher>()},
+      proxies_{std::make_shared<ProxyPool>(conn_)}, replay_{std::move(replay)} {
+    auto start = std::chrono::steady_clock::now();
 
-    // process event loop on separate thread
-    conn_->enterEventLoopAsync();
+    if (!conn_) {
+        throw ModemManagerException("No D-Bus connection given");
+    }
+    mm_proxy_ = std::make_unique<ModemManagerOMProxy>(conn_, dispatcher_, proxies_, replay_.get());
+    startup_duration_ = std::chrono::steady_clock::now() - start;
 }
 
-ModemManager::~ModemManager() = default;
+ModemManager::~ModemManager() {
+    // stop our thread, the connection may be shared and outlive this instance
+    loop_.reset();
+    if (conn_ && owns_event_loop_) {
+        conn_->leaveEventLoop();
+    }
+}
 
 auto ModemManager::modems_available() const -> bool {
-    return mm_proxy_->getModems().empty();
+    return !mm_proxy_->registry()->empty();
 }
 
 auto ModemManager::any_modem() const -> std::optional<Modem> {
-    auto modems = mm_proxy_->getModems();
+    auto registry = mm_proxy_->registry();
+    const auto& modems = registry->modems();
     if (modems.empty()) {
         return {}; // empty optional
     }
-    return modems.at(0); // implicit copy
+    return modems.front(); // copy of this modem only
 }
 
-auto ModemManager::await_modem(std::string imei) const -> std::future<Modem> {
-    return mm_proxy_->await_modem(std::move(imei));
+auto ModemManager::modem_by_imei(const std::string& imei) const -> std::optional<Modem> {
+    auto registry = mm_proxy_->registry();
+    if (const auto* modem = registry->by_imei(imei)) {
+        return *modem;
+    }
+    return {}; // empty optional
 }
 
-auto ModemManager::available_modems() const -> std::vector<Modem> {
-    return mm_proxy_->getModems(); // implicit copy
+auto ModemManager::await_modem(std::string imei, std::chrono::milliseconds timeout) const -> std::future<Modem> {
+    return mm_proxy_->waiters()->add(std::move(imei), timeout).second;
 }
 
-auto ModemManager::reset_modem(Modem& modem) const -> Modem {
-    auto imei = modem.imei(); // get the IMEI to identify the restarted modem
+auto ModemManager::available_modems() const -> std::vector<Modem> {
+    return mm_proxy_->registry()->modems(); // implicit copy
+}
 
-    // register promise
-    auto fut = await_modem(std::move(imei));
-    // perform reset
-    modem.reset();
+auto ModemManager::reset_modem(Modem& modem, std::chrono::milliseconds timeout) const -> Modem {
+    std::vector<Modem> modems{modem};
+    auto futures = reset_modems(modems, timeout);
     // wait until restarted
-    fut.wait();
-    return fut.get();
+    return futures.front().get();
+}
+
+auto ModemManager::reset_modems(std::vector<Modem>& modems, std::chrono::milliseconds timeout) const
+    -> std::vector<std::future<Modem>> {
+    std::vector<std::future<Modem>> futures;
+    futures.reserve(modems.size());
+
+    auto registry = mm_proxy_->registry();
+    const auto& waiters = mm_proxy_->waiters();
+
+    for (auto& modem : modems) {
+        const auto& path = modem.object_path();
+
+        // get the IMEI to identify the restarted modem, without a D-Bus call if possible
+        auto imei = registry->imei_of(path);
+        if (imei.empty()) {
+            try {
+                imei = modem.imei();
+            } catch (...) {
+                std::promise<Modem> failed;
+                failed.set_exception(std::current_exception());
+                futures.push_back(failed.get_future());
+                continue;  // the other modems are reset anyway
+            }
+        }
+
+        // register promise before the reset, the modem may be back before the reply;
+        // it gets a new object path once restarted, so ignore the current one
+        auto [id, future] = waiters->add(std::move(imei), timeout, path);
+        futures.push_back(std::move(future));
+
+        // perform reset, without waiting for the reply: all modems restart in parallel
+        try {
+            modem.proxy().callMethodAsync("Reset").onInterface(DBus::MM_IF_MODEM)
+                .uponReplyInvoke([weak_waiters = std::weak_ptr<ModemWaiters>{waiters}, id = id](
+                        const sdbus::Error* err) {
+                    if (err == nullptr) {
+                        return;  // the modem is restarting, the future is fulfilled once it's back
+                    }
+                    if (auto waiters = weak_waiters.lock()) {
+                        auto error = ModemException{"reset failed: " + err->getMessage()};
+                        waiters->fail(id, std::make_exception_ptr(error));
+                    }
+                });
+        } catch (...) {
+            waiters->fail(id, std::current_exception());  // not sent: removes the waiter, its future reports why
+        }
+    }
+
+    return futures;
+}
+
+auto ModemManager::event_loop_mode() const -> EventLoopMode {
+    return mode_;
+}
+
+auto ModemManager::connection() const -> std::shared_ptr<sdbus::IConnection> {
+    return conn_;
+}
+
+auto ModemManager::event_loop_poll_data() const -> PollData {
+    if (mode_ != EventLoopMode::EXTERNAL) {
+        throw ModemManagerException("event_loop_poll_data: event loop is processed internally");
+    }
+    return conn_->getEventLoopPollData();
+}
+
+auto ModemManager::poll_timeout_ms(const PollData& poll_data) -> int {
+    if (poll_data.timeout_usec == std::numeric_limits<uint64_t>::max()) {
+        return -1;
+    }
+    timespec now{};
+    ::clock_gettime(CLOCK_MONOTONIC, &now);  // the clock of sd_bus_get_timeout()
+    auto now_usec = static_cast<uint64_t>(now.tv_sec) * 1000000 + static_cast<uint64_t>(now.tv_nsec) / 1000;
+    if (poll_data.timeout_usec <= now_usec) {
+        return 0;
+    }
+    auto remaining_ms = (poll_data.timeout_usec - now_usec + 999) / 1000;  // rounded up, so that it's due on wake-up
+    return static_cast<int>(std::min<uint64_t>(remaining_ms, std::numeric_limits<int>::max()));
+}
+
+auto ModemManager::process_pending() -> bool {
+    if (mode_ != EventLoopMode::EXTERNAL) {
+        throw ModemManagerException("process_pending: event loop is processed internally");
+    }
+    return conn_->processPendingRequest();
+}
+
+void ModemManager::set_executor(std::shared_ptr<Executor> executor, DispatchOptions options) {
+    dispatcher_->set_executor(std::move(executor), options);
+}
+
+auto ModemManager::startup_duration() const -> std::chrono::steady_clock::duration {
+    return startup_duration_;
+}
+
+auto ModemManager::connect_all(std::vector<Modem>& modems, const std::string& apn, IPType ip_type,
+                               std::chrono::milliseconds timeout) const -> std::vector<std::future<Connection>> {
+    std::vector<std::future<Connection>> futures;
+    futures.reserve(modems.size());
+    for (auto& modem : modems) {
+        futures.push_back(modem.connect_async(apn, ip_type, timeout));
+    }
+    return futures;
+}
+
+auto ModemManager::scan_cells(CellScanner& scanner) const -> std::vector<CellDelta> {
+    return scanner.sweep(available_modems());
 }
 
 auto ModemManager::version() const -> std::string {
-    auto proxy = sdbus::createProxy(*conn_, DBus::MM_BUS_NAME, DBus::MM_OBJ_MODEMMANAGER);
-    return proxy->getProperty("Version").onInterface(DBus::MM_IF_MODEMMANAGER);
+    // same object as the ObjectManager
+    return DBus::get_property(mm_proxy_->getProxy(), DBus::MM_VERSION);
+}
+
+void ModemManager::start_capture(const std::string& file, std::size_t capacity) {
+    if (replay_) {
+        throw ModemManagerException("start_capture: replaying a capture");
+    }
+    const auto& capture = proxies_->capture();
+    capture->start(std::make_shared<CaptureWriter>(file, capacity));
+    // after starting, so that no signal is missed. Signals recorded before the reply are replayed on top of it.
+    mm_proxy_->capture_existing();
+}
+
+auto ModemManager::stop_capture() -> CaptureStats {
+    auto writer = proxies_->capture()->stop();
+    if (!writer) {
+        return {};
+    }
+    return {writer->records(), writer->dropped(), writer->bytes()};
+}
+
+auto ModemManager::from_capture(std::shared_ptr<sdbus::IConnection> conn, const std::string& file) -> ModemManager {
+    return ModemManager{std::move(conn), std::make_shared<CaptureReader>(file)};
+}
+
+namespace {
+
+enum class Delivery { DELIVERED, SKIPPED, MALFORMED };
+
+// decode all arguments of a record, which must hold nothing else
+template<typename... Args>
+auto decode_args(BinaryReader payload, Args&... args) -> bool {
+    return (decode_value(payload, args) && ...) && payload.at_end();
+}
+
+// pass a signal to the handler that received it, the same members as recorded by SignalHub and ModemManagerOMProxy
+auto deliver(const CaptureRecord& record, ModemManagerOMProxy& mm_proxy, const ProxyPool& proxies) -> Delivery {
+    if (record.kind != CaptureKind::SIGNAL) {
+        return Delivery::SKIPPED;  // the GetManagedObjects reply seeded the registry already
+    }
+
+    if (record.interface == DBus::DBUS_IF_OBJECT_MANAGER) {
+        sdbus::ObjectPath path;
+        if (record.member == "InterfacesAdded") {
+            ModemRegistry::InterfacesAndProperties interfaces;
+            if (!decode_args(record.payload, path, interfaces)) {
+                return Delivery::MALFORMED;
+            }
+            mm_proxy.interfaces_added(path, interfaces);
+            return Delivery::DELIVERED;
+        }
+        if (record.member == "InterfacesRemoved") {
+            std::vector<std::string> interfaces;
+            if (!decode_args(record.payload, path, interfaces)) {
+                return Delivery::MALFORMED;
+            }
+            mm_proxy.interfaces_removed(path, interfaces);
+            return Delivery::DELIVERED;
+        }
+        return Delivery::SKIPPED;
+    }
+
+    auto hub = proxies.find(std::string{record.path});
+    if (!hub) {
+        return Delivery::SKIPPED;  // not in use, so nobody would be notified
+    }
+    if (record.member == "PropertiesChanged") {
+        std::string interface;
+        sdbus_variant_map changed;
+        std::vector<std::string> invalidated;
+        if (!decode_args(record.payload, interface, changed, invalidated)) {
+            return Delivery::MALFORMED;
+        }
+        hub->on_properties_changed(interface, changed, invalidated);
+    } else if (record.member == "StateChanged") {
+        int32_t old_state{};
+        int32_t new_state{};
+        uint32_t reason{};
+        if (!decode_args(record.payload, old_state, new_state, reason)) {
+            return Delivery::MALFORMED;
+        }
+        hub->on_state_changed(old_state, new_state, reason);
+    } else if (record.member == "NetworkTimeChanged") {
+        std::string time;
+        if (!decode_args(record.payload, time)) {
+            return Delivery::MALFORMED;
+        }
+        hub->on_network_time(time);
+    } else {
+        return Delivery::SKIPPED;
+    }
+    return Delivery::DELIVERED;
+}
+
+} // namespace
+
+auto ModemManager::replay(double speed) -> ReplayStats {
+    using Clock = std::chrono::steady_clock;
+    if (!replay_) {
+        throw ModemManagerException("replay: not created from a capture");
+    }
+
+    ReplayStats stats;
+    auto start = Clock::now();
+    replay_->rewind();
+    CaptureRecord record;
+    bool malformed = false;
+    while (replay_->next(record, malformed)) {
+        ++stats.records;
+        if (speed > 0) {
+            auto due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::nano>{static_cast<double>(record.time.count()) / speed});
+            std::this_thread::sleep_until(due);
+            stats.max_lag = std::max(stats.max_lag, Clock::now() - due);
+        }
+        switch (deliver(record, *mm_proxy_, *proxies_)) {
+            case Delivery::DELIVERED: ++stats.delivered; break;
+            case Delivery::SKIPPED: ++stats.skipped; break;
+            case Delivery::MALFORMED: ++stats.malformed; break;
+        }
+    }
+    if (malformed) {
+        ++stats.malformed;  // the rest of the file is unreadable
+    }
+    stats.duration = Clock::now() - start;
+    return stats;
 }
 
 } // namespace ezcellular
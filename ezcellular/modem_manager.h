@@ -4,6 +4,9 @@
 */
 #pragma once
 
+#include <chrono>   // std::chrono::milliseconds, std::chrono::steady_clock
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t
 #include <future>   // std::future
 #include <memory>   // std::shared_ptr, std::unique_ptr
 #include <optional> // std::optional
@@ -12,16 +15,58 @@
 
 #include <sdbus-c++/sdbus-c++.h>  // sdbus::*
 
+#include "cell_scanner.h"
+#include "executor.h"
 #include "modem.h"
 
 namespace ezcellular {
 
 constexpr auto ANY_IMEI = "<ANY_IMEI>";
+/** @brief how long ModemManager::reset_modem() waits for a modem to come back by default */
+constexpr std::chrono::milliseconds DEFAULT_RESET_TIMEOUT{120'000};
+/** @brief how many bytes of records ModemManager::start_capture() keeps by default */
+constexpr std::size_t DEFAULT_CAPTURE_CAPACITY = 64UL * 1024 * 1024;
+/** @brief speed for ModemManager::replay() to deliver the records without waiting in between */
+constexpr double MAX_REPLAY_SPEED = 0.0;
 
 /**
  * @brief internal helper class
  */
+class CaptureReader; // IWYU pragma: keep
+class Dispatcher; // IWYU pragma: keep
+class EventLoopThread; // IWYU pragma: keep
 class ModemManagerOMProxy; // IWYU pragma: keep
+class ProxyPool; // IWYU pragma: keep
+
+/**
+ * @brief Who processes the D-Bus messages of a ModemManager, and thus runs the observer callbacks.
+ */
+enum class EventLoopMode {
+    INTERNAL_THREAD, ///< the ModemManager starts a background thread for the connection (default), and stops it again
+    EXTERNAL,        ///< the caller drives the event loop, see ModemManager::event_loop_poll_data()
+};
+
+/**
+ * @brief Statistics of a capture, see ModemManager::stop_capture().
+ */
+struct CaptureStats {
+    uint64_t records = 0; ///< messages recorded
+    uint64_t dropped = 0; ///< messages not recorded, as the capacity was exhausted
+    uint64_t bytes = 0;   ///< size of the records in the file
+};
+
+/**
+ * @brief Statistics of a replay, see ModemManager::replay().
+ */
+struct ReplayStats {
+    uint64_t records = 0;   ///< records read from the capture
+    uint64_t delivered = 0; ///< records passed to the signal handlers
+    uint64_t skipped = 0;   ///< records of objects not in use (e.g. a modem without observers) and method replies
+    uint64_t malformed = 0; ///< records that couldn't be decoded
+    std::chrono::steady_clock::duration duration{}; ///< how long the replay took
+    /** @brief how late the most delayed record was delivered, in real time, e.g. due to slow observers */
+    std::chrono::steady_clock::duration max_lag{};
+};
 
 /**
  * @brief Management of Modem instances and background stuff.
@@ -34,7 +79,24 @@ class ModemManagerOMProxy; // IWYU pragma: keep
  */
 class ModemManager {
 public:
+    /** @brief Connect to the system bus and process its messages on a background thread. */
     ModemManager();
+    /**
+     * @brief Use an existing D-Bus connection, e.g. to integrate into an existing event loop.
+     *
+     * With EventLoopMode::EXTERNAL, no thread is started. Instead, the caller has to wait for the events
+     * returned by event_loop_poll_data() and then call process_pending(). All observer callbacks
+     * and the replies of the *_async() methods are then processed on the caller's thread.
+     *
+     * With EventLoopMode::INTERNAL_THREAD, the messages are processed on a thread of this instance. The event loop
+     * of the connection (`enterEventLoop()`) is not used, so it stays available to other users of the connection.
+     *
+     * @param conn the connection to the system bus
+     * @param mode whether the caller or a background thread processes the messages
+     * @warning With EventLoopMode::EXTERNAL, don't block the event loop thread on futures
+     *          (e.g. await_modem(), reset_modem(), *_async()), as they are fulfilled from that thread.
+     */
+    explicit ModemManager(std::shared_ptr<sdbus::IConnection> conn, EventLoopMode mode = EventLoopMode::EXTERNAL);
     ~ModemManager(); // can't be defined here as ModemManagerOMProxy is incomplete type
 
     /** @brief Copy constructor (deleted to forbid copies) */
@@ -56,26 +118,198 @@ public:
      * @return an std::optional value (empty, if no Modem is available)
     */
     [[nodiscard]] auto any_modem() const -> std::optional<Modem>;
+    /**
+     * @brief The Modem with the given IMEI, if present.
+     *
+     * The lookup is O(1) and doesn't involve any D-Bus call.
+     * @return an std::optional value (empty, if no Modem with this IMEI is available)
+     */
+    [[nodiscard]] auto modem_by_imei(const std::string& imei) const -> std::optional<Modem>;
     /**
      * @brief Wait for a modem to become available.
+     *
+     * Any number of waits can be pending at the same time, also for the same IMEI.
      * @param imei The IMEI of the modem to await or ANY_IMEI to take the next Modem to become available.
+     * @param timeout fail the future with a ModemManagerException after this duration, zero to wait forever
      * @return A std::future that can be awaited to get the Modem.
      */
-    [[nodiscard]] auto await_modem(std::string imei = ANY_IMEI) const -> std::future<Modem>;
+    [[nodiscard]] auto await_modem(std::string imei = ANY_IMEI,
+                                   std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()) const
+        -> std::future<Modem>;
 
     /**
-     * @brief Reset a modem (power cycle).
+     * @brief Reset a modem (power cycle) and wait until it is available again.
      * @param modem the modem to reset
+     * @param timeout how long to wait for the modem to come back
      * @warning This action will render this object instance as well as related SIM and Connection objects invalid!
-     * @return
+     * @throws ModemException if the reset failed, ModemManagerException if the modem didn't come back in time
+     * @return the restarted modem
+     */
+    [[nodiscard]] auto reset_modem(Modem& modem, std::chrono::milliseconds timeout = DEFAULT_RESET_TIMEOUT) const
+        -> Modem;
+    /**
+     * @brief Reset several modems (power cycle) in parallel.
+     *
+     * All resets are issued at once, so recovering all modems takes as long as the slowest one.
+     * @param modems the modems to reset
+     * @param timeout how long to wait for each modem to come back
+     * @warning This action will render these object instances as well as related SIM and Connection objects invalid!
+     * @return one future per modem, in the same order. Fulfilled with the restarted modem,
+     *         or failed as described in reset_modem().
+     */
+    [[nodiscard]] auto reset_modems(std::vector<Modem>& modems,
+                                    std::chrono::milliseconds timeout = DEFAULT_RESET_TIMEOUT) const
+        -> std::vector<std::future<Modem>>;
+
+    /**
+     * @brief Connect several modems in parallel, see Modem::connect().
+     *
+     * All connects are issued at once, so bringing up all modems takes as long as the slowest one.
+     * @param modems the modems to connect
+     * @param apn the access point name to connect each modem to
+     * @param ip_type the IP address type of the bearers
+     * @param timeout for each modem
+     * @return one future per modem, in the same order. Fulfilled with the Connection,
+     *         or failed as described in Modem::connect().
      */
-    [[nodiscard]] auto reset_modem(Modem& modem) const -> Modem;
+    [[nodiscard]] auto connect_all(std::vector<Modem>& modems, const std::string& apn,
+                                   IPType ip_type = IPType::IPV4_AND_IPV6,
+                                   std::chrono::milliseconds timeout = Modem::DEFAULT_CONNECT_TIMEOUT) const
+        -> std::vector<std::future<Connection>>;
+
+    /**
+     * @brief Scan the cells of all available modems at once, see CellScanner::sweep().
+     * @param scanner keeps the cell index across sweeps
+     * @return the changes since the scanner's last sweep
+     */
+    auto scan_cells(CellScanner& scanner) const -> std::vector<CellDelta>;
 
     /** @brief ModemManager version string */
     [[nodiscard]] auto version() const -> std::string;
+
+    /**
+     * @brief How long the constructor took to list all present modems.
+     *
+     * The modems and their properties are taken from a single `GetManagedObjects` call,
+     * so this should not grow with the number of modems. Their proxies are only created once they are used.
+     */
+    [[nodiscard]] auto startup_duration() const -> std::chrono::steady_clock::duration;
+
+    // ---- event loop integration ----
+
+    /** @brief how the messages are processed, see EventLoopMode */
+    [[nodiscard]] auto event_loop_mode() const -> EventLoopMode;
+
+    /** @brief the underlying D-Bus connection */
+    [[nodiscard]] auto connection() const -> std::shared_ptr<sdbus::IConnection>;
+
+    /**
+     * @brief file descriptor and poll events to wait for, see sd_bus_get_fd()/sd_bus_get_events(),
+     *        and the deadline (sd_bus_get_timeout())
+     * @note timeout_usec is an absolute CLOCK_MONOTONIC time in µs (or UINT64_MAX for none), not a duration.
+     *       See poll_timeout_ms() to convert it for `poll()`.
+     */
+    using PollData = sdbus::IConnection::PollData;
+    /**
+     * @brief What to wait for before calling process_pending() again.
+     * @note must be queried again after each process_pending() call, as the timeout changes
+     * @throws ModemManagerException if not in EventLoopMode::EXTERNAL
+     */
+    [[nodiscard]] auto event_loop_poll_data() const -> PollData;
+    /**
+     * @brief The timeout of poll_data as relative timeout for `poll()`.
+     * @return ms until the deadline (rounded up, 0 if it passed), or -1 to wait forever
+     */
+    [[nodiscard]] static auto poll_timeout_ms(const PollData& poll_data) -> int;
+    /**
+     * @brief Process one pending D-Bus message (e.g. signal or method reply), without blocking.
+     * @return true if a message was processed, call again until it returns false
+     * @throws ModemManagerException if not in EventLoopMode::EXTERNAL
+     */
+    auto process_pending() -> bool;
+
+    // ---- observer dispatching ----
+
+    /**
+     * @brief Run the observer callbacks of all Modems and Connections on the given executor.
+     *
+     * By default, observers run directly on the D-Bus event loop thread, so a slow observer delays
+     * all other D-Bus messages, including the replies other threads are waiting for.
+     * With an executor, each observer gets a bounded queue. Its updates are run in order and never in parallel,
+     * and if it can't keep up, updates are dropped according to DispatchOptions::policy.
+     *
+     * @param executor e.g. a ThreadPoolExecutor, or nullptr to run on the D-Bus thread again
+     * @param options the queue size and the OverflowPolicy of each observer
+     * @note also applies to already registered observers
+     */
+    void set_executor(std::shared_ptr<Executor> executor, DispatchOptions options = {});
+
+    // ---- capture and replay ----
+
+    /**
+     * @brief Record the messages received from now on into a file, to replay them later (see from_capture()).
+     *
+     * Records the current `GetManagedObjects` reply, which a replay starts from, then every signal received for
+     * the objects of this ModemManager: `InterfacesAdded`/`InterfacesRemoved`, `PropertiesChanged`,
+     * `StateChanged` and `NetworkTimeChanged`. Each record holds the time, object path, interface, member and
+     * the arguments, and is appended to a memory-mapped file in place, so no system call is made per message.
+     * Values of D-Bus types the capture doesn't support (e.g. structs like the `Ports` property) are left out.
+     *
+     * @param file the file to write, replaced if it exists
+     * @param capacity max. bytes of records, messages received once it is exhausted are dropped
+     * @throws std::system_error if the file can't be created, ModemManagerException if replaying
+     * @note replaces a running capture, blocks on a D-Bus call
+     */
+    void start_capture(const std::string& file, std::size_t capacity = DEFAULT_CAPTURE_CAPACITY);
+    /**
+     * @brief Stop recording, the file is truncated to its records and closed.
+     * @return statistics, all zero if no capture was running
+     */
+    auto stop_capture() -> CaptureStats;
+
+    /**
+     * @brief Create a ModemManager from a capture instead of the ModemManager service, see replay().
+     *
+     * The modems and their properties are taken from the `GetManagedObjects` reply in the capture,
+     * without calling ModemManager. No signals are received, they only come from replay().
+     * Properties not in the cache and method calls (e.g. Modem::connect()) still go to the bus, and fail without
+     * ModemManager.
+     *
+     * @param conn e.g. a session bus connection, used to create the proxies; its event loop is not processed
+     * @param file a file written by start_capture()
+     * @throws std::system_error if the file can't be read, std::runtime_error if it is no capture,
+     *         ModemManagerException if it holds no `GetManagedObjects` reply
+     */
+    [[nodiscard]] static auto from_capture(std::shared_ptr<sdbus::IConnection> conn, const std::string& file)
+        -> ModemManager;
+    /**
+     * @brief Deliver the captured signals, as if they were received from ModemManager.
+     *
+     * The signals go through the same handlers, property caches and observer queues as received ones,
+     * so observers and filters can be tested and benchmarked against real traffic. Records of objects
+     * without a proxy (i.e. not used since from_capture()) are skipped.
+     *
+     * @param speed 1.0 to keep the recorded timing, 2.0 for twice as fast, MAX_REPLAY_SPEED for no waiting at all
+     * @return statistics
+     * @throws ModemManagerException if not created by from_capture()
+     * @note blocks until all records are delivered, observers run on the caller's thread unless an executor is
+     *       set. Can be called again to replay the capture once more.
+     */
+    auto replay(double speed = 1.0) -> ReplayStats;
 private:
     std::shared_ptr<sdbus::IConnection> conn_;
+    EventLoopMode mode_ = EventLoopMode::INTERNAL_THREAD;
+    std::shared_ptr<Dispatcher> dispatcher_;  // shared with all Modems and Connections
+    std::shared_ptr<ProxyPool> proxies_;  // shared with all Modems and Connections
     std::unique_ptr<ModemManagerOMProxy> mm_proxy_;
+    std::chrono::steady_clock::duration startup_duration_{};
+    std::shared_ptr<CaptureReader> replay_;  // the capture, if created by from_capture()
+
+    bool owns_event_loop_ = false;  // whether the event loop of conn_ was entered by this instance
+    std::unique_ptr<EventLoopThread> loop_;  // EventLoopMode::INTERNAL_THREAD on a connection of the caller
+
+    ModemManager(std::shared_ptr<sdbus::IConnection> conn, EventLoopMode mode, bool own_connection);
+    ModemManager(std::shared_ptr<sdbus::IConnection> conn, std::shared_ptr<CaptureReader> replay);
 };
 
 } // namespace ezcellular
\ No newline at end of file
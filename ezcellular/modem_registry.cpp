@@ -0,0 +1,112 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "modem_registry.h"
+
+#include <utility>  // std::move
+
+#include "dbus_properties.h"  // MODEM3GPP_IMEI, MODEM_EQUIPMENT_IDENTIFIER
+
+namespace ezcellular {
+
+auto ModemRegistry::imei_from_payload(const InterfacesAndProperties& interfaces) -> std::string {
+    // .Modem.Modem3gpp.Imei, only exported once the modem is initialized
+    if (auto iface_it = interfaces.find(DBus::MODEM3GPP_IMEI.interface()); iface_it != interfaces.end()) {
+        if (auto it = iface_it->second.find(DBus::MODEM3GPP_IMEI.name()); it != iface_it->second.end()) {
+            return it->second.get<std::string>();
+        }
+    }
+    // .Modem.EquipmentIdentifier, equal to the IMEI for 3GPP modems
+    if (auto iface_it = interfaces.find(DBus::MODEM_EQUIPMENT_IDENTIFIER.interface()); iface_it != interfaces.end()) {
+        if (auto it = iface_it->second.find(DBus::MODEM_EQUIPMENT_IDENTIFIER.name()); it != iface_it->second.end()) {
+            return it->second.get<std::string>();
+        }
+    }
+    return {};  // not known yet
+}
+
+auto ModemRegistry::insert(const sdbus::ObjectPath& path, Modem modem, const std::string& imei) -> const Modem& {
+    if (auto it = path_index_.find(path); it != path_index_.end()) {
+        update_imei(path, imei);
+        return modems_[it->second];
+    }
+
+    auto index = modems_.size();
+    modems_.push_back(std::move(modem));
+    paths_.push_back(path);
+    imeis_.emplace_back();
+    path_index_.emplace(path, index);
+    update_imei(path, imei);
+    return modems_[index];
+}
+
+auto ModemRegistry::update_imei(const sdbus::ObjectPath& path, const std::string& imei) -> bool {
+    auto it = path_index_.find(path);
+    if (it == path_index_.end()) {
+        return false;
+    }
+    if (imei.empty() || imeis_[it->second] == imei) {
+        return true;  // nothing new
+    }
+
+    if (!imeis_[it->second].empty()) {
+        imei_index_.erase(imeis_[it->second]);
+    }
+    imeis_[it->second] = imei;
+    imei_index_[imei] = it->second;
+    return true;
+}
+
+auto ModemRegistry::erase(const sdbus::ObjectPath& path) -> bool {
+    auto it = path_index_.find(path);
+    if (it == path_index_.end()) {
+        return false;
+    }
+    auto index = it->second;
+    auto last = modems_.size() - 1;
+
+    // drop the indexes of the removed entry
+    if (!imeis_[index].empty()) {
+        imei_index_.erase(imeis_[index]);
+    }
+    path_index_.erase(it);
+
+    // move the last entry into the gap, keeps the storage dense
+    if (index != last) {
+        modems_[index] = std::move(modems_[last]);
+        paths_[index] = std::move(paths_[last]);
+        imeis_[index] = std::move(imeis_[last]);
+        path_index_[paths_[index]] = index;
+        if (!imeis_[index].empty()) {
+            imei_index_[imeis_[index]] = index;
+        }
+    }
+    modems_.pop_back();
+    paths_.pop_back();
+    imeis_.pop_back();
+    return true;
+}
+
+auto ModemRegistry::by_path(const std::string& path) const -> const Modem* {
+    if (auto it = path_index_.find(path); it != path_index_.end()) {
+        return &modems_[it->second];
+    }
+    return nullptr;
+}
+
+auto ModemRegistry::by_imei(const std::string& imei) const -> const Modem* {
+    if (auto it = imei_index_.find(imei); it != imei_index_.end()) {
+        return &modems_[it->second];
+    }
+    return nullptr;
+}
+
+auto ModemRegistry::imei_of(const std::string& path) const -> std::string {
+    if (auto it = path_index_.find(path); it != path_index_.end()) {
+        return imeis_[it->second];
+    }
+    return {};
+}
+
+} // namespace ezcellular
@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <cstddef>       // std::size_t
+#include <map>           // std::map
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::ObjectPath, sdbus::Variant
+
+#include "modem.h"
+
+namespace ezcellular {
+
+/**
+ * @brief The present Modems, indexed by D-Bus object path and IMEI.
+ *
+ * Entries are stored densely, lookups by path or IMEI are O(1) and return a reference without copying.
+ *
+ * @note internal helper class, not part of the public API. Not synchronized:
+ *       ModemManagerOMProxy publishes it as immutable snapshot and modifies copies only.
+ */
+class ModemRegistry {
+public:
+    /** @brief ObjectManager payload: interface -> property -> value */
+    using InterfacesAndProperties = std::map<std::string, std::map<std::string, sdbus::Variant>>;
+
+    /**
+     * @brief Get the IMEI from an ObjectManager payload, without a D-Bus call.
+     * @return the IMEI, or an empty string if the payload doesn't contain it
+     */
+    static auto imei_from_payload(const InterfacesAndProperties& interfaces) -> std::string;
+
+    /**
+     * @brief Add a modem, or update the IMEI of an already present one.
+     * @param imei the IMEI, empty if not (yet) known
+     * @return the stored modem
+     */
+    auto insert(const sdbus::ObjectPath& path, Modem modem, const std::string& imei) -> const Modem&;
+    /**
+     * @brief Update the IMEI of a present modem, e.g. once the Modem3gpp interface appeared.
+     * @return false if the modem is not present
+     */
+    auto update_imei(const sdbus::ObjectPath& path, const std::string& imei) -> bool;
+    /**
+     * @brief Remove the modem with the given path.
+     * @return false if the modem was not present
+     */
+    auto erase(const sdbus::ObjectPath& path) -> bool;
+
+    /** @brief the modem with the given path, nullptr if not present */
+    [[nodiscard]] auto by_path(const std::string& path) const -> const Modem*;
+    /** @brief the modem with the given IMEI, nullptr if not present */
+    [[nodiscard]] auto by_imei(const std::string& imei) const -> const Modem*;
+    /** @brief the IMEI of the modem with the given path, empty if not present or not known (yet) */
+    [[nodiscard]] auto imei_of(const std::string& path) const -> std::string;
+
+    /** @brief all modems, in no particular order */
+    [[nodiscard]] auto modems() const -> const std::vector<Modem>& { return modems_; }
+    /** @brief number of present modems */
+    [[nodiscard]] auto size() const -> std::size_t { return modems_.size(); }
+    /** @brief whether no modem is present */
+    [[nodiscard]] auto empty() const -> bool { return modems_.empty(); }
+
+private:
+    // dense storage, entries at the same index belong together
+    std::vector<Modem> modems_;
+    std::vector<sdbus::ObjectPath> paths_;
+    std::vector<std::string> imeis_;
+
+    std::unordered_map<std::string, std::size_t> path_index_;
+    std::unordered_map<std::string, std::size_t> imei_index_;
+};
+
+} // namespace ezcellular
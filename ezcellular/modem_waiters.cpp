@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "modem_waiters.h"
+
+#include <utility> // std::move
+
+#include "exception.h"
+#include "modem_manager.h"  // ANY_IMEI
+
+namespace ezcellular {
+
+ModemWaiters::~ModemWaiters() {
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+        for (auto& [imei, waiter] : waiters_) {
+            waiter.promise.set_exception(
+                std::make_exception_ptr(ModemManagerException{"Cancelled, ModemManager was destroyed."}));
+        }
+        waiters_.clear();
+    }
+    cv_.notify_all();
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+}
+
+auto ModemWaiters::add(std::string imei, std::chrono::milliseconds timeout, std::string ignored_path)
+    -> std::pair<Id, std::future<Modem>> {
+    std::lock_guard lock{mutex_};
+
+    Waiter waiter{next_id_++, {}, {}, std::move(ignored_path)};
+    if (timeout.count() > 0) {
+        waiter.deadline = Clock::now() + timeout;
+        if (!reaper_.joinable()) {
+            reaper_ = std::thread{[this]() { reap(); }};
+        }
+    }
+    auto result = std::make_pair(waiter.id, waiter.promise.get_future());
+    waiters_.emplace(std::move(imei), std::move(waiter));
+
+    cv_.notify_all();  // the reaper might need to wake up earlier
+    return result;
+}
+
+void ModemWaiters::notify(const Modem& modem, const std::string& path, const std::string& imei, bool appeared) {
+    std::lock_guard lock{mutex_};
+
+    // fulfill the waiters of one key, except those ignoring this modem
+    auto fulfill = [&](const std::string& key) {
+        auto [begin, end] = waiters_.equal_range(key);
+        for (auto it = begin; it != end;) {
+            if (it->second.ignored_path == path) {
+                ++it;
+                continue;
+            }
+            it->second.promise.set_value(modem);
+            it = waiters_.erase(it);
+        }
+    };
+
+    if (!imei.empty()) {
+        fulfill(imei);
+    }
+    if (appeared) {
+        fulfill(ANY_IMEI);
+    }
+}
+
+void ModemWaiters::fail(Id id, const std::exception_ptr& error) {
+    std::lock_guard lock{mutex_};
+    for (auto it = waiters_.begin(); it != waiters_.end(); ++it) {
+        if (it->second.id == id) {
+            it->second.promise.set_exception(error);
+            waiters_.erase(it);
+            return;
+        }
+    }
+}
+
+auto ModemWaiters::size() const -> std::size_t {
+    std::lock_guard lock{mutex_};
+    return waiters_.size();
+}
+
+void ModemWaiters::reap() {
+    std::unique_lock lock{mutex_};
+    while (!stop_) {
+        // fail the expired waiters and find the next deadline
+        auto now = Clock::now();
+        std::optional<Clock::time_point> next;
+        for (auto it = waiters_.begin(); it != waiters_.end();) {
+            const auto& deadline = it->second.deadline;
+            if (deadline && *deadline <= now) {
+                it->second.promise.set_exception(std::make_exception_ptr(
+                    ModemManagerException{"Timed out awaiting modem '" + it->first + "'."}));
+                it = waiters_.erase(it);
+                continue;
+            }
+            if (deadline && (!next || *deadline < *next)) {
+                next = deadline;
+            }
+            ++it;
+        }
+
+        if (next) {
+            cv_.wait_until(lock, *next);
+        } else {
+            cv_.wait(lock);
+        }
+    }
+}
+
+} // namespace ezcellular
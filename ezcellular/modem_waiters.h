@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <chrono>             // std::chrono::steady_clock, std::chrono::milliseconds
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::size_t
+#include <cstdint>            // uint64_t
+#include <exception>          // std::exception_ptr
+#include <future>             // std::promise, std::future
+#include <map>                // std::multimap
+#include <mutex>              // std::mutex
+#include <optional>           // std::optional
+#include <string>             // std::string
+#include <thread>             // std::thread
+#include <utility>            // std::pair
+
+#include "modem.h"
+
+namespace ezcellular {
+
+/**
+ * @brief Pending ModemManager::await_modem() calls, indexed by IMEI.
+ *
+ * Any number of waiters can be pending at the same time, also for the same IMEI.
+ * Waiters with a timeout are failed by a background thread, which is only started once such a waiter is added.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class ModemWaiters {
+public:
+    using Id = uint64_t;
+
+    ModemWaiters() = default;
+    /** @brief Fails all pending waiters */
+    ~ModemWaiters();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    ModemWaiters(const ModemWaiters&) = delete;
+    ModemWaiters& operator=(const ModemWaiters&) = delete;
+    ModemWaiters(ModemWaiters&&) = delete;
+    ModemWaiters& operator=(ModemWaiters&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /**
+     * @brief Add a waiter.
+     * @param imei the IMEI to wait for, or ANY_IMEI
+     * @param timeout fail the waiter with a ModemManagerException after this duration, zero to wait forever
+     * @param ignored_path don't take the modem with this object path, e.g. the one about to be reset
+     * @return the id of the waiter, see fail(), and its future
+     */
+    auto add(std::string imei, std::chrono::milliseconds timeout, std::string ignored_path = {})
+        -> std::pair<Id, std::future<Modem>>;
+
+    /**
+     * @brief Fulfill all waiters for this modem.
+     * @param appeared whether the modem is new. If not, only the waiters for its IMEI are fulfilled
+     *        (the IMEI became known just now), ANY_IMEI waiters wait for a new modem.
+     */
+    void notify(const Modem& modem, const std::string& path, const std::string& imei, bool appeared = true);
+    /** @brief Fail a waiter, e.g. if its reset failed. No-op if it is not pending anymore. */
+    void fail(Id id, const std::exception_ptr& error);
+
+    /** @brief number of pending waiters */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiter {
+        Id id;
+        std::promise<Modem> promise;
+        std::optional<Clock::time_point> deadline;
+        std::string ignored_path;
+    };
+
+    mutable std::mutex mutex_;  // protects the members below
+    std::condition_variable cv_;
+    std::multimap<std::string, Waiter> waiters_;  // IMEI (or ANY_IMEI) -> waiter
+    Id next_id_ = 1;
+    bool stop_ = false;
+    std::thread reaper_;  // fails expired waiters, started on demand
+
+    void reap();
+};
+
+} // namespace ezcellular
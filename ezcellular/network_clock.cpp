@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "network_clock.h"
+
+#include <utility> // std::move
+
+#include "exception.h"
+#include "iso8601.h"  // parse_iso8601
+
+namespace ezcellular {
+
+static auto to_ns(std::chrono::nanoseconds duration) -> int64_t {
+    return static_cast<int64_t>(duration.count());
+}
+
+NetworkClock::NetworkClock(const Modem& modem) : modem_{modem}, state_{std::make_shared<State>()} {
+    // the observer only touches the state, so it may outlive a moved-from clock
+    subscription_ = modem_.observe_network_time([state = state_](NetworkTime time) { apply(*state, time); });
+}
+
+void NetworkClock::apply(State& state, const NetworkTime& time) {
+    auto received = to_ns(time.received.time_since_epoch());
+    state.offset_ns.store(to_ns(time.utc.time_since_epoch()) - received, std::memory_order_relaxed);
+    state.utc_offset_min.store(time.utc_offset ? static_cast<int32_t>(time.utc_offset->count()) : NO_UTC_OFFSET,
+                               std::memory_order_relaxed);
+    state.synced_ns.store(received, std::memory_order_release);  // publishes the values above
+}
+
+void NetworkClock::sync() {
+    // the modem took the time somewhere during the call
+    auto before = std::chrono::steady_clock::now();
+    auto time_str = modem_.network_time();
+    auto after = std::chrono::steady_clock::now();
+
+    auto time = parse_iso8601(time_str);
+    if (!time) {
+        throw ModemException{"network time is not valid: '" + time_str + "'"};
+    }
+    time->received = before + (after - before) / 2;
+    apply(*state_, *time);
+}
+
+void NetworkClock::update(const NetworkTime& time) {
+    apply(*state_, time);
+}
+
+auto NetworkClock::synced() const -> bool {
+    return state_->synced_ns.load(std::memory_order_acquire) != 0;
+}
+
+auto NetworkClock::now() const -> std::optional<std::chrono::system_clock::time_point> {
+    if (!synced()) {
+        return {};
+    }
+    std::chrono::nanoseconds offset{state_->offset_ns.load(std::memory_order_relaxed)};
+    auto now = std::chrono::steady_clock::now().time_since_epoch() + offset;
+    return std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(now)};
+}
+
+auto NetworkClock::now_epoch() const -> std::optional<std::time_t> {
+    if (auto now = this->now()) {
+        return std::chrono::system_clock::to_time_t(*now);
+    }
+    return {};
+}
+
+auto NetworkClock::utc_offset() const -> std::optional<std::chrono::minutes> {
+    if (!synced()) {
+        return {};
+    }
+    auto minutes = state_->utc_offset_min.load(std::memory_order_relaxed);
+    if (minutes == NO_UTC_OFFSET) {
+        return {};
+    }
+    return std::chrono::minutes{minutes};
+}
+
+auto NetworkClock::last_sync() const -> std::optional<std::chrono::steady_clock::time_point> {
+    auto synced_ns = state_->synced_ns.load(std::memory_order_acquire);
+    if (synced_ns == 0) {
+        return {};
+    }
+    return std::chrono::steady_clock::time_point{
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds{synced_ns})};
+}
+
+} // namespace ezcellular
@@ -0,0 +1,81 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <atomic>   // std::atomic
+#include <chrono>   // std::chrono
+#include <cstdint>  // int64_t
+#include <ctime>    // std::time_t
+#include <memory>   // std::shared_ptr
+#include <optional> // std::optional
+
+#include "modem.h"
+#include "structs.h"       // NetworkTime
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+/**
+ * @brief Network time without a D-Bus call per timestamp.
+ *
+ * Keeps the offset between the network time and the monotonic clock (steady_clock, i.e. `CLOCK_MONOTONIC`),
+ * so that now() costs a single `clock_gettime` (usually without a system call) and two atomic loads.
+ * The offset is updated from the `NetworkTimeChanged` signal of the modem (see Modem::observe_network_time())
+ * and by sync(), e.g. if the modem doesn't send the signal.
+ * The network reports whole seconds, so the clock is accurate to about a second.
+ *
+ * @code
+ * NetworkClock clock{*modem};
+ * clock.sync();
+ * // ...
+ * if (auto now = clock.now()) {
+ *     sample.timestamp = *now;
+ * }
+ * @endcode
+ */
+class NetworkClock {
+public:
+    /**
+     * @brief Start following the time updates of modem.
+     * @note not synced until the first update or sync()
+     */
+    explicit NetworkClock(const Modem& modem);
+
+    /**
+     * @brief Fetch the time once (`GetNetworkTime`), blocking.
+     * @note must not be called from within an observer callback (waits for the D-Bus event loop)
+     * @throws ModemException if the modem is not enabled, or reports a time that is not valid
+     */
+    void sync();
+    /** @brief Apply a time update, e.g. from Modem::observe_network_time(). */
+    void update(const NetworkTime& time);
+
+    /** @brief whether the time is known, i.e. now() has a value */
+    [[nodiscard]] auto synced() const -> bool;
+    /** @brief the current network time in UTC, empty if not synced (yet) */
+    [[nodiscard]] auto now() const -> std::optional<std::chrono::system_clock::time_point>;
+    /** @brief same as now(), as std::time_t */
+    [[nodiscard]] auto now_epoch() const -> std::optional<std::time_t>;
+    /** @brief offset of the local time of the network, empty if not reported */
+    [[nodiscard]] auto utc_offset() const -> std::optional<std::chrono::minutes>;
+    /** @brief time of the last update (steady_clock), if synced */
+    [[nodiscard]] auto last_sync() const -> std::optional<std::chrono::steady_clock::time_point>;
+
+private:
+    struct State {
+        std::atomic<int64_t> offset_ns{0};      // network time (since epoch) minus steady_clock time in ns
+        std::atomic<int64_t> synced_ns{0};      // steady_clock time of the last update in ns, 0 if not synced
+        std::atomic<int32_t> utc_offset_min{NO_UTC_OFFSET};
+    };
+    static constexpr int32_t NO_UTC_OFFSET = INT32_MIN;
+
+    Modem modem_;
+    std::shared_ptr<State> state_;  // shared with the observer
+    Subscription subscription_;
+
+    static void apply(State& state, const NetworkTime& time);
+};
+
+} // namespace ezcellular
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "observer_filter.h"
+
+#include <cstdint>  // uint64_t
+
+namespace ezcellular {
+
+// common helper for SignalGate: whether one metric moved out of its band (or appeared/disappeared)
+static auto moved(const Deadband& band, const std::optional<double>& last, const std::optional<double>& current)
+    -> bool {
+    if (!band.enabled()) {
+        return false;  // not compared
+    }
+    if (last.has_value() != current.has_value()) {
+        return true;
+    }
+    return last && band.exceeded(*last, *current);
+}
+
+auto SignalGate::admit(const Signal& signal, Clock::time_point now) -> bool {
+    std::lock_guard lock{mutex_};
+    if (too_early(now)) {
+        return false;
+    }
+
+    bool any_band = filter_.rsrp.enabled() || filter_.rsrq.enabled() || filter_.rssi.enabled()
+                    || filter_.sinr.enabled();
+    bool deliver = !any_band || !last_ || last_->tech != signal.tech
+                   || moved(filter_.rsrp, last_->rsrp, signal.rsrp)
+                   || moved(filter_.rsrq, last_->rsrq, signal.rsrq)
+                   || moved(filter_.rssi, last_->rssi, signal.rssi)
+                   || moved(filter_.sinr, last_->sinr, signal.sinr);
+    if (deliver) {
+        last_ = signal;
+        delivered(now);
+    }
+    return deliver;
+}
+
+auto LocationGate::admit(const std::string& raw, Clock::time_point now) -> bool {
+    std::lock_guard lock{mutex_};
+    if (too_early(now)) {
+        return false;
+    }
+
+    bool deliver = !filter_.key_change_only || !last_ || *last_ != raw;
+    if (deliver) {
+        if (filter_.key_change_only) {
+            last_ = raw;  // only needed for the comparison
+        }
+        delivered(now);
+    }
+    return deliver;
+}
+
+// common helper for TrafficStatsGate, counters may also be reset
+static auto delta(uint64_t last, uint64_t current) -> uint64_t {
+    return current > last ? current - last : last - current;
+}
+
+auto TrafficStatsGate::admit(const TrafficStats& stats, Clock::time_point now) -> bool {
+    std::lock_guard lock{mutex_};
+    if (too_early(now)) {
+        return false;
+    }
+
+    bool deliver = filter_.min_delta_bytes == 0 || !last_
+                   || delta(last_->rx_bytes, stats.rx_bytes) >= filter_.min_delta_bytes
+                   || delta(last_->tx_bytes, stats.tx_bytes) >= filter_.min_delta_bytes;
+    if (deliver) {
+        last_ = stats;
+        delivered(now);
+    }
+    return deliver;
+}
+
+} // namespace ezcellular
@@ -0,0 +1,93 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <chrono>   // std::chrono::steady_clock
+#include <mutex>    // std::mutex
+#include <optional> // std::optional
+#include <string>   // std::string
+
+#include "filters.h"  // SignalFilter, LocationFilter, TrafficStatsFilter
+#include "structs.h"  // Signal, TrafficStats
+
+namespace ezcellular {
+
+/**
+ * @brief Common part of the gates below: the minimum interval between two delivered updates.
+ *
+ * The gates are consulted on the D-Bus thread with the decoded values, before an update is queued for the observer.
+ * They remember the last delivered update, i.e. small changes don't add up until they exceed a threshold.
+ *
+ * @note internal helper classes, not part of the public API
+ */
+class IntervalGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit IntervalGate(std::chrono::milliseconds min_interval) : min_interval_{min_interval} {}
+
+protected:
+    /** @brief whether an update at now is too early, must hold mutex_ */
+    [[nodiscard]] auto too_early(Clock::time_point now) const -> bool {
+        return delivered_ && min_interval_.count() > 0 && now - last_time_ < min_interval_;
+    }
+    /** @brief remember a delivered update, must hold mutex_ */
+    void delivered(Clock::time_point now) {
+        delivered_ = true;
+        last_time_ = now;
+    }
+
+    std::mutex mutex_;  // protects the state of the derived gates, too
+
+private:
+    std::chrono::milliseconds min_interval_;
+    bool delivered_ = false;
+    Clock::time_point last_time_;
+};
+
+/** @brief see SignalFilter */
+class SignalGate : public IntervalGate {
+public:
+    explicit SignalGate(const SignalFilter& filter) : IntervalGate{filter.min_interval}, filter_{filter} {}
+
+    /** @brief whether signal is to be delivered, remembers it if so */
+    auto admit(const Signal& signal, Clock::time_point now = Clock::now()) -> bool;
+
+private:
+    SignalFilter filter_;
+    std::optional<Signal> last_;
+};
+
+/** @brief see LocationFilter */
+class LocationGate : public IntervalGate {
+public:
+    explicit LocationGate(const LocationFilter& filter) : IntervalGate{filter.min_interval}, filter_{filter} {}
+
+    /**
+     * @brief whether the location is to be delivered, remembers it if so
+     * @param raw the undecoded identifiers, e.g. ModemManager's "MCC,MNC,LAC,CI,TAC" string
+     */
+    auto admit(const std::string& raw, Clock::time_point now = Clock::now()) -> bool;
+
+private:
+    LocationFilter filter_;
+    std::optional<std::string> last_;
+};
+
+/** @brief see TrafficStatsFilter */
+class TrafficStatsGate : public IntervalGate {
+public:
+    explicit TrafficStatsGate(const TrafficStatsFilter& filter)
+        : IntervalGate{filter.min_interval}, filter_{filter} {}
+
+    /** @brief whether stats are to be delivered, remembers them if so */
+    auto admit(const TrafficStats& stats, Clock::time_point now = Clock::now()) -> bool;
+
+private:
+    TrafficStatsFilter filter_;
+    std::optional<TrafficStats> last_;
+};
+
+} // namespace ezcellular
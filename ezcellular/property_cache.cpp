@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "property_cache.h"
+
+#include <utility>  // std::move
+
+#include "call_metrics.h"  // ScopedCall
+#include "dbus_constants.h"
+
+namespace ezcellular {
+
+PropertyCache::PropertyCache(const std::shared_ptr<SignalHub>& hub, const std::vector<std::string>& interfaces)
+    : interfaces_{interfaces}, hub_{hub} {
+    // 1. subscribe first, so no update between GetAll() and the subscription gets lost
+    std::call_once(attach_once_, [&]() { subscribe(*hub); });
+
+    // 2. fill the cache with one GetAll() per interface
+    for (const auto& iface : interfaces_) {
+        sdbus_variant_map props;
+        try {
+            ScopedCall call{iface, "GetAll"};
+            hub->proxy().callMethod("GetAll").onInterface(DBus::DBUS_IF_PROPERTIES).withArguments(iface)
+                .storeResultsTo(props);
+        } catch (const sdbus::Error&) {
+            continue;  // interface not implemented by this object (e.g. no Signal support)
+        }
+
+        std::lock_guard lock{mutex_};
+        // don't overwrite values that were updated by a signal in the meantime
+        values_[iface].insert(props.begin(), props.end());
+        update_slots(iface);
+    }
+    touch();
+}
+
+PropertyCache::PropertyCache(const Values& seed, const std::vector<std::string>& interfaces)
+    : interfaces_{interfaces} {
+    merge(seed);
+}
+
+void PropertyCache::attach(const std::shared_ptr<SignalHub>& hub) {
+    std::call_once(attach_once_, [&]() {
+        hub_ = hub;
+        subscribe(*hub);
+    });
+}
+
+auto PropertyCache::attached() const -> bool {
+    return attached_.load(std::memory_order_acquire);
+}
+
+void PropertyCache::merge(const Values& values) {
+    {
+        std::lock_guard lock{mutex_};
+        for (const auto& iface : interfaces_) {
+            if (auto it = values.find(iface); it != values.end()) {
+                values_[iface] = it->second;
+                update_slots(iface);
+            }
+        }
+    }
+    touch();
+}
+
+// (private) subscribe to the changes of all interfaces, only called once
+void PropertyCache::subscribe(SignalHub& hub) {
+    subscriptions_.reserve(interfaces_.size());
+    for (const auto& iface : interfaces_) {
+        subscriptions_.push_back(hub.subscribe_interface(iface,
+            [this, iface](const sdbus_variant_map& changedProperties,
+                          const std::vector<std::string>& invalidatedProperties) {
+                on_properties_changed(iface, changedProperties, invalidatedProperties);
+            }));
+    }
+    attached_.store(true, std::memory_order_release);
+}
+
+auto PropertyCache::slots() const -> DBus::PropertySlots {
+    std::lock_guard lock{mutex_};
+    return slots_;
+}
+
+auto PropertyCache::get_all(const std::string& interface) const -> sdbus_variant_map {
+    std::lock_guard lock{mutex_};
+
+    if (auto it = values_.find(interface); it != values_.end()) {
+        return it->second;
+    }
+    return {};  // empty map
+}
+
+auto PropertyCache::generation() const -> uint64_t {
+    return generation_.load(std::memory_order_acquire);
+}
+
+auto PropertyCache::last_update() const -> std::chrono::steady_clock::time_point {
+    return std::chrono::steady_clock::time_point{
+        std::chrono::steady_clock::duration{last_update_.load(std::memory_order_acquire)}};
+}
+
+void PropertyCache::on_properties_changed(const std::string& interface, const sdbus_variant_map& changed,
+                                          const std::vector<std::string>& invalidated) {
+    {
+        std::lock_guard lock{mutex_};
+        auto& props = values_[interface];
+        for (const auto& [name, value] : changed) {
+            props[name] = value;
+        }
+        // invalidated properties are not sent along, fall back to a D-Bus call for them
+        for (const auto& name : invalidated) {
+            props.erase(name);
+        }
+        update_slots(interface);
+    }
+    touch();
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// (private) copy the properties of interface into their slots, expects mutex_ to be locked.
+// Updates are rare compared to reads, so the lookups by name are done here instead of in get().
+void PropertyCache::update_slots(const std::string& interface) {
+    DBus::fill_slots(slots_, interface, values_[interface]);
+}
+
+void PropertyCache::touch() {
+    last_update_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_release);
+}
+
+} // namespace ezcellular
@@ -0,0 +1,121 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <atomic>   // std::atomic
+#include <chrono>   // std::chrono::steady_clock
+#include <cstdint>  // uint64_t
+#include <map>      // std::map
+#include <memory>   // std::shared_ptr
+#include <mutex>    // std::mutex
+#include <optional> // std::optional
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::*
+
+#include "any_map.h"       // sdbus_variant_map
+#include "dbus_properties.h"  // Prop, PropertySlots
+#include "signal_hub.h"    // SignalHub
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+/**
+ * @brief Local copy of the D-Bus properties of one object.
+ *
+ * The cache is filled with one `GetAll` call per interface and is kept up to date
+ * by the `org.freedesktop.DBus.Properties.PropertiesChanged` signal, received through the SignalHub of the object.
+ *
+ * Alternatively, it can be seeded with already known values (e.g. from a captured `GetManagedObjects` reply)
+ * and attached to the object later, once its proxy is needed anyway.
+ *
+ * The properties in DBus::PROPERTIES are additionally kept in fixed slots, so reading them
+ * through their DBus::Prop is an array access instead of two map lookups.
+ *
+ * @note internal helper class, not part of the public API. Only to be used as std::shared_ptr.
+ */
+class PropertyCache : public std::enable_shared_from_this<PropertyCache> {
+public:
+    /** @brief interface -> property -> value */
+    using Values = std::map<std::string, sdbus_variant_map>;
+
+    /**
+     * @brief Create and fill the cache.
+     * @param hub the hub of the object to mirror
+     * @param interfaces the interfaces of the object to mirror
+     */
+    PropertyCache(const std::shared_ptr<SignalHub>& hub, const std::vector<std::string>& interfaces);
+    /**
+     * @brief Create a detached cache from known values, without any D-Bus call.
+     * @param seed the values, interfaces other than the given ones are ignored
+     * @param interfaces the interfaces of the object to mirror
+     * @see attach()
+     */
+    PropertyCache(const Values& seed, const std::vector<std::string>& interfaces);
+
+    /**
+     * @brief Start keeping a seeded cache up to date, no-op if already attached.
+     *
+     * Only the signals update the seeded values, they are not read again from D-Bus.
+     * Thus only for a seed that is current, e.g. a capture whose signals are replayed.
+     */
+    void attach(const std::shared_ptr<SignalHub>& hub);
+    /** @brief Whether the cache is kept up to date. */
+    [[nodiscard]] auto attached() const -> bool;
+    /** @brief Replace the values of the given interfaces, e.g. from `InterfacesAdded`. */
+    void merge(const Values& values);
+
+    /**
+     * @brief Get a cached property value.
+     * @return the value, or an empty optional if the property is unknown
+     */
+    template<typename T>
+    [[nodiscard]] auto get(const DBus::Prop<T>& prop) const -> std::optional<T> {
+        std::lock_guard lock{mutex_};
+        if (const auto& value = slots_[prop.slot()]) {
+            return value->template get<T>();
+        }
+        return {};  // empty optional
+    }
+
+    /** @brief Get a copy of all slots, i.e. of all cached properties in DBus::PROPERTIES. */
+    [[nodiscard]] auto slots() const -> DBus::PropertySlots;
+
+    /**
+     * @brief Get a copy of all cached properties of an interface.
+     * @return the properties, empty if the interface is unknown
+     */
+    [[nodiscard]] auto get_all(const std::string& interface) const -> sdbus_variant_map;
+
+    /** @brief Number of updates received since the cache was filled. */
+    [[nodiscard]] auto generation() const -> uint64_t;
+    /** @brief Time of the last update (or of the initial fill). */
+    [[nodiscard]] auto last_update() const -> std::chrono::steady_clock::time_point;
+
+private:
+    std::vector<std::string> interfaces_;
+
+    mutable std::mutex mutex_;  // protects values_, written on the event loop thread
+    Values values_;
+    DBus::PropertySlots slots_;  // copies of the values of the properties in DBus::PROPERTIES
+
+    std::once_flag attach_once_;
+    std::atomic<bool> attached_{false};
+    std::shared_ptr<SignalHub> hub_;  // keeps the proxy alive while attached
+
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<std::chrono::steady_clock::rep> last_update_{0};
+
+    std::vector<Subscription> subscriptions_;  // last member: unsubscribe before the values are destroyed
+
+    void subscribe(SignalHub& hub);
+    void on_properties_changed(const std::string& interface, const sdbus_variant_map& changed,
+                               const std::vector<std::string>& invalidated);
+    void update_slots(const std::string& interface);
+    void touch();
+};
+
+} // namespace ezcellular
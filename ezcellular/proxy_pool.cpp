@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "proxy_pool.h"
+
+#include <algorithm> // std::find
+#include <utility>   // std::move
+
+#include "capture.h"  // CaptureTap
+#include "exception.h"
+#include "signal_hub.h"
+
+namespace ezcellular {
+
+ProxyPool::ProxyPool(std::weak_ptr<sdbus::IConnection> conn)
+    : conn_{std::move(conn)}, capture_{std::make_shared<CaptureTap>()} {}
+
+auto ProxyPool::hub(const std::string& destination, const sdbus::ObjectPath& path, const std::string& owner)
+    -> std::shared_ptr<SignalHub> {
+    std::lock_guard lock{mutex_};
+
+    if (auto it = entries_.find(path); it != entries_.end()) {
+        return it->second.hub;
+    }
+
+    auto conn = conn_.lock();
+    if (!conn) {
+        throw ConnectionException("DBus connection lost");
+    }
+    // no bus round trip: match rules are only added once the hub subscribes to a signal
+    std::shared_ptr<sdbus::IProxy> proxy = sdbus::createProxy(*conn, destination, path);
+    auto hub = SignalHub::create(std::move(proxy), capture_);
+    entries_.emplace(path, Entry{hub, owner});
+    return hub;
+}
+
+auto ProxyPool::find(const std::string& path) const -> std::shared_ptr<SignalHub> {
+    std::lock_guard lock{mutex_};
+    if (auto it = entries_.find(path); it != entries_.end()) {
+        return it->second.hub;
+    }
+    return nullptr;
+}
+
+void ProxyPool::evict(const std::string& path) {
+    std::vector<Entry> evicted;  // destroyed after unlocking, unregistering the handlers may take a while
+    {
+        std::lock_guard lock{mutex_};
+
+        std::vector<std::string> pending{path};
+        while (!pending.empty()) {
+            auto current = std::move(pending.back());
+            pending.pop_back();
+
+            if (auto it = entries_.find(current); it != entries_.end()) {
+                evicted.push_back(std::move(it->second));
+                entries_.erase(it);
+            }
+            // owned objects, and theirs
+            for (const auto& [owned_path, entry] : entries_) {
+                if (entry.owner == current) {
+                    pending.push_back(owned_path);
+                }
+            }
+        }
+    }
+}
+
+// common helper for retain: whether path is a child of prefix
+static auto below(std::string_view path, std::string_view prefix) -> bool {
+    return path.size() > prefix.size() + 1 && path.substr(0, prefix.size()) == prefix && path[prefix.size()] == '/';
+}
+
+void ProxyPool::retain(const std::string& owner, std::string_view prefix, const std::vector<sdbus::ObjectPath>& paths) {
+    std::vector<std::string> stale;
+    {
+        std::lock_guard lock{mutex_};
+        for (const auto& [path, entry] : entries_) {
+            if (entry.owner == owner && below(path, prefix)
+                && std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                stale.push_back(path);
+            }
+        }
+    }
+    for (const auto& path : stale) {
+        evict(path);
+    }
+}
+
+auto ProxyPool::size() const -> std::size_t {
+    std::lock_guard lock{mutex_};
+    return entries_.size();
+}
+
+} // namespace ezcellular
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <cstddef>     // std::size_t
+#include <map>         // std::map
+#include <memory>      // std::shared_ptr, std::weak_ptr
+#include <mutex>       // std::mutex
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::*
+
+namespace ezcellular {
+
+class CaptureTap; // IWYU pragma: keep
+class SignalHub; // IWYU pragma: keep
+
+/**
+ * @brief Proxies of the D-Bus objects in use, shared by a ModemManager and all objects obtained from it.
+ *
+ * Creating a proxy is not cheap, signal handlers register match rules with the bus daemon.
+ * So each object path gets one proxy, along with the SignalHub that owns its signal handlers,
+ * and it is reused until the object is evicted.
+ * Evicted proxies stay alive as long as someone still uses them.
+ *
+ * Objects (e.g. bearers) can have an owner (e.g. their modem). Evicting the owner evicts them as well.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class ProxyPool {
+public:
+    /** @brief Constructor, the pool doesn't keep the connection alive */
+    explicit ProxyPool(std::weak_ptr<sdbus::IConnection> conn);
+
+    /**
+     * @brief The hub (and proxy) of an object, created on first use.
+     * @param destination the bus name of the service, only used on creation: object paths are unique across services
+     * @param path the object path
+     * @param owner the object path of the owner, empty if none
+     * @throws ConnectionException if the D-Bus connection is gone
+     */
+    [[nodiscard]] auto hub(const std::string& destination, const sdbus::ObjectPath& path, const std::string& owner = {})
+        -> std::shared_ptr<SignalHub>;
+
+    /** @brief the hub of an object, if it is pooled, without creating it */
+    [[nodiscard]] auto find(const std::string& path) const -> std::shared_ptr<SignalHub>;
+    /** @brief records the signals received by all hubs of the pool, see ModemManager::start_capture() */
+    [[nodiscard]] auto capture() const -> const std::shared_ptr<CaptureTap>& { return capture_; }
+
+    /** @brief Drop the object and all objects it owns, e.g. once it is removed from the bus */
+    void evict(const std::string& path);
+    /**
+     * @brief Drop the objects of owner below prefix that are not in paths, e.g. deleted bearers
+     * @param owner the object path of the owner
+     * @param prefix the kind of objects, e.g. DBus::MM_OBJ_BEARER_PREFIX; other objects of owner (e.g. its SIM) stay
+     * @param paths the objects to keep
+     */
+    void retain(const std::string& owner, std::string_view prefix, const std::vector<sdbus::ObjectPath>& paths);
+
+    /** @brief number of pooled objects */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+private:
+    struct Entry {
+        std::shared_ptr<SignalHub> hub;
+        std::string owner;
+    };
+
+    std::weak_ptr<sdbus::IConnection> conn_;
+    std::shared_ptr<CaptureTap> capture_;
+
+    mutable std::mutex mutex_;  // protects entries_
+    std::map<std::string, Entry> entries_;  // object path -> entry
+};
+
+} // namespace ezcellular
@@ -0,0 +1,146 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "recorder.h"
+
+#include <algorithm> // std::minmax_element, std::nth_element, std::reverse
+#include <cmath>     // std::ceil
+#include <cstddef>   // std::ptrdiff_t
+#include <numeric>   // std::accumulate
+#include <utility>   // std::move
+
+#include "connection.h"
+#include "modem.h"
+
+namespace ezcellular {
+
+// common helper for the histories: all samples not older than window, oldest first
+template<typename Sample>
+static auto window_samples(const SampleRing<Sample>& ring, std::chrono::steady_clock::duration window)
+    -> std::vector<Sample> {
+    auto since = std::chrono::steady_clock::now() - window;
+    std::vector<Sample> samples;
+    ring.for_each_newest([&](const Sample& sample) {
+        if (sample.time < since) {
+            return false;
+        }
+        samples.push_back(sample);
+        return true;
+    });
+    std::reverse(samples.begin(), samples.end());
+    return samples;
+}
+
+// common helper for the histories, reorders values
+static auto aggregate(std::vector<double>& values) -> WindowStats {
+    WindowStats stats{};
+    if (values.empty()) {
+        return stats;
+    }
+
+    stats.count = values.size();
+    auto [min, max] = std::minmax_element(values.begin(), values.end());
+    stats.min = *min;
+    stats.max = *max;
+    stats.mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+
+    // nearest rank: the smallest value with at least 95 % of all values less or equal
+    auto rank = static_cast<std::size_t>(std::ceil(0.95 * static_cast<double>(values.size())));
+    auto p95 = values.begin() + static_cast<std::ptrdiff_t>(rank - 1);
+    std::nth_element(values.begin(), p95, values.end());
+    stats.p95 = *p95;
+
+    return stats;
+}
+
+// --- SignalHistory ---
+
+auto SignalHistory::samples(std::chrono::steady_clock::duration window) const -> std::vector<SignalSample> {
+    return window_samples(ring_, window);
+}
+
+// common helper for SignalHistory::stats
+static auto metric_of(const Signal& signal, SignalMetric metric) -> const std::optional<double>& {
+    switch (metric) {
+        case SignalMetric::RSRP:
+            return signal.rsrp;
+        case SignalMetric::RSRQ:
+            return signal.rsrq;
+        case SignalMetric::RSSI:
+            return signal.rssi;
+        case SignalMetric::SINR:
+        default:
+            return signal.sinr;
+    }
+}
+
+auto SignalHistory::stats(SignalMetric metric, std::chrono::steady_clock::duration window) const -> WindowStats {
+    std::vector<double> values;
+    for (const auto& sample : samples(window)) {
+        if (const auto& value = metric_of(sample.signal, metric)) {
+            values.push_back(*value);
+        }
+    }
+    return aggregate(values);
+}
+
+// --- TrafficHistory ---
+
+auto TrafficHistory::samples(std::chrono::steady_clock::duration window) const -> std::vector<TrafficSample> {
+    return window_samples(ring_, window);
+}
+
+auto TrafficHistory::stats(TrafficMetric metric, std::chrono::steady_clock::duration window) const -> WindowStats {
+    auto in_window = samples(window);
+    std::vector<double> values;
+
+    for (std::size_t i = 1; i < in_window.size(); ++i) {
+        const auto& prev = in_window[i - 1];
+        const auto& curr = in_window[i];
+        std::chrono::duration<double> elapsed = curr.time - prev.time;
+        auto prev_bytes = metric == TrafficMetric::RX_BYTES_PER_SEC ? prev.stats.rx_bytes : prev.stats.tx_bytes;
+        auto curr_bytes = metric == TrafficMetric::RX_BYTES_PER_SEC ? curr.stats.rx_bytes : curr.stats.tx_bytes;
+        if (curr_bytes < prev_bytes || elapsed.count() <= 0.0) {
+            continue;  // counter reset
+        }
+        values.push_back(static_cast<double>(curr_bytes - prev_bytes) / elapsed.count());
+    }
+    return aggregate(values);
+}
+
+// --- Recorder ---
+
+auto Recorder::record_signal(const Modem& modem, uint32_t interval_sec) -> std::shared_ptr<const SignalHistory> {
+    auto history = std::make_shared<SignalHistory>(capacity_);
+    // the observers of one subscription are run in order and never in parallel, i.e. there is a single writer
+    auto subscription = modem.observe_signal([history](Signal signal) {
+        history->record(SignalSample{std::chrono::steady_clock::now(), signal});
+    }, interval_sec);
+
+    std::lock_guard lock{mutex_};
+    subscriptions_.push_back(std::move(subscription));
+    return history;
+}
+
+auto Recorder::record_traffic(Connection& connection, uint32_t interval_ms) -> std::shared_ptr<const TrafficHistory> {
+    auto history = std::make_shared<TrafficHistory>(capacity_);
+    auto subscription = connection.observe_traffic_stats([history](TrafficStats stats) {
+        history->record(TrafficSample{std::chrono::steady_clock::now(), stats});
+    }, interval_ms);
+
+    std::lock_guard lock{mutex_};
+    subscriptions_.push_back(std::move(subscription));
+    return history;
+}
+
+void Recorder::stop() {
+    std::vector<Subscription> subscriptions;
+    {
+        std::lock_guard lock{mutex_};
+        subscriptions.swap(subscriptions_);
+    }
+    // unregistered outside of the lock
+}
+
+} // namespace ezcellular
@@ -0,0 +1,158 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <chrono>   // std::chrono::steady_clock
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint32_t
+#include <memory>   // std::shared_ptr
+#include <mutex>    // std::mutex
+#include <optional> // std::optional
+#include <vector>   // std::vector
+
+#include "sample_ring.h"   // SampleRing
+#include "structs.h"       // Signal, TrafficStats
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+class Connection; // IWYU pragma: keep
+class Modem; // IWYU pragma: keep
+
+/**
+ * @brief Aggregates of one metric over a time window, see SignalHistory and TrafficHistory.
+ */
+struct WindowStats {
+    std::size_t count = 0; ///< number of values in the window, all other members are 0 if there are none
+    double min = 0.0;      ///< smallest value
+    double max = 0.0;      ///< largest value
+    double mean = 0.0;     ///< arithmetic mean
+    double p95 = 0.0;      ///< 95th percentile (nearest rank)
+};
+
+/** @brief a recorded Signal update */
+struct SignalSample {
+    std::chrono::steady_clock::time_point time; ///< when the update was received
+    Signal signal;                              ///< the update
+};
+
+/** @brief a recorded TrafficStats update */
+struct TrafficSample {
+    std::chrono::steady_clock::time_point time; ///< when the update was received
+    TrafficStats stats;                         ///< the update
+};
+
+/** @brief the values of a SignalSample, see SignalHistory::stats() */
+enum class SignalMetric {
+    RSRP, ///< Signal::rsrp
+    RSRQ, ///< Signal::rsrq
+    RSSI, ///< Signal::rssi
+    SINR, ///< Signal::sinr
+};
+
+/** @brief the values derived from consecutive TrafficSamples, see TrafficHistory::stats() */
+enum class TrafficMetric {
+    RX_BYTES_PER_SEC, ///< see TrafficRate::rx_bytes_per_sec
+    TX_BYTES_PER_SEC, ///< see TrafficRate::tx_bytes_per_sec
+};
+
+/**
+ * @brief Signal history of one Modem, see Recorder::record_signal().
+ *
+ * Can be queried from any thread while it is recorded.
+ */
+class SignalHistory {
+public:
+    /// @private invoked by Recorder
+    explicit SignalHistory(std::size_t capacity) : ring_{capacity} {}
+
+    /** @brief the newest sample, if any */
+    [[nodiscard]] auto latest() const -> std::optional<SignalSample> { return ring_.latest(); }
+    /** @brief all samples not older than window, oldest first */
+    [[nodiscard]] auto samples(std::chrono::steady_clock::duration window) const -> std::vector<SignalSample>;
+    /**
+     * @brief Aggregate one metric over the samples not older than window.
+     * @note samples without a value for metric are skipped
+     */
+    [[nodiscard]] auto stats(SignalMetric metric, std::chrono::steady_clock::duration window) const -> WindowStats;
+
+    /// @private written by the Recorder, must only be called by one thread at a time
+    void record(const SignalSample& sample) noexcept { ring_.push(sample); }
+
+private:
+    SampleRing<SignalSample> ring_;
+};
+
+/**
+ * @brief Traffic history of one Connection, see Recorder::record_traffic().
+ *
+ * Can be queried from any thread while it is recorded.
+ */
+class TrafficHistory {
+public:
+    /// @private invoked by Recorder
+    explicit TrafficHistory(std::size_t capacity) : ring_{capacity} {}
+
+    /** @brief the newest sample, if any */
+    [[nodiscard]] auto latest() const -> std::optional<TrafficSample> { return ring_.latest(); }
+    /** @brief all samples not older than window, oldest first */
+    [[nodiscard]] auto samples(std::chrono::steady_clock::duration window) const -> std::vector<TrafficSample>;
+    /**
+     * @brief Aggregate the data rate between consecutive samples not older than window.
+     * @note intervals with a counter reset (e.g. after reconnect) are skipped
+     */
+    [[nodiscard]] auto stats(TrafficMetric metric, std::chrono::steady_clock::duration window) const -> WindowStats;
+
+    /// @private written by the Recorder, must only be called by one thread at a time
+    void record(const TrafficSample& sample) noexcept { ring_.push(sample); }
+
+private:
+    SampleRing<TrafficSample> ring_;
+};
+
+/**
+ * @brief Records signal and traffic updates into fixed-size histories, for rolling averages and percentiles.
+ *
+ * Observes each Modem and Connection once, and writes every update into a preallocated SampleRing,
+ * without allocating or locking. The histories can be shared by any number of readers.
+ * Recording ends when the Recorder is destroyed (or stop() is called), the histories stay valid.
+ *
+ * @code
+ * Recorder recorder;
+ * auto history = recorder.record_signal(*modem, 1);
+ * // ...
+ * auto rsrp = history->stats(SignalMetric::RSRP, std::chrono::minutes{1});
+ * @endcode
+ */
+class Recorder {
+public:
+    /** @brief default number of samples per history */
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+    /**
+     * @brief Create an idle recorder.
+     * @param capacity number of samples per history, see SampleRing
+     */
+    explicit Recorder(std::size_t capacity = DEFAULT_CAPACITY) : capacity_{capacity} {}
+
+    /**
+     * @brief Record the Signal updates of a modem, see Modem::observe_signal().
+     * @note observes the modem on every call, so share the returned history instead of calling it twice
+     */
+    [[nodiscard]] auto record_signal(const Modem& modem, uint32_t interval_sec) -> std::shared_ptr<const SignalHistory>;
+    /** @brief Record the TrafficStats updates of a connection, see Connection::observe_traffic_stats(). */
+    [[nodiscard]] auto record_traffic(Connection& connection, uint32_t interval_ms = 0)
+        -> std::shared_ptr<const TrafficHistory>;
+
+    /** @brief Stop all recordings. */
+    void stop();
+
+private:
+    std::size_t capacity_;
+    std::mutex mutex_;  // protects subscriptions_, only taken when a recording starts or stops
+    std::vector<Subscription> subscriptions_;
+};
+
+} // namespace ezcellular
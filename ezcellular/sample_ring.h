@@ -0,0 +1,127 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>       // std::array
+#include <atomic>      // std::atomic, std::atomic_thread_fence
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint64_t
+#include <cstring>     // std::memcpy
+#include <memory>      // std::unique_ptr
+#include <optional>    // std::optional
+#include <type_traits> // std::is_trivially_copyable_v
+
+namespace ezcellular {
+
+/**
+ * @brief Fixed-size ring of samples with a single writer and any number of concurrent readers.
+ *
+ * The memory is allocated once on construction, push() neither allocates nor locks.
+ * Once full, the oldest sample is overwritten. Every slot is protected by a sequence counter (seqlock),
+ * so readers never block the writer and skip samples that were overwritten while they read them.
+ *
+ * @tparam T the sample type, must be trivially copyable
+ */
+template<typename T>
+class SampleRing {
+    static_assert(std::is_trivially_copyable_v<T>, "samples are copied word by word");
+
+public:
+    /**
+     * @brief Allocate the ring.
+     * @param capacity max. number of samples, rounded up to the next power of two (at least 2)
+     */
+    explicit SampleRing(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1U;
+        }
+        slots_ = std::make_unique<Slot[]>(size);  // NOLINT(*-avoid-c-arrays)
+        mask_ = size - 1;
+    }
+
+    /** @brief max. number of samples */
+    [[nodiscard]] auto capacity() const -> std::size_t { return mask_ + 1; }
+    /** @brief number of samples pushed so far, including overwritten ones */
+    [[nodiscard]] auto pushed() const -> uint64_t { return head_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Append a sample, overwriting the oldest one if full.
+     * @note must only be called by one thread at a time
+     */
+    void push(const T& sample) noexcept {
+        auto index = head_.load(std::memory_order_relaxed);
+        auto& slot = slots_[index & mask_];
+
+        std::array<uint64_t, WORDS> words{};
+        std::memcpy(words.data(), &sample, sizeof(T));
+
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);  // odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            slot.data[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(2 * index + 2, std::memory_order_release);  // even: complete
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Visit the samples from the newest to the oldest, e.g. to collect a time window.
+     * @param visitor called with each sample, returns false to stop
+     */
+    template<typename Visitor>
+    void for_each_newest(Visitor&& visitor) const {
+        auto head = pushed();
+        auto oldest = head > capacity() ? head - capacity() : 0;
+        for (auto index = head; index-- > oldest;) {
+            auto sample = read(index);
+            if (!sample || !visitor(*sample)) {
+                return;  // overwritten in the meantime, so are all older ones
+            }
+        }
+    }
+
+    /** @brief the newest sample, empty if there is none */
+    [[nodiscard]] auto latest() const -> std::optional<T> {
+        auto head = pushed();
+        return head == 0 ? std::nullopt : read(head - 1);
+    }
+
+private:
+    static constexpr std::size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};  // 2 * index + 2 once the sample with that index is complete
+        std::array<std::atomic<uint64_t>, WORDS> data{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;  // NOLINT(*-avoid-c-arrays)
+    std::size_t mask_ = 0;
+    std::atomic<uint64_t> head_{0};  // index of the next sample
+
+    // the sample with the given index, empty if it was overwritten (or is being overwritten)
+    [[nodiscard]] auto read(uint64_t index) const -> std::optional<T> {
+        const auto& slot = slots_[index & mask_];
+        auto expected = 2 * index + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) {
+            return {};
+        }
+
+        std::array<uint64_t, WORDS> words{};
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.data[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != expected) {
+            return {};  // torn
+        }
+
+        T sample;
+        std::memcpy(static_cast<void*>(&sample), words.data(), sizeof(T));  // trivially copyable, see above
+        return sample;
+    }
+};
+
+} // namespace ezcellular
@@ -0,0 +1,381 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "shared_state.h"
+
+#include <atomic>       // std::atomic, std::atomic_thread_fence
+#include <cerrno>       // errno
+#include <csignal>      // kill
+#include <cstring>      // std::memcpy
+#include <iterator>     // std::back_inserter
+#include <new>          // placement new
+#include <stdexcept>    // std::runtime_error
+#include <system_error> // std::system_error
+#include <type_traits>  // std::is_trivially_copyable_v
+#include <utility>      // std::move
+
+#include <fcntl.h>    // O_* constants
+#include <sys/mman.h> // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // ftruncate, close, getpid
+
+#include "connection.h"
+#include "exception.h"
+
+namespace ezcellular {
+
+static_assert(std::is_trivially_copyable_v<SharedModemState>, "the state is copied word by word");
+
+namespace {
+
+// "ezcell" plus the version of the layout, increment on incompatible changes
+constexpr uint64_t MAGIC = 0x657a63656c6c0003;
+constexpr std::size_t WORDS = (sizeof(SharedModemState) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+// a reader gives up on a slot after this many torn reads, e.g. if the publisher died in the middle of an update
+constexpr int MAX_READ_ATTEMPTS = 1000;
+
+struct alignas(64) SharedSlot {
+    std::atomic<uint64_t> seq{0};  // odd while being written, 0 if never written; never reset, so no ABA on reuse
+    std::array<std::atomic<uint64_t>, WORDS> data{};
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "atomics in shared memory must be address-free");
+
+} // namespace
+
+/*
+ * The segment: this header, followed by slot_count SharedSlots.
+ * Only the publisher writes, readers map it read-only.
+ */
+struct alignas(64) SharedSegment {
+    uint64_t magic = MAGIC;
+    uint32_t state_size = sizeof(SharedModemState);  // detects readers built against another version
+    uint32_t slot_count = 0;
+    std::atomic<uint32_t> modems{0};  // slots used so far, a free slot holds a state with updated_ns 0
+    std::atomic<uint32_t> open{1};    // 0 once the publisher is gone
+    int32_t publisher_pid = 0;        // to detect a publisher that died without clearing open
+
+    static auto size_for(std::size_t slot_count) -> std::size_t {
+        return sizeof(SharedSegment) + slot_count * sizeof(SharedSlot);
+    }
+    [[nodiscard]] auto slot(std::size_t index) -> SharedSlot& {
+        return reinterpret_cast<SharedSlot*>(this + 1)[index];  // NOLINT(*-reinterpret-cast)
+    }
+    [[nodiscard]] auto slot(std::size_t index) const -> const SharedSlot& {
+        return reinterpret_cast<const SharedSlot*>(this + 1)[index];  // NOLINT(*-reinterpret-cast)
+    }
+};
+
+// seqlock write, must only be called by one thread at a time per slot
+static void write_slot(SharedSlot& slot, const SharedModemState& state) noexcept {
+    std::array<uint64_t, WORDS> words{};
+    std::memcpy(words.data(), &state, sizeof(state));
+
+    auto seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);  // odd: being written
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < WORDS; ++i) {
+        slot.data[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(seq + 2, std::memory_order_release);  // even: complete
+}
+
+// seqlock read, retried while the slot is being written
+static auto read_slot(const SharedSlot& slot) -> std::optional<SharedModemState> {
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        auto seq = slot.seq.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return {};  // never written
+        }
+        if (seq % 2 != 0) {
+            continue;  // being written
+        }
+
+        std::array<uint64_t, WORDS> words{};
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.data[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            continue;  // torn
+        }
+
+        SharedModemState state;
+        std::memcpy(static_cast<void*>(&state), words.data(), sizeof(state));
+        if (state.updated_ns == 0) {
+            return {};  // freed by unpublish()
+        }
+        return state;
+    }
+    return {};
+}
+
+static auto now_ns() -> uint64_t {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+// --- SharedStatePublisher ---
+
+/*
+ * A published modem: the local copy of its state, which is written to its slot on every change.
+ */
+struct SharedStatePublisher::Entry {
+    std::shared_ptr<SharedSegment> segment;
+    std::size_t index;
+    Modem modem;  // with property cache, so snapshot() makes no D-Bus calls
+    std::string imei;  // identifies the modem across re-enumerations
+    std::vector<Subscription> subscriptions;  // protected by the mutex of the publisher
+    std::mutex mutex;  // one writer per slot, protects the members below
+    SharedModemState state{};
+    bool published = true;  // false once replaced or unpublished, late callbacks must not touch the slot
+
+    Entry(std::shared_ptr<SharedSegment> segment_, std::size_t index_, Modem modem_, std::string imei_)
+        : segment{std::move(segment_)}, index{index_}, modem{std::move(modem_)}, imei{std::move(imei_)} {}
+
+    // apply change to the state and publish it
+    template<typename Change>
+    void update(Change&& change) {
+        std::lock_guard lock{mutex};
+        if (!published) {
+            return;
+        }
+        change(state);
+        state.updated_ns = now_ns();
+        write_slot(segment->slot(index), state);
+    }
+
+    // stop writing to the slot, free it unless it is taken over by another entry
+    void retire(bool free_slot) {
+        std::lock_guard lock{mutex};
+        published = false;
+        if (free_slot) {
+            write_slot(segment->slot(index), SharedModemState{});
+        }
+    }
+
+    void apply(const ModemSnapshot& snapshot) {  // expects mutex to be locked
+        state.imei.assign(snapshot.imei);
+        state.manufacturer.assign(snapshot.manufacturer);
+        state.model.assign(snapshot.model);
+        state.firmware_version.assign(snapshot.firmware_version);
+        state.state = snapshot.state;
+        state.power_state = snapshot.power_state;
+        state.lock_state = snapshot.lock_state;
+        state.technology = snapshot.technology;
+        state.operator_plmn.assign(snapshot.operator_plmn);
+        state.operator_name.assign(snapshot.operator_name);
+        if (!snapshot.signal.empty()) {
+            state.signal = snapshot.signal;
+        }
+        apply(snapshot.location);
+    }
+
+    void apply(const Location& location) {  // expects mutex to be locked
+        state.location_tech = location.tech;
+        state.mcc.assign(location.mcc);
+        state.mnc.assign(location.mnc);
+        state.ci = location.ci;
+        state.tac = location.tac;
+    }
+
+    // an update of the modem: take everything else from the cache, it was updated by the same signal
+    template<typename Change>
+    void refresh(Change&& change) {
+        auto snapshot = modem.snapshot();
+        update([&](SharedModemState& current) {
+            apply(snapshot);
+            change(current);
+        });
+    }
+};
+
+SharedStatePublisher::SharedStatePublisher(const std::string& name, std::size_t max_modems) : name_{name} {
+    ::shm_unlink(name.c_str());  // a stale segment, e.g. of a crashed publisher; readers keep their mapping
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "shm_open " + name};
+    }
+
+    auto size = SharedSegment::size_for(max_modems);
+    if (::ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        auto error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::system_error{error, std::generic_category(), "ftruncate " + name};
+    }
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    auto error = errno;
+    ::close(fd);  // the mapping stays valid
+    if (memory == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::system_error{error, std::generic_category(), "mmap " + name};
+    }
+
+    auto* segment = new (memory) SharedSegment{};
+    segment->slot_count = static_cast<uint32_t>(max_modems);
+    segment->publisher_pid = static_cast<int32_t>(::getpid());
+    for (std::size_t i = 0; i < max_modems; ++i) {
+        new (&segment->slot(i)) SharedSlot{};
+    }
+    segment_ = std::shared_ptr<SharedSegment>{segment, [size](SharedSegment* mapped) { ::munmap(mapped, size); }};
+    entries_.resize(max_modems);
+}
+
+SharedStatePublisher::~SharedStatePublisher() {
+    stop();
+    segment_->open.store(0, std::memory_order_release);
+    ::shm_unlink(name_.c_str());
+}
+
+auto SharedStatePublisher::publish(const Modem& modem, uint32_t signal_interval_sec) -> std::size_t {
+    Modem cached = modem;
+    cached.enable_property_cache();
+    auto snapshot = cached.snapshot();  // also attaches the cache
+
+    std::vector<Subscription> replaced;  // of a replaced entry, unregistered after the lock is released
+    std::lock_guard lock{mutex_};
+    auto slot = entries_.size();
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i] && !snapshot.imei.empty() && entries_[i]->imei == snapshot.imei) {
+            slot = i;  // the same modem, e.g. re-enumerated after a reset
+            break;
+        }
+        if (!entries_[i] && slot == entries_.size()) {
+            slot = i;
+        }
+    }
+    if (slot == entries_.size()) {
+        throw ModemException{"SharedStatePublisher: all slots in use"};
+    }
+    if (entries_[slot]) {
+        entries_[slot]->retire(false);
+        replaced.swap(entries_[slot]->subscriptions);
+    }
+
+    auto entry = std::make_shared<Entry>(segment_, slot, std::move(cached), snapshot.imei);
+    entry->update([&](SharedModemState&) { entry->apply(snapshot); });
+
+    auto& subscriptions = entry->subscriptions;
+    subscriptions.push_back(entry->modem.observe_modem_state([entry](Modem::ModemState, Modem::ModemState state) {
+        entry->refresh([state](SharedModemState& current) { current.state = state; });
+    }));
+    subscriptions.push_back(entry->modem.observe_signal([entry](Signal signal) {
+        entry->refresh([signal](SharedModemState& current) { current.signal = signal; });
+    }, signal_interval_sec));
+    subscriptions.push_back(entry->modem.observe_location([entry](const Location& location) {
+        entry->refresh([&](SharedModemState&) { entry->apply(location); });
+    }));
+
+    entries_[slot] = entry;
+    if (slot >= segment_->modems.load(std::memory_order_relaxed)) {
+        segment_->modems.store(static_cast<uint32_t>(slot + 1), std::memory_order_release);
+    }
+    return slot;
+}
+
+void SharedStatePublisher::unpublish(std::size_t slot) {
+    std::vector<Subscription> subscriptions;
+    {
+        std::lock_guard lock{mutex_};
+        if (slot >= entries_.size() || !entries_[slot]) {
+            return;
+        }
+        entries_[slot]->retire(true);
+        subscriptions.swap(entries_[slot]->subscriptions);
+        entries_[slot].reset();
+    }
+    // unregistered outside of the lock
+}
+
+void SharedStatePublisher::publish_traffic(std::size_t slot, Connection& connection, uint32_t interval_ms) {
+    std::lock_guard lock{mutex_};
+    if (slot >= entries_.size() || !entries_[slot]) {
+        throw ModemException{"SharedStatePublisher: no modem in slot " + std::to_string(slot)};
+    }
+    auto entry = entries_[slot];
+    entry->subscriptions.push_back(connection.observe_traffic_stats([entry](TrafficStats stats) {
+        entry->update([stats](SharedModemState& current) { current.traffic = stats; });
+    }, interval_ms));
+}
+
+void SharedStatePublisher::stop() {
+    std::vector<Subscription> subscriptions;
+    {
+        std::lock_guard lock{mutex_};
+        for (const auto& entry : entries_) {
+            if (entry) {
+                std::move(entry->subscriptions.begin(), entry->subscriptions.end(), std::back_inserter(subscriptions));
+                entry->subscriptions.clear();
+            }
+        }
+    }
+    // unregistered outside of the lock
+}
+
+// --- SharedStateReader ---
+
+SharedStateReader::SharedStateReader(const std::string& name) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "shm_open " + name};
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) < 0) {
+        auto error = errno;
+        ::close(fd);
+        throw std::system_error{error, std::generic_category(), "fstat " + name};
+    }
+    auto size = static_cast<std::size_t>(info.st_size);
+    void* memory = size < sizeof(SharedSegment) ? MAP_FAILED : ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error{"SharedStateReader: can't map " + name};
+    }
+
+    const auto* segment = static_cast<const SharedSegment*>(memory);
+    if (segment->magic != MAGIC || segment->state_size != sizeof(SharedModemState)
+        || size < SharedSegment::size_for(segment->slot_count)) {
+        ::munmap(memory, size);
+        throw std::runtime_error{"SharedStateReader: incompatible segment " + name};
+    }
+    segment_ = segment;
+    size_ = size;
+}
+
+SharedStateReader::~SharedStateReader() {
+    ::munmap(const_cast<SharedSegment*>(segment_), size_);  // NOLINT(*-const-cast)
+}
+
+auto SharedStateReader::open() const -> bool {
+    if (segment_->open.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    // a crashed publisher never clears open; EPERM: alive, but owned by another user
+    return ::kill(segment_->publisher_pid, 0) == 0 || errno == EPERM;
+}
+
+auto SharedStateReader::modem_count() const -> std::size_t {
+    auto modems = segment_->modems.load(std::memory_order_acquire);
+    return modems < segment_->slot_count ? modems : segment_->slot_count;
+}
+
+auto SharedStateReader::read(std::size_t slot) const -> std::optional<SharedModemState> {
+    if (slot >= modem_count()) {
+        return {};
+    }
+    return read_slot(segment_->slot(slot));
+}
+
+auto SharedStateReader::find(std::string_view imei) const -> std::optional<SharedModemState> {
+    for (std::size_t slot = 0; slot < modem_count(); ++slot) {
+        auto state = read(slot);
+        if (state && state->imei.view() == imei) {
+            return state;
+        }
+    }
+    return {};
+}
+
+} // namespace ezcellular
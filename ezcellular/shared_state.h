@@ -0,0 +1,223 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>       // std::array
+#include <chrono>      // std::chrono::steady_clock
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint64_t
+#include <memory>      // std::shared_ptr
+#include <mutex>       // std::mutex
+#include <optional>    // std::optional
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+#include "modem.h"         // Modem
+#include "structs.h"       // Signal, Location, TrafficStats
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+class Connection; // IWYU pragma: keep
+
+/** @brief default name of the shared memory segment, see SharedStatePublisher */
+constexpr auto DEFAULT_SHARED_STATE_NAME = "/ezcellular";
+
+/**
+ * @brief Null-terminated string of fixed capacity, so that it can be placed in shared memory.
+ * @tparam N capacity including the terminator, longer strings are truncated
+ */
+template<std::size_t N>
+struct FixedString {
+    std::array<char, N> chars{}; ///< the string, null-terminated
+
+    /** @brief the string */
+    [[nodiscard]] auto view() const -> std::string_view {
+        std::size_t length = 0;
+        while (length < N - 1 && chars[length] != '\0') {
+            ++length;
+        }
+        return {chars.data(), length};
+    }
+
+    /** @brief Replace the string, truncated to N - 1 chars. */
+    void assign(std::string_view str) {
+        auto length = str.size() < N - 1 ? str.size() : N - 1;
+        str.copy(chars.data(), length);
+        chars[length] = '\0';
+    }
+};
+
+/**
+ * @brief The state of one modem as published by a SharedStatePublisher.
+ *
+ * Trivially copyable, with fixed-size strings (see FixedString). Values that are not available are left empty.
+ */
+struct SharedModemState {
+    uint64_t updated_ns = 0;                 ///< time of the last update, steady_clock (CLOCK_MONOTONIC) in ns
+    FixedString<24> imei;                    ///< see ModemSnapshot::imei
+    FixedString<64> manufacturer;            ///< see ModemSnapshot::manufacturer
+    FixedString<64> model;                   ///< see ModemSnapshot::model
+    FixedString<64> firmware_version;        ///< see ModemSnapshot::firmware_version
+    Modem::ModemState state{};               ///< see ModemSnapshot::state
+    Modem::PowerState power_state{};         ///< see ModemSnapshot::power_state
+    Modem::LockState lock_state{};           ///< see ModemSnapshot::lock_state
+    Technology technology{};                 ///< see ModemSnapshot::technology
+    FixedString<8> operator_plmn;            ///< see ModemSnapshot::operator_plmn
+    FixedString<64> operator_name;           ///< see ModemSnapshot::operator_name
+    Signal signal;                           ///< the latest Signal update
+    Technology location_tech{};              ///< see Location::tech
+    FixedString<4> mcc;                      ///< see Location::mcc
+    FixedString<4> mnc;                      ///< see Location::mnc
+    std::optional<uint64_t> ci;              ///< see Location::ci
+    std::optional<uint32_t> tac;             ///< see Location::tac
+    std::optional<TrafficStats> traffic;     ///< the latest counters, if a Connection is published
+
+    /** @brief when the state was last updated, comparable across processes */
+    [[nodiscard]] auto updated() const -> std::chrono::steady_clock::time_point {
+        return std::chrono::steady_clock::time_point{std::chrono::nanoseconds{updated_ns}};
+    }
+    /** @brief the location fields as Location */
+    [[nodiscard]] auto location() const -> Location {
+        return Location{location_tech, std::string{mcc.view()}, std::string{mnc.view()}, ci, tac};
+    }
+};
+
+/// @private layout of the shared memory segment, see shared_state.cpp
+struct SharedSegment;
+
+/**
+ * @brief Publishes the state of modems into a shared memory segment, for SharedStateReaders in other processes.
+ *
+ * One process runs the ModemManager and publishes, any number of local processes read the latest values
+ * without a D-Bus connection of their own. Each modem has a fixed slot protected by a sequence counter
+ * (seqlock, like SampleRing), so readers neither lock nor block the publisher. A modem keeps its slot when it
+ * re-enumerates (same IMEI), slots of unpublished modems are reused.
+ *
+ * The values are taken from the property cache of the modem (see Modem::enable_property_cache())
+ * whenever its state, signal or location changes, so publishing makes no additional D-Bus calls.
+ *
+ * @code
+ * SharedStatePublisher publisher;
+ * for (const auto& modem : mm.available_modems()) {
+ *     publisher.publish(modem);
+ * }
+ * @endcode
+ * @note the segment is removed when the publisher is destroyed
+ */
+class SharedStatePublisher {
+public:
+    /** @brief default number of slots */
+    static constexpr std::size_t DEFAULT_MAX_MODEMS = 8;
+
+    /**
+     * @brief Create the segment, replacing a stale one of a previous publisher.
+     * @param name of the POSIX shared memory object, starting with `/`
+     * @param max_modems number of slots
+     * @throws std::system_error if the segment can't be created
+     */
+    explicit SharedStatePublisher(const std::string& name = DEFAULT_SHARED_STATE_NAME,
+                                  std::size_t max_modems = DEFAULT_MAX_MODEMS);
+    /** @brief Stop publishing, mark the segment as closed and remove it. */
+    ~SharedStatePublisher();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    SharedStatePublisher(const SharedStatePublisher&) = delete;
+    SharedStatePublisher& operator=(const SharedStatePublisher&) = delete;
+    SharedStatePublisher(SharedStatePublisher&&) = delete;
+    SharedStatePublisher& operator=(SharedStatePublisher&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /**
+     * @brief Publish the state of a modem: once now, then on every change.
+     *
+     * If a modem with the same IMEI is already published, e.g. before it was reset, it is replaced in its slot.
+     * @param modem the modem, its property cache is enabled
+     * @param signal_interval_sec interval of the signal updates, see Modem::observe_signal()
+     * @return the slot of the modem, see SharedStateReader::read()
+     * @throws ModemException if all slots are in use
+     * @note must not be called from within an observer callback (takes a first snapshot)
+     */
+    auto publish(const Modem& modem, uint32_t signal_interval_sec = 5) -> std::size_t;
+    /**
+     * @brief Stop publishing the modem in slot and free the slot, readers no longer find it.
+     * @param slot as returned by publish(), ignored if not in use
+     * @note must not be called from within an observer callback of that modem
+     */
+    void unpublish(std::size_t slot);
+    /**
+     * @brief Publish the traffic counters of a connection in the slot of its modem.
+     * @param slot as returned by publish()
+     * @param connection the connection of that modem
+     * @param interval_ms see Connection::observe_traffic_stats()
+     * @throws ModemException if the slot is not in use
+     */
+    void publish_traffic(std::size_t slot, Connection& connection, uint32_t interval_ms = 0);
+
+    /** @brief Stop all updates, the published values are kept. */
+    void stop();
+
+private:
+    struct Entry;
+
+    std::string name_;
+    std::shared_ptr<SharedSegment> segment_;  // shared with the callbacks, which may outlive stop() on an executor
+    std::mutex mutex_;  // protects entries_, only taken when publishing starts or stops
+    std::vector<std::shared_ptr<Entry>> entries_;  // by slot, empty if free
+};
+
+/**
+ * @brief Reads the modem states of a SharedStatePublisher in another process, lock-free.
+ *
+ * The segment is mapped read-only, a read() is a copy of the slot plus two atomic loads.
+ *
+ * @code
+ * SharedStateReader reader;
+ * if (auto state = reader.find(imei)) {
+ *     std::cout << state->operator_name.view() << '\n';
+ * }
+ * @endcode
+ */
+class SharedStateReader {
+public:
+    /**
+     * @brief Map the segment of a running publisher.
+     * @param name see SharedStatePublisher
+     * @throws std::system_error if there is no segment, std::runtime_error if it is incompatible
+     */
+    explicit SharedStateReader(const std::string& name = DEFAULT_SHARED_STATE_NAME);
+    ~SharedStateReader();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    SharedStateReader(const SharedStateReader&) = delete;
+    SharedStateReader& operator=(const SharedStateReader&) = delete;
+    SharedStateReader(SharedStateReader&&) = delete;
+    SharedStateReader& operator=(SharedStateReader&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /**
+     * @brief Whether the publisher is still running.
+     *
+     * False after it was destroyed, and also if its process died without doing so (checked by its pid).
+     * @note once false, the segment is gone and a new reader is needed for a new publisher
+     */
+    [[nodiscard]] auto open() const -> bool;
+    /** @brief number of slots that were used so far, the modems are in slots 0 .. modem_count() - 1 */
+    [[nodiscard]] auto modem_count() const -> std::size_t;
+    /**
+     * @brief Copy the state in slot.
+     * @return the state, empty if the slot is not in use (or the publisher stalled in the middle of an update)
+     */
+    [[nodiscard]] auto read(std::size_t slot) const -> std::optional<SharedModemState>;
+    /** @brief the state of the modem with the given IMEI, if published */
+    [[nodiscard]] auto find(std::string_view imei) const -> std::optional<SharedModemState>;
+
+private:
+    const SharedSegment* segment_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace ezcellular
@@ -0,0 +1,208 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "signal_hub.h"
+
+#include <algorithm> // std::remove
+#include <utility>   // std::pair, std::move
+
+#include "capture.h"  // CaptureTap
+#include "dbus_constants.h"
+
+namespace ezcellular {
+
+auto SignalHub::create(std::shared_ptr<sdbus::IProxy> proxy, std::shared_ptr<CaptureTap> capture)
+    -> std::shared_ptr<SignalHub> {
+    return std::shared_ptr<SignalHub>{new SignalHub{std::move(proxy), std::move(capture)}};
+}
+
+// --- subscribing ---
+
+template<typename Callback>
+auto SignalHub::add(List<Callback>& list, Callback callback) -> std::shared_ptr<Entry<Callback>> {
+    auto entry = std::make_shared<Entry<Callback>>();
+    entry->callback = std::move(callback);
+
+    auto copy = list ? *list : std::vector<std::shared_ptr<Entry<Callback>>>{};
+    copy.push_back(entry);
+    list = std::make_shared<const std::vector<std::shared_ptr<Entry<Callback>>>>(std::move(copy));
+    return entry;
+}
+
+template<typename Callback>
+void SignalHub::remove(List<Callback>& list, const std::shared_ptr<Entry<Callback>>& entry) {
+    if (!list) {
+        return;
+    }
+    auto copy = *list;
+    copy.erase(std::remove(copy.begin(), copy.end(), entry), copy.end());
+    list = copy.empty() ? nullptr : std::make_shared<const std::vector<std::shared_ptr<Entry<Callback>>>>(std::move(copy));
+}
+
+// deactivate the entry (waiting for a running callback), then remove it from its list
+template<typename Callback, typename Remove>
+auto SignalHub::make_subscription(std::shared_ptr<Entry<Callback>> entry, Remove remove_entry) -> Subscription {
+    return Subscription{[weak_hub = weak_from_this(), entry = std::move(entry), remove_entry = std::move(remove_entry)]() {
+        {
+            std::lock_guard entry_lock{entry->mutex};
+            entry->active = false;
+        }
+        if (auto hub = weak_hub.lock()) {
+            std::lock_guard lock{hub->mutex_};
+            remove_entry(*hub, entry);
+        }
+    }};
+}
+
+auto SignalHub::subscribe_interface(const std::string& interface, PropertiesCallback callback) -> Subscription {
+    register_properties_changed();
+
+    std::lock_guard lock{mutex_};
+    auto entry = add(interface_subs_[interface], std::move(callback));
+    return make_subscription(std::move(entry), [interface](SignalHub& hub, const auto& entry_) {
+        remove(hub.interface_subs_[interface], entry_);
+    });
+}
+
+auto SignalHub::subscribe_property(const std::string& interface, const std::string& name,
+                                   PropertyCallback callback) -> Subscription {
+    register_properties_changed();
+
+    std::lock_guard lock{mutex_};
+    auto entry = add(property_subs_[interface][name], std::move(callback));
+    return make_subscription(std::move(entry), [interface, name](SignalHub& hub, const auto& entry_) {
+        remove(hub.property_subs_[interface][name], entry_);
+    });
+}
+
+auto SignalHub::subscribe_state_changed(StateChangedCallback callback) -> Subscription {
+    register_state_changed();
+
+    std::lock_guard lock{mutex_};
+    auto entry = add(state_subs_, std::move(callback));
+    return make_subscription(std::move(entry), [](SignalHub& hub, const auto& entry_) {
+        remove(hub.state_subs_, entry_);
+    });
+}
+
+auto SignalHub::subscribe_network_time(NetworkTimeCallback callback) -> Subscription {
+    register_network_time();
+
+    std::lock_guard lock{mutex_};
+    auto entry = add(time_subs_, std::move(callback));
+    return make_subscription(std::move(entry), [](SignalHub& hub, const auto& entry_) {
+        remove(hub.time_subs_, entry_);
+    });
+}
+
+// --- D-Bus handlers, registered once per hub ---
+
+// record a received signal, if capturing
+template<typename... Args>
+void SignalHub::capture(const char* interface, const char* member, const Args&... args) const {
+    if (capture_ && capture_->active()) {
+        capture_->record(CaptureKind::SIGNAL, proxy_->getObjectPath(), interface, member, args...);
+    }
+}
+
+void SignalHub::register_properties_changed() {
+    std::call_once(properties_registered_, [this]() {
+        proxy_->uponSignal("PropertiesChanged").onInterface(DBus::DBUS_IF_PROPERTIES).call(
+            [weak_hub = weak_from_this()](const std::string& interfaceName,
+                                          const sdbus_variant_map& changedProperties,
+                                          const std::vector<std::string>& invalidatedProperties) {
+                if (auto hub = weak_hub.lock()) {
+                    hub->capture(DBus::DBUS_IF_PROPERTIES, "PropertiesChanged", interfaceName, changedProperties,
+                                 invalidatedProperties);
+                    hub->on_properties_changed(interfaceName, changedProperties, invalidatedProperties);
+                }
+            });
+        proxy_->finishRegistration();
+    });
+}
+
+void SignalHub::register_state_changed() {
+    std::call_once(state_registered_, [this]() {
+        // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+        proxy_->uponSignal("StateChanged").onInterface(DBus::MM_IF_MODEM).call(
+            [weak_hub = weak_from_this()](int32_t old_state, int32_t new_state, uint32_t reason) {
+                if (auto hub = weak_hub.lock()) {
+                    hub->capture(DBus::MM_IF_MODEM, "StateChanged", old_state, new_state, reason);
+                    hub->on_state_changed(old_state, new_state, reason);
+                }
+            });
+        proxy_->finishRegistration();
+    });
+}
+
+void SignalHub::register_network_time() {
+    std::call_once(time_registered_, [this]() {
+        proxy_->uponSignal("NetworkTimeChanged").onInterface(DBus::MM_IF_MODEM_TIME).call(
+            [weak_hub = weak_from_this()](const std::string& time) {
+                if (auto hub = weak_hub.lock()) {
+                    hub->capture(DBus::MM_IF_MODEM_TIME, "NetworkTimeChanged", time);
+                    hub->on_network_time(time);
+                }
+            });
+        proxy_->finishRegistration();
+    });
+}
+
+template<typename Callback, typename... Args>
+void SignalHub::dispatch(const List<Callback>& list, const Args&... args) {
+    if (!list) {
+        return;
+    }
+    for (const auto& entry : *list) {
+        std::lock_guard lock{entry->mutex};
+        if (entry->active) {
+            entry->callback(args...);
+        }
+    }
+}
+
+void SignalHub::on_properties_changed(const std::string& interface, const sdbus_variant_map& changed,
+                                      const std::vector<std::string>& invalidated) {
+    // take references to the current lists, subscribers may change while dispatching
+    List<PropertiesCallback> iface_list;
+    std::vector<std::pair<List<PropertyCallback>, const sdbus::Variant*>> prop_lists;
+    {
+        std::lock_guard lock{mutex_};
+        if (auto it = interface_subs_.find(interface); it != interface_subs_.end()) {
+            iface_list = it->second;
+        }
+        if (auto props_it = property_subs_.find(interface); props_it != property_subs_.end()) {
+            for (const auto& [name, value] : changed) {
+                if (auto it = props_it->second.find(name); it != props_it->second.end() && it->second) {
+                    prop_lists.emplace_back(it->second, &value);
+                }
+            }
+        }
+    }
+
+    dispatch(iface_list, changed, invalidated);
+    for (const auto& [list, value] : prop_lists) {
+        dispatch(list, *value);
+    }
+}
+
+void SignalHub::on_state_changed(int32_t old_state, int32_t new_state, uint32_t reason) {
+    List<StateChangedCallback> list;
+    {
+        std::lock_guard lock{mutex_};
+        list = state_subs_;
+    }
+    dispatch(list, old_state, new_state, reason);
+}
+
+void SignalHub::on_network_time(const std::string& time) {
+    List<NetworkTimeCallback> list;
+    {
+        std::lock_guard lock{mutex_};
+        list = time_subs_;
+    }
+    dispatch(list, time);
+}
+
+} // namespace ezcellular
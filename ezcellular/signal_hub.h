@@ -0,0 +1,138 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <cstdint>    // int32_t, uint32_t
+#include <functional> // std::function
+#include <map>        // std::map
+#include <memory>     // std::shared_ptr, std::weak_ptr
+#include <mutex>      // std::mutex, std::once_flag
+#include <string>     // std::string
+#include <utility>    // std::move
+#include <vector>     // std::vector
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::*
+
+#include "any_map.h"       // sdbus_variant_map
+#include "dbus_properties.h"  // Prop
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+class CaptureTap; // IWYU pragma: keep
+
+/**
+ * @brief Demultiplexer for the signals of one D-Bus object.
+ *
+ * Registers a single handler per signal on the proxy, decodes each message once
+ * and routes it by interface and property to the subscribers.
+ * Subscribers can be added and removed at any time, from any thread.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class SignalHub : public std::enable_shared_from_this<SignalHub> {
+public:
+    /** @brief all changes of one interface, see org.freedesktop.DBus.Properties.PropertiesChanged */
+    using PropertiesCallback = std::function<void(const sdbus_variant_map& changed,
+                                                  const std::vector<std::string>& invalidated)>;
+    /** @brief new value of one property */
+    using PropertyCallback = std::function<void(const sdbus::Variant& value)>;
+    /** @brief org.freedesktop.ModemManager1.Modem.StateChanged(old, new, reason) */
+    using StateChangedCallback = std::function<void(int32_t old_state, int32_t new_state, uint32_t reason)>;
+    /** @brief org.freedesktop.ModemManager1.Modem.Time.NetworkTimeChanged(time) */
+    using NetworkTimeCallback = std::function<void(const std::string& time)>;
+
+    /**
+     * @brief create a hub for the object of proxy, only as std::shared_ptr
+     * @param proxy the proxy to listen on
+     * @param capture records the received signals while it is active, may be nullptr
+     */
+    static auto create(std::shared_ptr<sdbus::IProxy> proxy, std::shared_ptr<CaptureTap> capture = nullptr)
+        -> std::shared_ptr<SignalHub>;
+
+    /** @brief the proxy the hub is listening on */
+    [[nodiscard]] auto proxy() const -> sdbus::IProxy& { return *proxy_; }
+    /** @brief see proxy(), for callers that need to keep it alive */
+    [[nodiscard]] auto shared_proxy() const -> std::shared_ptr<sdbus::IProxy> { return proxy_; }
+
+    /** @brief get notified about property changes of an interface */
+    [[nodiscard]] auto subscribe_interface(const std::string& interface, PropertiesCallback callback) -> Subscription;
+    /** @brief get notified about value changes of one property */
+    [[nodiscard]] auto subscribe_property(const std::string& interface, const std::string& name,
+                                          PropertyCallback callback) -> Subscription;
+    /** @brief get notified about value changes of one property, already converted to its type */
+    template<typename T, typename Callback>
+    [[nodiscard]] auto watch(const DBus::Prop<T>& prop, Callback callback) -> Subscription {
+        return subscribe_property(prop.interface(), prop.name(),
+                                  [callback = std::move(callback)](const sdbus::Variant& value) {
+                                      callback(value.get<T>());
+                                  });
+    }
+    /** @brief get notified about modem state changes */
+    [[nodiscard]] auto subscribe_state_changed(StateChangedCallback callback) -> Subscription;
+    /** @brief get notified about network time updates */
+    [[nodiscard]] auto subscribe_network_time(NetworkTimeCallback callback) -> Subscription;
+
+    /*
+     * The D-Bus handlers route each signal to the subscribers with these, replaying a capture as well
+     * (see ModemManager::replay()). Nothing is recorded by them.
+     */
+
+    /** @brief route a PropertiesChanged signal */
+    void on_properties_changed(const std::string& interface, const sdbus_variant_map& changed,
+                               const std::vector<std::string>& invalidated);
+    /** @brief route a StateChanged signal */
+    void on_state_changed(int32_t old_state, int32_t new_state, uint32_t reason);
+    /** @brief route a NetworkTimeChanged signal */
+    void on_network_time(const std::string& time);
+
+private:
+    SignalHub(std::shared_ptr<sdbus::IProxy> proxy, std::shared_ptr<CaptureTap> capture)
+        : proxy_{std::move(proxy)}, capture_{std::move(capture)} {}
+
+    /*
+     * A subscriber. The mutex is held while the callback runs, so that unsubscribing
+     * waits for a running callback. Recursive, to allow unsubscribing from within the callback.
+     */
+    template<typename Callback>
+    struct Entry {
+        std::recursive_mutex mutex;
+        bool active = true;
+        Callback callback;
+    };
+    // copy-on-write lists: dispatching only takes a reference, without copying the subscribers
+    template<typename Callback>
+    using List = std::shared_ptr<const std::vector<std::shared_ptr<Entry<Callback>>>>;
+
+    std::shared_ptr<sdbus::IProxy> proxy_;
+    std::shared_ptr<CaptureTap> capture_;
+
+    std::mutex mutex_;  // protects the maps below
+    std::map<std::string, List<PropertiesCallback>> interface_subs_;
+    std::map<std::string, std::map<std::string, List<PropertyCallback>>> property_subs_;  // interface -> name -> list
+    List<StateChangedCallback> state_subs_;
+    List<NetworkTimeCallback> time_subs_;
+
+    std::once_flag properties_registered_;
+    std::once_flag state_registered_;
+    std::once_flag time_registered_;
+
+    void register_properties_changed();
+    void register_state_changed();
+    void register_network_time();
+    template<typename... Args>
+    void capture(const char* interface, const char* member, const Args&... args) const;
+
+    template<typename Callback>
+    auto add(List<Callback>& list, Callback callback) -> std::shared_ptr<Entry<Callback>>;
+    template<typename Callback>
+    static void remove(List<Callback>& list, const std::shared_ptr<Entry<Callback>>& entry);
+    template<typename Callback, typename Remove>
+    auto make_subscription(std::shared_ptr<Entry<Callback>> entry, Remove remove_entry) -> Subscription;
+    template<typename Callback, typename... Args>
+    static void dispatch(const List<Callback>& list, const Args&... args);
+};
+
+} // namespace ezcellular
@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "signal_rate.h"
+
+#include "call_metrics.h"  // CallSiteRef, CallTimer
+#include "dbus_constants.h"
+
+namespace ezcellular {
+
+auto SignalRate::request(const std::shared_ptr<sdbus::IProxy>& proxy, const RateReader& current_rate,
+                         uint32_t interval_sec) -> Subscription {
+    if (interval_sec == 0) {
+        return {};  // no preference, nothing to restore
+    }
+
+    std::lock_guard lock{mutex_};
+    know(current_rate);
+    requests_.insert(interval_sec);
+    apply(*proxy, *requests_.begin());
+
+    return Subscription{[weak_self = weak_from_this(), proxy, interval_sec]() {
+        if (auto self = weak_self.lock()) {
+            self->release(*proxy, interval_sec);
+        }
+    }};
+}
+
+auto SignalRate::ensure(sdbus::IProxy& proxy, const RateReader& current_rate, uint32_t default_sec) -> bool {
+    std::lock_guard lock{mutex_};
+    know(current_rate);
+    if (*applied_ != 0) {
+        return true;
+    }
+    baseline_ = default_sec;
+    apply(proxy, default_sec);
+    return false;
+}
+
+auto SignalRate::applied() const -> std::optional<uint32_t> {
+    std::lock_guard lock{mutex_};
+    return applied_;
+}
+
+// (private) the current rate is the baseline until the first request
+void SignalRate::know(const RateReader& current_rate) {
+    if (!applied_) {
+        applied_ = current_rate();
+        sent_ = *applied_;
+        baseline_ = *applied_;
+    }
+}
+
+void SignalRate::release(sdbus::IProxy& proxy, uint32_t interval_sec) {
+    std::lock_guard lock{mutex_};
+    if (auto it = requests_.find(interval_sec); it != requests_.end()) {
+        requests_.erase(it);
+    }
+    apply(proxy, requests_.empty() ? baseline_ : *requests_.begin());
+}
+
+void SignalRate::apply(sdbus::IProxy& proxy, uint32_t rate) {
+    if (sent_ == rate) {
+        return;  // already set, or on its way
+    }
+    // sent in order while holding the mutex, without waiting for the modem
+    static CallSiteRef site{DBus::MM_IF_MODEM_SIGNAL, "Setup"};
+    proxy.callMethodAsync("Setup").onInterface(DBus::MM_IF_MODEM_SIGNAL).withArguments(rate)
+        .uponReplyInvoke([weak_self = weak_from_this(), rate, setup = ++setups_, timer = CallTimer::start(site)](
+                const sdbus::Error* err) {
+            timer.finish(err != nullptr);
+            if (auto self = weak_self.lock()) {
+                self->confirm(rate, setup, err == nullptr);
+            }
+        });
+    sent_ = rate;
+}
+
+// (private) the reply to Setup(rate), e.g. rejected if the rate is out of range or the modem doesn't support it
+void SignalRate::confirm(uint32_t rate, uint64_t setup, bool success) {
+    std::lock_guard lock{mutex_};
+    if (success) {
+        applied_ = rate;
+    } else if (setup == setups_) {
+        sent_ = applied_;  // the latest call failed, so that the next apply() retries
+    }
+}
+
+} // namespace ezcellular
@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <cstdint>    // uint32_t, uint64_t
+#include <functional> // std::function
+#include <memory>     // std::shared_ptr, std::enable_shared_from_this
+#include <mutex>      // std::mutex
+#include <optional>   // std::optional
+#include <set>        // std::multiset
+
+#include <sdbus-c++/sdbus-c++.h>  // sdbus::IProxy
+
+#include "subscription.h"  // Subscription
+
+namespace ezcellular {
+
+/**
+ * @brief Arbiter for the refresh rate of the extended signal information of one modem (`.Modem.Signal.Setup()`).
+ *
+ * Every consumer requests an interval, the smallest one is applied.
+ * Once all requests ended, the rate that was set before the first one is restored.
+ * The applied rate is tracked here, so the `Rate` property only has to be read once.
+ *
+ * @note internal helper class, not part of the public API. Only to be used as std::shared_ptr.
+ */
+class SignalRate : public std::enable_shared_from_this<SignalRate> {
+public:
+    /** @brief reads the `Rate` property, only invoked until the rate is known */
+    using RateReader = std::function<uint32_t()>;
+
+    /**
+     * @brief Request an update interval, as long as the returned handle is alive.
+     * @param proxy the modem, kept alive by the handle to restore the rate
+     * @param current_rate see RateReader
+     * @param interval_sec the wanted interval in seconds, 0 for no preference
+     */
+    [[nodiscard]] auto request(const std::shared_ptr<sdbus::IProxy>& proxy, const RateReader& current_rate,
+                               uint32_t interval_sec) -> Subscription;
+
+    /**
+     * @brief Make sure a rate is set at all, e.g. before reading the signal once.
+     *
+     * If no rate is set, the given one is set and kept, also once all requests ended.
+     * @param proxy the modem
+     * @param current_rate see RateReader
+     * @param default_sec the rate to set if none is
+     * @return whether a rate was already set, i.e. whether signal values can be expected
+     */
+    auto ensure(sdbus::IProxy& proxy, const RateReader& current_rate, uint32_t default_sec) -> bool;
+
+    /** @brief the applied rate, empty if not known yet */
+    [[nodiscard]] auto applied() const -> std::optional<uint32_t>;
+
+private:
+    mutable std::mutex mutex_;  // protects the members below
+    std::multiset<uint32_t> requests_;  // the intervals of all active requests
+    std::optional<uint32_t> applied_;   // the rate ModemManager accepted via Setup(), empty until known
+    std::optional<uint32_t> sent_;      // the rate of the last Setup() call, or applied_ if it failed
+    uint64_t setups_ = 0;               // the number of Setup() calls, to recognize the reply of the last one
+    uint32_t baseline_ = 0;             // the rate to restore once all requests ended
+
+    void know(const RateReader& current_rate);  // must hold mutex_
+    void release(sdbus::IProxy& proxy, uint32_t interval_sec);
+    void apply(sdbus::IProxy& proxy, uint32_t rate);  // must hold mutex_
+    void confirm(uint32_t rate, uint64_t setup, bool success);
+};
+
+} // namespace ezcellular
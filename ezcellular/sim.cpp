@@ -3,33 +3,48 @@
     SPDX-License-Identifier: LGPL-3.0-or-later
 */
 #include "sim.h"
+
+#include <exception> // std::make_exception_ptr
+#include <memory>    // std::make_shared
+#include <utility>   // std::move
+
+#include "call_metrics.h"  // ScopedCall, CallTimer
 #include "dbus_constants.h"
+#include "dbus_helpers.h"  // get_property, get_property_async
 #include "exception.h"
 
 namespace ezcellular {
 
-SIM::SIM(const std::weak_ptr<sdbus::IConnection>& conn, const sdbus::ObjectPath& dbus_path)
-    : dbus_proxy_{sdbus::createProxy(*conn.lock(), DBus::MM_BUS_NAME, dbus_path)} {}
+SIM::SIM(std::shared_ptr<sdbus::IProxy> proxy, std::shared_ptr<Identity> identity)
+    : dbus_proxy_{std::move(proxy)}, identity_{identity ? std::move(identity) : std::make_shared<Identity>()} {}
 
 /* methods */
 
+// common helper, translate errors of SendPin and SendPuk
+static auto unlock_error(const sdbus::Error& err, bool with_puk) -> SIMException {
+    if (err.getName() == DBus::MM_ERROR_ME_INCORRECT_PASSWORD) {
+        return SIMException{with_puk ? "Incorrect PUK" : "Incorrect PIN"};
+    }
+    if (err.getName() == DBus::MM_ERROR_ME_INCORRECT_PARAMETERS) {
+        return SIMException{with_puk ? "Invalid PUK or PIN" : "Invalid PIN"};
+    }
+    return SIMException{std::string{with_puk ? "failed to unlock SIM with PUK: " : "failed to unlock SIM with PIN: "}
+                        + err.getMessage()};
+}
+
 void SIM::send_pin(const std::string& pin) {
     try{
         /* dontExpectResult() prevents to throw exceptions
         * therefore, expect a void result (which can be stored in a sdbus::Variant)*/
         sdbus::Variant res;
+        static CallSiteRef site{DBus::MM_IF_SIM, "SendPin"};
+        ScopedCall call{site};
         dbus_proxy_->callMethod("SendPin")
             .onInterface(DBus::MM_IF_SIM).withArguments(pin)
             .storeResultsTo(res);
 
     } catch(sdbus::Error& err) {
-        if (err.getName() == DBus::MM_ERROR_ME_INCORRECT_PASSWORD) {
-            throw SIMException{"Incorrect PIN"};
-        }
-        if (err.getName() == DBus::MM_ERROR_ME_INCORRECT_PARAMETERS) {
-            throw SIMException{"Invalid PIN"};
-        }
-        throw SIMException{std::string{"failed to unlock SIM with PIN: "} + err.getMessage()};
+        throw unlock_error(err, false);
     }
 }
 
@@ -38,41 +53,98 @@ void SIM::send_puk(const std::string& puk, const std::string& pin) {
         /* dontExpectResult() prevents to throw exceptions
         * therefore, expect a void result (which can be stored in a sdbus::Variant)*/
         sdbus::Variant res;
+        static CallSiteRef site{DBus::MM_IF_SIM, "SendPuk"};
+        ScopedCall call{site};
         dbus_proxy_->callMethod("SendPuk")
             .onInterface(DBus::MM_IF_SIM).withArguments(puk, pin)
             .storeResultsTo(res);
 
     } catch(sdbus::Error& err) {
-        if (err.getName() == DBus::MM_ERROR_ME_INCORRECT_PASSWORD) {
-            throw SIMException{"Incorrect PUK"};
-        }
-        if (err.getName() == DBus::MM_ERROR_ME_INCORRECT_PARAMETERS) {
-            throw SIMException{"Invalid PUK or PIN"};
-        }
-        throw SIMException{std::string{"failed to unlock SIM with PUK: "} + err.getMessage()};
+        throw unlock_error(err, true);
     }
 }
 
 /* properties */
 
 auto SIM::active() const -> bool {
-    return dbus_proxy_->getProperty("Active").onInterface(DBus::MM_IF_SIM);
+    return DBus::get_property(*dbus_proxy_, DBus::SIM_ACTIVE);
 }
 
 auto SIM::imsi() const -> std::string {
-    return dbus_proxy_->getProperty("Imsi").onInterface(DBus::MM_IF_SIM);
+    return DBus::fetch_once(identity_->mutex, identity_->imsi, [this]() {
+        return DBus::get_property(*dbus_proxy_, DBus::SIM_IMSI);
+    });
 }
 
 auto SIM::iccid() const -> std::string {
-    return dbus_proxy_->getProperty("SimIdentifier").onInterface(DBus::MM_IF_SIM);
+    return DBus::fetch_once(identity_->mutex, identity_->iccid, [this]() {
+        return DBus::get_property(*dbus_proxy_, DBus::SIM_SIM_IDENTIFIER);
+    });
 }
 
 auto SIM::home_plmn() const -> std::string {
-    return dbus_proxy_->getProperty("OperatorIdentifier").onInterface(DBus::MM_IF_SIM);
+    return DBus::get_property(*dbus_proxy_, DBus::SIM_OPERATOR_IDENTIFIER);
 }
 
 auto SIM::operator_name() const -> std::string {
-    return dbus_proxy_->getProperty("OperatorName").onInterface(DBus::MM_IF_SIM);
+    return DBus::get_property(*dbus_proxy_, DBus::SIM_OPERATOR_NAME);
+}
+
+/* asynchronous variants */
+
+// common helper for send_pin_async, send_puk_async
+static auto unlock_async(sdbus::AsyncMethodInvoker& invoker, bool with_puk) -> std::future<void> {
+    auto promise = std::make_shared<std::promise<void>>();
+    auto future = promise->get_future();
+    static CallSiteRef send_pin{DBus::MM_IF_SIM, "SendPin"};
+    static CallSiteRef send_puk{DBus::MM_IF_SIM, "SendPuk"};
+    auto timer = CallTimer::start(with_puk ? send_puk : send_pin);
+
+    invoker.uponReplyInvoke([promise, with_puk, timer](const sdbus::Error* err) {
+        timer.finish(err != nullptr);
+        if (err != nullptr) {
+            promise->set_exception(std::make_exception_ptr(unlock_error(*err, with_puk)));
+            return;
+        }
+        promise->set_value();
+    });
+
+    return future;
+}
+
+auto SIM::send_pin_async(const std::string& pin) -> std::future<void> {
+    return unlock_async(dbus_proxy_->callMethodAsync("SendPin").onInterface(DBus::MM_IF_SIM).withArguments(pin),
+                        false);
+}
+
+auto SIM::send_puk_async(const std::string& puk, const std::string& pin) -> std::future<void> {
+    return unlock_async(dbus_proxy_->callMethodAsync("SendPuk").onInterface(DBus::MM_IF_SIM)
+                            .withArguments(puk, pin),
+                        true);
+}
+
+auto SIM::active_async() const -> std::future<bool> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::SIM_ACTIVE);
+}
+
+auto SIM::imsi_async() const -> std::future<std::string> {
+    return DBus::fetch_once_async(identity_, identity_->mutex, identity_->imsi, [this](auto remember) {
+        return DBus::get_property_async(*dbus_proxy_, DBus::SIM_IMSI, std::move(remember));
+    });
+}
+
+auto SIM::iccid_async() const -> std::future<std::string> {
+    return DBus::fetch_once_async(identity_, identity_->mutex, identity_->iccid, [this](auto remember) {
+        return DBus::get_property_async(*dbus_proxy_, DBus::SIM_SIM_IDENTIFIER, std::move(remember));
+    });
+}
+
+auto SIM::home_plmn_async() const -> std::future<std::string> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::SIM_OPERATOR_IDENTIFIER);
+}
+
+auto SIM::operator_name_async() const -> std::future<std::string> {
+    return DBus::get_property_async(*dbus_proxy_, DBus::SIM_OPERATOR_NAME);
 }
 
 } // namespace ezcellular
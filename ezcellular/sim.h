@@ -4,7 +4,9 @@
 */
 #pragma once
 
-#include <memory> // std::weak_ptr, std::unique_ptr
+#include <future> // std::future
+#include <memory> // std::shared_ptr
+#include <mutex>  // std::mutex
 #include <string> // std::string
 
 #include <sdbus-c++/sdbus-c++.h>  // sdbus::*
@@ -47,22 +49,55 @@ public:
 
     /** @brief Whether the SIM card is active (primary SIM). */
     [[nodiscard]] auto active() const -> bool;
-    /** @brief The international mobile subscriber identity (IMSI). */
+    /** @brief The international mobile subscriber identity (IMSI), fetched once (see Modem::active_sim()). */
     [[nodiscard]] auto imsi() const -> std::string;
-    /** @brief The integrated circuit card identifier (ICCID). */
+    /** @brief The integrated circuit card identifier (ICCID), fetched once. */
     [[nodiscard]] auto iccid() const -> std::string;
     /** @brief PLMN ID of home network */
     [[nodiscard]] auto home_plmn() const -> std::string;
     /** @brief Name of the network operator that issued the SIM */
     [[nodiscard]] auto operator_name() const -> std::string;
 
+    // ---- asynchronous variants ----
+
+    /**
+     * @name Asynchronous variants
+     *
+     * Non-blocking versions of the methods above, see Modem for details.
+     * @note The SIM object must be kept alive until the future is ready.
+     * @{
+     */
+    /** @brief see send_pin(), failures are reported as SIMException */
+    [[nodiscard]] auto send_pin_async(const std::string& pin) -> std::future<void>;
+    /** @brief see send_puk(), failures are reported as SIMException */
+    [[nodiscard]] auto send_puk_async(const std::string& puk, const std::string& pin) -> std::future<void>;
+    /** @brief see active() */
+    [[nodiscard]] auto active_async() const -> std::future<bool>;
+    /** @brief see imsi() */
+    [[nodiscard]] auto imsi_async() const -> std::future<std::string>;
+    /** @brief see iccid() */
+    [[nodiscard]] auto iccid_async() const -> std::future<std::string>;
+    /** @brief see home_plmn() */
+    [[nodiscard]] auto home_plmn_async() const -> std::future<std::string>;
+    /** @brief see operator_name() */
+    [[nodiscard]] auto operator_name_async() const -> std::future<std::string>;
+    /** @} */
 
 private:
-    std::unique_ptr<sdbus::IProxy> dbus_proxy_;
+    // values that are fixed for the lifetime of the D-Bus object, fetched once; shared by the SIMs of a Modem
+    struct Identity {
+        std::mutex mutex;  // protects the members below
+        std::string imsi;
+        std::string iccid;
+    };
+
+    std::shared_ptr<sdbus::IProxy> dbus_proxy_;  // pooled, see ModemManager
+    std::shared_ptr<Identity> identity_;
 
     // private ctor; supposed to be invoked by class Modem only
     friend class Modem;
-    explicit SIM(const std::weak_ptr<sdbus::IConnection>&, const sdbus::ObjectPath&);
+    friend struct ModemIdentity;
+    SIM(std::shared_ptr<sdbus::IProxy> proxy, std::shared_ptr<Identity> identity);
 };
 
 } // namespace ezcellular
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <array>   // std::array
+#include <atomic>  // std::atomic
+#include <cstddef> // std::size_t
+#include <cstdint> // uint32_t, uint64_t
+#include <memory>  // std::shared_ptr
+#include <thread>  // std::this_thread::yield
+#include <utility> // std::move
+
+namespace ezcellular {
+
+/**
+ * @brief The current version of an immutable value, readers take a reference to it without locking.
+ *
+ * `std::atomic_load()` of a std::shared_ptr takes a lock of a global pool (libstdc++). Instead, the last
+ * versions are kept in a few slots, each with the number of readers copying its std::shared_ptr right now.
+ * A writer only overwrites a slot once no reader is in it, and a reader retries if a new version was published
+ * while it entered its slot. So readers never wait for a lock, and only retry if a writer published in between.
+ *
+ * @tparam T the type of the value
+ * @note internal helper class, not part of the public API
+ */
+template<typename T>
+class SnapshotSlots {
+public:
+    /** @brief initial version */
+    explicit SnapshotSlots(std::shared_ptr<const T> initial) {
+        slots_[0].value = std::move(initial);
+    }
+
+    /** @brief the current version, may be called from any thread */
+    [[nodiscard]] auto load() const -> std::shared_ptr<const T> {
+        for (;;) {
+            // seq_cst: either the writer sees this reader in the slot, or this reader sees the new version
+            auto version = version_.load();
+            auto& slot = slots_[version % SLOTS];
+            slot.readers.fetch_add(1);
+            if (version_.load() == version) {
+                auto value = slot.value;
+                slot.readers.fetch_sub(1, std::memory_order_release);
+                return value;
+            }
+            slot.readers.fetch_sub(1, std::memory_order_release);  // the slot may be overwritten, retry
+        }
+    }
+
+    /** @brief the current version, only for the writer */
+    [[nodiscard]] auto current() const -> const T& {
+        return *slots_[version_.load(std::memory_order_relaxed) % SLOTS].value;
+    }
+
+    /**
+     * @brief Publish a new version.
+     * @note writers must be serialized, waits for readers that are still copying the oldest version
+     */
+    void store(std::shared_ptr<const T> next) {
+        auto version = version_.load(std::memory_order_relaxed);
+        auto& slot = slots_[(version + 1) % SLOTS];
+        while (slot.readers.load() != 0) {
+            std::this_thread::yield();  // a reader of an old version, about to retry
+        }
+        slot.value = std::move(next);  // releases the version that was published SLOTS - 1 versions ago
+        version_.store(version + 1);
+    }
+
+private:
+    static constexpr std::size_t SLOTS = 4;
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> readers{0};
+        std::shared_ptr<const T> value;
+    };
+
+    mutable std::array<Slot, SLOTS> slots_{};
+    std::atomic<uint64_t> version_{0};
+};
+
+} // namespace ezcellular
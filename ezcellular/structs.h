@@ -4,104 +4,93 @@
 */
 #pragma once
 
-#include <cstdint>  // uint32_t and friends
-#include <memory>   // std::unique_ptr, std::shared_ptr
+#include <charconv>    // std::from_chars
+#include <chrono>      // std::chrono
+#include <cstdint>     // uint32_t and friends
+#include <optional>    // std::optional
 #include <string>
+#include <string_view> // std::string_view
 
-#include "any_map.h" // AnyMap, sdbus_variant_map
+#include <ModemManager/ModemManager.h>  // MM_CELL_TYPE_*
+
+#include "any_map.h" // sdbus_variant_map
 #include "enums.h"   // Technology
 
 namespace ezcellular {
 
-/** @brief signal quality base class, cast to subclass depending on the value of tech */
-class SignalBase : public AnyMap {
-public:
-    /// @private ctor without values
-    explicit SignalBase(Technology tech) {
-        insert({"tech", tech});
+/// @private get a value of the given type from dbus_map, if available
+template<typename T>
+auto maybe_get(const sdbus_variant_map& dbus_map, const std::string& key) -> std::optional<T> {
+    if (auto it = dbus_map.find(key); it != dbus_map.end()) {
+        return it->second.get<T>();
     }
+    return {};  // empty optional
+}
 
-    /// the technology for this signal information
-    [[nodiscard]] auto tech() const -> Technology {
-        return get<Technology>("tech");
+/// @private parse a whole string as hex number, without exceptions. Empty if it is not one (or doesn't fit T).
+template<typename T = uint32_t>
+auto parse_hex(std::string_view str) -> std::optional<T> {
+    T value{};
+    const auto* end = str.data() + str.size();
+    auto [ptr, ec] = std::from_chars(str.data(), end, value, 16);
+    if (ec != std::errc{} || ptr != end) {
+        return {};  // not a (complete) hex number, or out of range
     }
-};
-
-using Signal = std::shared_ptr<SignalBase>;
+    return value;
+}
 
-/** @brief LTE signal quality */
-class SignalLTE : public SignalBase {
-public:
-    /** @brief default ctor */
-    SignalLTE() : SignalBase{Technology::LTE} {}
-
-    /// @private factory
-    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::shared_ptr<SignalLTE> {
-        auto lte = std::make_shared<SignalLTE>();
-        lte->maybe_insert_from_variant_map<double>(dbus_map, "rsrp");
-        lte->maybe_insert_from_variant_map<double>(dbus_map, "rsrq");
-        lte->maybe_insert_from_variant_map<double>(dbus_map, "rssi");
-        lte->maybe_insert_from_variant_map_as<double>(dbus_map, "snr", "sinr");
-        return lte;
+/// @private get a hex string value from dbus_map as number, if available (and valid)
+template<typename T = uint32_t>
+auto maybe_get_hex(const sdbus_variant_map& dbus_map, const std::string& key) -> std::optional<T> {
+    if (auto it = dbus_map.find(key); it != dbus_map.end()) {
+        return parse_hex<T>(it->second.get<std::string>());
     }
+    return {};  // empty optional
+}
 
-    /// Reference Signal Received Power (RSRP) in dBm
-    [[nodiscard]] auto rsrp() const -> double { return get<double>("rsrp"); }
-    /// Reference Signal Received Quality (RSRQ) in dB
-    [[nodiscard]] auto rsrq() const -> double { return get<double>("rsrq"); }
-    /// Reference Signal Strength Indication (RSSI) in dBm
-    [[nodiscard]] auto rssi() const -> double { return get<double>("rssi"); }
-    /// Signal to (interference plus) Noise Ratio (SNR) in dB
-    [[nodiscard]] auto sinr() const -> double { return get<double>("sinr"); }
-};
-
-/** @brief NR5G signal quality */
-class SignalNR5G : public SignalBase {
-public:
-    /** @brief default ctor */
-    SignalNR5G() : SignalBase{Technology::NR5G} {}
-
-    /// @private factory
-    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::shared_ptr<SignalNR5G> {
-        auto nr = std::make_shared<SignalNR5G>();
-        nr->maybe_insert_from_variant_map<double>(dbus_map, "rsrp");
-        nr->maybe_insert_from_variant_map<double>(dbus_map, "rsrq");
-        nr->maybe_insert_from_variant_map_as<double>(dbus_map, "snr", "sinr");
-        return nr;
+/**
+ * @brief Signal quality (LTE or NR5G).
+ *
+ * Values that were not reported by the modem are left empty.
+ */
+struct Signal {
+    Technology tech = Technology::UNKNOWN; ///< the technology for this signal information
+    std::optional<double> rsrp;  ///< Reference Signal Received Power (RSRP) in dBm
+    std::optional<double> rsrq;  ///< Reference Signal Received Quality (RSRQ) in dB
+    std::optional<double> rssi;  ///< Reference Signal Strength Indication (RSSI) in dBm, LTE only
+    std::optional<double> sinr;  ///< Signal to (interference plus) Noise Ratio (SNR) in dB
+
+    /// whether no value at all is available
+    [[nodiscard]] auto empty() const -> bool { return !rsrp && !rsrq && !rssi && !sinr; }
+
+    /// @private factory, dbus_map is a ModemManager signal (or cell info) dictionary
+    static auto from_variant_map(Technology tech, const sdbus_variant_map& dbus_map) -> Signal {
+        Signal signal{};
+        signal.tech = tech;
+        signal.rsrp = maybe_get<double>(dbus_map, "rsrp");
+        signal.rsrq = maybe_get<double>(dbus_map, "rsrq");
+        if (tech == Technology::LTE) {
+            signal.rssi = maybe_get<double>(dbus_map, "rssi");
+        }
+        signal.sinr = maybe_get<double>(dbus_map, "snr");
+        return signal;
     }
-
-    /// Reference Signal Received Power (RSRP) in dBm
-    [[nodiscard]] auto rsrp() const -> double { return get<double>("rsrp"); }
-    /// Reference Signal Received Quality (RSRQ) in dB
-    [[nodiscard]] auto rsrq() const -> double { return get<double>("rsrq"); }
-    /// Signal to (interference plus) Noise Ratio (SNR) in dB
-    [[nodiscard]] auto sinr() const -> double { return get<double>("sinr"); }
 };
 
+/**
+ * @brief Identifiers that give information about the location of a LTE or NR5G network cell.
+ *
+ * Values that were not reported by the modem are left empty.
+ */
+struct Location {
+    Technology tech = Technology::UNKNOWN; ///< the technology for this location information
+    std::string mcc;              ///< Mobile Country Code (3 digits), e.g. "262" for germany
+    std::string mnc;              ///< Mobile Network Code (2..3 digits), e.g. "01"
+    std::optional<uint64_t> ci;   ///< CellIdentity, 28 bits for LTE, 36 bits for NR (NCI)
+    std::optional<uint32_t> tac;  ///< Tracking Area Code (LTE/NR). 24 bits.
 
-/** @brief Location base class, cast to subclass depending on the value of tech */
-class LocationBase : public AnyMap {
-protected:
-    /// @private initialize known keys from a sdbus_variant_map
-    void fill_from_variant_map(const sdbus_variant_map& dbus_map) {
-        if (auto it = dbus_map.find("operator-id"); it != dbus_map.end()) {
-            std::string mcc;
-            std::string mnc;
-            plmn_to_mcc_mnc(it->second.get<std::string>(), mcc, mnc);
-            insert({{"mcc", mcc}, {"mnc", mnc}});
-        }
-        if (auto it = dbus_map.find("ci"); it != dbus_map.end()) {
-            auto ci_hex = it->second.get<std::string>();
-            auto ci = static_cast<uint32_t>(std::stoul(ci_hex, nullptr, 16));
-            insert({"ci", ci});
-        }
-    }
-
-public:
-    /// @private ctor
-    explicit LocationBase(Technology tech) {
-        insert({"tech", tech});
-    }
+    /// whether no value at all is available
+    [[nodiscard]] auto empty() const -> bool { return mcc.empty() && mnc.empty() && !ci && !tac; }
 
     /**
      * @brief split a PLMN id into MCC and MNC
@@ -114,195 +103,90 @@ public:
         mnc = plmn.substr(3, std::string::npos);  // until end
     }
 
-    /// the technology for this location information
-    [[nodiscard]] auto tech() const -> Technology { return get<Technology>("tech"); }
-    /// Mobile Country Code (3 digits), e.g. "262" for germany
-    [[nodiscard]] auto mcc() const -> std::string { return get("mcc"); }
-    /// Mobile Network Code (2..3 digits), e.g. "01"
-    [[nodiscard]] auto mnc() const -> std::string { return get("mnc"); }
-    /// CellIdentity
-    [[nodiscard]] auto ci() const -> uint32_t { return get<uint32_t>("ci"); }
-};
-
-using Location = std::shared_ptr<LocationBase>;
-
-/**
- * @brief Identifiers that give information about the location of a LTE network cell
- */
-class LocationLTE : public LocationBase {
-protected:
-    /// @private initialize known keys from a sdbus_variant_map
-    void fill_from_variant_map(const sdbus_variant_map& dbus_map) {
-        // mcc, mnc, ci
-        LocationBase::fill_from_variant_map(dbus_map);
-        // TAC from HEX to uint32_t
-        if (auto it = dbus_map.find("tac"); it != dbus_map.end()) {
-            auto tac_hex = it->second.get<std::string>();
-            auto tac = static_cast<uint32_t>(std::stoul(tac_hex, nullptr, 16));
-            insert({"tac", tac});
+    /// @private factory, dbus_map is a ModemManager cell info dictionary
+    static auto from_variant_map(Technology tech, const sdbus_variant_map& dbus_map) -> Location {
+        Location loc{};
+        loc.tech = tech;
+        if (auto it = dbus_map.find("operator-id"); it != dbus_map.end()) {
+            plmn_to_mcc_mnc(it->second.get<std::string>(), loc.mcc, loc.mnc);
         }
-    }
-
-public:
-    /// @private ctor
-    LocationLTE() : LocationBase{Technology::LTE} {}
-
-    /// @private factory
-    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::shared_ptr<LocationLTE> {
-        auto lte = std::make_shared<LocationLTE>();
-        lte->fill_from_variant_map(dbus_map);
-        return lte;
-    }
-
-    /// Tracking Area Code (LTE/NR). 24 bits.
-    [[nodiscard]] auto tac() const -> uint32_t { return get<uint32_t>("tac"); }
-};
-
-/**
- * @brief Identifiers that give information about the location of a NR/5G network cell
- */
-class LocationNR5G : public LocationLTE {
-public:
-    /// @private ctor, overwrite tech attribute set by LocationLTE ctor
-    LocationNR5G() { at("tech") = Technology::NR5G; }
-
-    /// @private factory
-    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::shared_ptr<LocationNR5G> {
-        auto nr = std::make_shared<LocationNR5G>();
-        nr->fill_from_variant_map(dbus_map);  // uses LTE impl
-        return nr;
+        loc.ci = maybe_get_hex<uint64_t>(dbus_map, "ci");
+        loc.tac = maybe_get_hex(dbus_map, "tac");
+        return loc;
     }
 };
 
 /**
  * @brief Cell information.
- * This class is based on ModemManagers GetCellInfo() return value
+ * This struct is based on ModemManagers GetCellInfo() return value
  * and contains signal, location and frequency information.
  *
- * @warning often not all values are set, use has_key() or get_or_default()
- * @note cast to subclass depending on the value of tech
+ * @warning often not all values are set, e.g. the CellIdentity of neighboring cells
  */
-class CellInfoBase : public AnyMap {
-public:
-    /// @private ctor without values
-    explicit CellInfoBase(Technology tech) {
-        insert({"tech", tech});
-    }
+struct CellInfo {
+    Technology tech = Technology::UNKNOWN; ///< the technology for this cell information
+    bool serving = false;          ///< whether the cell is serving (currently in use) or a neighboring cell
+    std::optional<uint64_t> ci;    ///< CellIdentity (see Location::ci), not available for non-serving cells
+    std::optional<uint16_t> pci;   ///< physical cell id (PCI) (LTE: 0..503, NR5G: 0..1007)
+    std::optional<uint32_t> arfcn; ///< EARFCN (LTE) or NRARFCN (NR5G)
+    Signal signal;                 ///< signal quality
+    Location location;             ///< location info
 
-protected:
-    /// @private called from derived classes
-    void fill_from_variant_map(const sdbus_variant_map& dbus_map) {
-        maybe_insert_from_variant_map<bool>(dbus_map, "serving");
-        if (auto it = dbus_map.find("ci"); it != dbus_map.end()) {
-            auto ci_hex = it->second.get<std::string>();
-            auto ci = static_cast<uint32_t>(std::stoul(ci_hex, nullptr, 16));
-            insert({"ci", ci});
+    /**
+     * @private factory, dbus_map is one entry of the ModemManager GetCellInfo() result
+     * @return the cell info, or an empty optional if the cell type is not supported
+     */
+    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::optional<CellInfo> {
+        CellInfo cell{};
+
+        switch (maybe_get<uint32_t>(dbus_map, "cell-type").value_or(MM_CELL_TYPE_UNKNOWN)) {
+            case MM_CELL_TYPE_LTE:
+                cell.tech = Technology::LTE;
+                cell.arfcn = maybe_get<uint32_t>(dbus_map, "earfcn");
+                break;
+            case MM_CELL_TYPE_5GNR:
+                cell.tech = Technology::NR5G;
+                cell.arfcn = maybe_get<uint32_t>(dbus_map, "nrarfcn");
+                break;
+            default:
+                return {};  // not supported yet
         }
-    }
-
-public:
-    /// @brief the technology for this cell information
-    [[nodiscard]] auto tech() const -> Technology { return get<Technology>("tech"); }
-    /// @brief whether the cell is serving (currently in use) or a neighboring cell
-    [[nodiscard]] auto serving() const -> bool { return get_or_default<bool>("serving", false); }
-    /// @brief CellIdentity, not available for non-serving cells
-    [[nodiscard]] auto ci() const -> uint32_t { return get<uint32_t>("ci"); }
-};
-
-using CellInfo = std::shared_ptr<CellInfoBase>;  // always provided as a pointer for casting
-
-/**
- * @brief LTE cell information
- * @see CellInfoBase
-*/
-class CellInfoLTE : public CellInfoBase {
-public:
-    /// @private ctor
-    CellInfoLTE() : CellInfoBase{Technology::LTE} {}
-
-    /// @private factory
-    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::shared_ptr<CellInfoBase> {
-        auto lte = std::make_shared<CellInfoLTE>();
 
-        // extract "serving" and "ci"
-        lte->fill_from_variant_map(dbus_map);
-        // earfcn, pci
-        lte->maybe_insert_from_variant_map<uint32_t>(dbus_map, "earfcn");
-        if (auto it = dbus_map.find("physical-ci"); it != dbus_map.end()) {
-            auto pci_hex = it->second.get<std::string>();
-            auto pci = static_cast<uint16_t>(std::stoul(pci_hex, nullptr, 16));
-            lte->insert({"pci", pci});
+        cell.serving = maybe_get<bool>(dbus_map, "serving").value_or(false);
+        cell.ci = maybe_get_hex<uint64_t>(dbus_map, "ci");
+        if (auto pci = maybe_get_hex(dbus_map, "physical-ci")) {
+            cell.pci = static_cast<uint16_t>(*pci);
         }
-        // signal quality
-        auto signal = SignalLTE::from_variant_map(dbus_map);
-        lte->insert({"signal", signal});
-        // location
-        auto location = LocationLTE::from_variant_map(dbus_map);
-        lte->insert({"location", location});
-
-        return lte;
+        cell.signal = Signal::from_variant_map(cell.tech, dbus_map);
+        cell.location = Location::from_variant_map(cell.tech, dbus_map);
+        return cell;
     }
-
-    /// LTE EARFCN
-    [[nodiscard]] auto earfcn() const -> uint32_t { return get<uint32_t>("earfcn"); }
-    /// LTE physical cell id (PCI) (0..503)
-    [[nodiscard]] auto pci() const -> uint16_t { return get<uint16_t>("pci"); }
-    /// LTE signal quality
-    [[nodiscard]] auto signal() const -> std::shared_ptr<SignalLTE> {
-        return get<std::shared_ptr<SignalLTE>>("signal");
-    }
-    /// LTE location info
-    [[nodiscard]] auto location() const -> std::shared_ptr<LocationLTE> {
-        return get_or_default<std::shared_ptr<LocationLTE>>("location", {nullptr});
-    }
-
 };
 
 /**
- * @brief 5G/NR cell information
- * @see CellInfoBase
-*/
-class CellInfoNR5G : public CellInfoBase {
-public:
-    /// @private ctor
-    CellInfoNR5G() : CellInfoBase{Technology::NR5G} {}
-
-    /// @private factory
-    static auto from_variant_map(const sdbus_variant_map& dbus_map) -> std::shared_ptr<CellInfoBase> {
-        auto nr = std::make_shared<CellInfoNR5G>();
-
-        // extract "serving" and "ci"
-        nr->fill_from_variant_map(dbus_map);
-        // nrarfcn, pci
-        nr->maybe_insert_from_variant_map<uint32_t>(dbus_map, "nrarfcn");
-        if (auto it = dbus_map.find("physical-ci"); it != dbus_map.end()) {
-            auto pci_hex = it->second.get<std::string>();
-            auto pci = static_cast<uint16_t>(std::stoul(pci_hex, nullptr, 16));
-            nr->insert({"pci", pci});
-        }
-        // signal quality
-        auto signal = SignalNR5G::from_variant_map(dbus_map);
-        nr->insert({"signal", signal});
-
-        // location
-        auto location = LocationNR5G::from_variant_map(dbus_map);
-        nr->insert({"location", location});
-
-        return nr;
-    }
+ * @name Deprecated per-technology types
+ * The former classes per technology are merged into Signal, Location and CellInfo, which are values now
+ * (not `std::shared_ptr`). Check their `tech` member instead of casting, values are `std::optional` members
+ * instead of getters. See the README for the migration.
+ * @{
+ */
+using SignalBase [[deprecated("use Signal")]] = Signal;           ///< @deprecated use Signal
+using SignalLTE [[deprecated("use Signal")]] = Signal;            ///< @deprecated use Signal
+using SignalNR5G [[deprecated("use Signal")]] = Signal;           ///< @deprecated use Signal
+using LocationBase [[deprecated("use Location")]] = Location;     ///< @deprecated use Location
+using LocationLTE [[deprecated("use Location")]] = Location;      ///< @deprecated use Location
+using LocationNR5G [[deprecated("use Location")]] = Location;     ///< @deprecated use Location
+using CellInfoBase [[deprecated("use CellInfo")]] = CellInfo;     ///< @deprecated use CellInfo
+using CellInfoLTE [[deprecated("use CellInfo")]] = CellInfo;      ///< @deprecated use CellInfo
+using CellInfoNR5G [[deprecated("use CellInfo")]] = CellInfo;     ///< @deprecated use CellInfo
+/** @} */
 
-    /// NR5G NRARFCN
-    [[nodiscard]] auto nrarfcn() const -> uint32_t { return get<uint32_t>("nrarfcn"); }
-    /// NR5G physical cell id (PCI) (0..1007)
-    [[nodiscard]] auto pci() const -> uint16_t { return get<uint16_t>("pci"); }
-    /// NR5G signal quality
-    [[nodiscard]] auto signal() const -> std::shared_ptr<SignalNR5G> {
-        return get<std::shared_ptr<SignalNR5G>>("signal");
-    }
-    /// NR5G location info
-    [[nodiscard]] auto location() const -> std::shared_ptr<LocationNR5G> {
-        return get_or_default<std::shared_ptr<LocationNR5G>>("location", {nullptr});
-    }
+/**
+ * @brief Bearer settings of a Connection.
+ */
+struct BearerSettings {
+    std::string apn; ///< the configured APN/PDN
+    IPType ip_type;  ///< the configured APN/PDN IP type
 };
 
 /**
@@ -325,5 +209,21 @@ struct TrafficStats {
     uint64_t tx_bytes; ///< Transmitted (TX) bytes
 };
 
+/**
+ * @brief Data rate derived from two consecutive TrafficStats.
+ */
+struct TrafficRate {
+    double rx_bytes_per_sec; ///< Received (RX) bytes per second
+    double tx_bytes_per_sec; ///< Transmitted (TX) bytes per second
+};
+
+/**
+ * @brief Time reported by the network, see Modem::observe_network_time().
+ */
+struct NetworkTime {
+    std::chrono::system_clock::time_point utc;       ///< the time in UTC
+    std::optional<std::chrono::minutes> utc_offset;  ///< offset of the local time of the network, if reported
+    std::chrono::steady_clock::time_point received;  ///< when the time was received
+};
 
 } // namespace ezcellular
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <functional> // std::function
+#include <utility>    // std::move, std::exchange
+
+namespace ezcellular {
+
+/**
+ * @brief Handle of a registered observer. The observer is unregistered when the handle is destroyed or reset.
+ *
+ * Returned by the `observe_*()` methods of Modem and Connection. Keep it alive as long as updates are wanted.
+ *
+ * @note Updates already queued on an Executor (see ModemManager::set_executor()) may still be delivered
+ *       after the handle was reset.
+ */
+class Subscription {
+public:
+    /** @brief empty handle, not observing anything */
+    Subscription() = default;
+    /// @private invoked by the library, cancel unregisters the observer
+    explicit Subscription(std::function<void()> cancel) : cancel_{std::move(cancel)} {}
+
+    /** @brief unregisters the observer */
+    ~Subscription() { reset(); }
+
+    /** @brief Copy constructor (deleted, a handle is unique) */
+    Subscription(const Subscription&) = delete;
+    /** @brief Copy assignment operator (deleted, a handle is unique) */
+    Subscription& operator=(const Subscription&) = delete; // NOLINT(*-trailing-return-type)
+    /** @brief Move constructor */
+    Subscription(Subscription&& other) noexcept : cancel_{std::exchange(other.cancel_, nullptr)} {}
+    /** @brief Move assignment operator, unregisters the observer of this handle first */
+    Subscription& operator=(Subscription&& other) noexcept { // NOLINT(*-trailing-return-type)
+        if (this != &other) {
+            reset();
+            cancel_ = std::exchange(other.cancel_, nullptr);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Unregister the observer now.
+     *
+     * If the observer is running on another thread, this waits until it returned.
+     * Once reset() returned, the observer won't be invoked from the D-Bus thread anymore.
+     * @warning Don't reset the handle of a Connection observer from within the observer itself,
+     *          unless it runs on an Executor: this would destroy the D-Bus proxy that is delivering the update.
+     */
+    void reset() {
+        if (auto cancel = std::exchange(cancel_, nullptr)) {
+            cancel();
+        }
+    }
+
+    /** @brief whether an observer is registered */
+    explicit operator bool() const { return static_cast<bool>(cancel_); }
+
+private:
+    std::function<void()> cancel_;
+};
+
+} // namespace ezcellular
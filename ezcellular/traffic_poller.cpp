@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "traffic_poller.h"
+
+#include <algorithm> // std::any_of, std::max
+#include <iterator>  // std::next
+#include <utility>   // std::move, std::pair
+#include <vector>    // std::vector
+
+#include "traffic_source.h" // TrafficStatsSource
+
+namespace ezcellular {
+
+auto TrafficPoller::shared(const std::shared_ptr<TrafficStatsSource>& source, std::chrono::milliseconds interval)
+    -> std::shared_ptr<TrafficPoller> {
+    using Key = std::pair<const TrafficStatsSource*, std::chrono::milliseconds::rep>;
+    static std::mutex mutex;  // protects pollers
+    static std::map<Key, std::weak_ptr<TrafficPoller>> pollers;
+
+    std::lock_guard lock{mutex};
+    for (auto it = pollers.begin(); it != pollers.end();) {
+        it = it->second.expired() ? pollers.erase(it) : std::next(it);
+    }
+    auto& entry = pollers[Key{source.get(), interval.count()}];
+    auto poller = entry.lock();
+    if (!poller) {
+        poller = std::make_shared<TrafficPoller>(source, interval);
+        entry = poller;
+    }
+    return poller;
+}
+
+TrafficPoller::TrafficPoller(std::shared_ptr<TrafficStatsSource> source, std::chrono::milliseconds interval)
+    : state_{std::make_shared<State>()} {
+    state_->source = std::move(source);
+    state_->interval = interval;
+    thread_ = std::thread{&TrafficPoller::run, state_};
+}
+
+TrafficPoller::~TrafficPoller() {
+    {
+        std::lock_guard lock{state_->mutex};
+        state_->stop = true;
+    }
+    state_->cv.notify_all();
+
+    if (thread_.get_id() == std::this_thread::get_id()) {
+        thread_.detach();  // destroyed from within a callback, the loop ends after it returns
+    } else {
+        thread_.join();
+    }
+}
+
+auto TrafficPoller::add(std::string iface, Callback callback) -> uint64_t {
+    uint64_t id{};
+    {
+        std::lock_guard lock{state_->mutex};
+        id = state_->next_id++;
+        state_->subscribers.emplace(id, Subscriber{std::move(iface), std::move(callback)});
+    }
+    state_->cv.notify_all();  // sample it right away
+    return id;
+}
+
+void TrafficPoller::remove(uint64_t id) {
+    std::unique_lock lock{state_->mutex};
+    state_->subscribers.erase(id);
+    if (thread_.get_id() != std::this_thread::get_id()) {
+        state_->cv.wait(lock, [&]() { return state_->running != id; });
+    }
+}
+
+void TrafficPoller::run(const std::shared_ptr<State>& state) {
+    // fixed rate, so that the samples don't drift. If the callbacks took too long, continue from now on.
+    auto next = std::chrono::steady_clock::now();
+    auto has_fresh = [&state]() {
+        return std::any_of(state->subscribers.begin(), state->subscribers.end(),
+                           [](const auto& entry) { return entry.second.fresh; });
+    };
+
+    std::unique_lock lock{state->mutex};
+    while (!state->stop) {
+        // all subscribers on a tick, otherwise only the new ones
+        auto now = std::chrono::steady_clock::now();
+        bool tick = now >= next;
+        std::vector<uint64_t> ids;
+        std::vector<std::string> ifaces;
+        for (auto& [id, subscriber] : state->subscribers) {
+            if (tick || subscriber.fresh) {
+                subscriber.fresh = false;
+                ids.push_back(id);
+                ifaces.push_back(subscriber.iface);
+            }
+        }
+        lock.unlock();
+
+        // one read for all interfaces, e.g. a single netlink dump
+        auto stats = ifaces.empty() ? std::map<std::string, TrafficStats>{} : state->source->read_many(ifaces);
+
+        lock.lock();
+        for (auto id : ids) {
+            auto it = state->subscribers.find(id);
+            if (it == state->subscribers.end()) {
+                continue;  // removed in the meantime
+            }
+            auto found = stats.find(it->second.iface);
+            if (found == stats.end()) {
+                continue;
+            }
+            auto callback = it->second.callback;  // copy, the subscriber may be removed while it runs
+            state->running = id;
+            lock.unlock();
+            callback(found->second, now);
+            lock.lock();
+            state->running = 0;
+            state->cv.notify_all();
+        }
+
+        if (tick) {
+            next = std::max(next + state->interval, std::chrono::steady_clock::now());
+        }
+        state->cv.wait_until(lock, next, [&]() { return state->stop || has_fresh(); });
+    }
+}
+
+} // namespace ezcellular
@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <chrono>             // std::chrono::milliseconds, std::chrono::steady_clock
+#include <condition_variable> // std::condition_variable
+#include <cstdint>            // uint64_t
+#include <functional>         // std::function
+#include <map>                // std::map
+#include <memory>             // std::shared_ptr
+#include <mutex>              // std::mutex
+#include <string>             // std::string
+#include <thread>             // std::thread
+
+#include "structs.h"  // TrafficStats
+
+namespace ezcellular {
+
+class TrafficStatsSource; // IWYU pragma: keep
+
+/**
+ * @brief Samples a TrafficStatsSource periodically on its own thread, for sources without change notifications.
+ *
+ * One poller per source and interval is shared by all its subscribers (see shared()): each tick reads the
+ * interfaces of all subscribers at once (see TrafficStatsSource::read_many()) and passes the counters on.
+ *
+ * @note internal helper class, not part of the public API
+ */
+class TrafficPoller {
+public:
+    /** @brief called with the counters and the time they were read */
+    using Callback = std::function<void(const TrafficStats&, std::chrono::steady_clock::time_point)>;
+
+    /** @brief The poller of source with this interval, started on first use and stopped with its last user. */
+    static auto shared(const std::shared_ptr<TrafficStatsSource>& source, std::chrono::milliseconds interval)
+        -> std::shared_ptr<TrafficPoller>;
+
+    /**
+     * @brief Start polling, only samples once there are subscribers.
+     * @param source the source to read from
+     * @param interval time between two samples
+     */
+    TrafficPoller(std::shared_ptr<TrafficStatsSource> source, std::chrono::milliseconds interval);
+    /** @brief Stop polling, waits for running callbacks unless called from one. */
+    ~TrafficPoller();
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    TrafficPoller(const TrafficPoller&) = delete;
+    TrafficPoller& operator=(const TrafficPoller&) = delete;
+    TrafficPoller(TrafficPoller&&) = delete;
+    TrafficPoller& operator=(TrafficPoller&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /**
+     * @brief Sample an interface with every tick, the first sample is taken right away.
+     * @param iface the linux interface to read the counters of
+     * @param callback see Callback, not called if the source returned nothing for iface
+     * @return the id to pass to remove()
+     */
+    auto add(std::string iface, Callback callback) -> uint64_t;
+    /** @brief Stop calling the callback of id, waits for it if it is running, unless called from it. */
+    void remove(uint64_t id);
+
+private:
+    struct Subscriber {
+        std::string iface;
+        Callback callback;
+        bool fresh = true;  // not sampled yet
+    };
+    // shared with the thread, which may outlive the poller if it was destroyed from within a callback
+    struct State {
+        std::shared_ptr<TrafficStatsSource> source;
+        std::chrono::milliseconds interval;
+
+        std::mutex mutex;  // protects the members below
+        std::condition_variable cv;  // signals new subscribers, stop and the end of a callback
+        std::map<uint64_t, Subscriber> subscribers;
+        uint64_t next_id = 1;
+        uint64_t running = 0;  // the id whose callback is running, 0 if none
+        bool stop = false;
+    };
+    std::shared_ptr<State> state_;
+    std::thread thread_;
+
+    static void run(const std::shared_ptr<State>& state);
+};
+
+} // namespace ezcellular
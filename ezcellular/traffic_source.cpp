@@ -0,0 +1,222 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#include "traffic_source.h"
+
+#include <array>    // std::array
+#include <cerrno>   // EOPNOTSUPP, EINVAL, ENODEV
+#include <cstdint>  // uint64_t
+#include <cstring>  // std::memcpy
+#include <fstream>  // std::ifstream
+
+#include <linux/if_link.h>    // struct if_stats_msg, rtnl_link_stats64
+#include <linux/netlink.h>    // struct nlmsghdr, NLM_F_*
+#include <linux/rtnetlink.h>  // RTM_GETSTATS
+#include <net/if.h>           // if_nametoindex, if_indextoname
+#include <sys/socket.h>       // socket, send, recv, setsockopt
+#include <sys/time.h>         // struct timeval
+#include <unistd.h>           // close
+
+namespace ezcellular {
+
+auto TrafficStatsSource::read_many(const std::vector<std::string>& ifaces) -> std::map<std::string, TrafficStats> {
+    std::map<std::string, TrafficStats> all;
+    for (const auto& iface : ifaces) {
+        if (auto stats = read(iface)) {
+            all.emplace(iface, *stats);
+        }
+    }
+    return all;
+}
+
+KernelTrafficStatsSource::~KernelTrafficStatsSource() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+// the kernel answers right away, don't stall the polling thread forever if it doesn't
+static constexpr timeval REPLY_TIMEOUT{1, 0};
+
+// (private) send an RTM_GETSTATS request, for all interfaces if ifindex is 0, and pass each reply to on_stats
+// returns 0 if it was answered completely, otherwise an errno value, e.g. ENODEV if there is no such interface
+template<typename OnStats>
+auto KernelTrafficStatsSource::request(unsigned int ifindex, OnStats&& on_stats) -> int {
+    if (netlink_failed_) {
+        return EOPNOTSUPP;
+    }
+    if (fd_ < 0) {
+        fd_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (fd_ < 0) {
+            netlink_failed_ = true;
+            return EOPNOTSUPP;
+        }
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &REPLY_TIMEOUT, sizeof(REPLY_TIMEOUT));
+    }
+
+    struct {
+        nlmsghdr header;
+        if_stats_msg stats;
+    } req{};
+    req.header.nlmsg_len = sizeof(req);
+    req.header.nlmsg_type = RTM_GETSTATS;
+    req.header.nlmsg_flags = NLM_F_REQUEST | (ifindex == 0 ? NLM_F_DUMP : 0);
+    req.header.nlmsg_seq = ++seq_;
+    req.stats.family = AF_UNSPEC;
+    req.stats.ifindex = ifindex;
+    req.stats.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    if (::send(fd_, &req, sizeof(req), 0) < 0) {
+        return errno;
+    }
+
+    // a single reply, or a multipart dump terminated by NLMSG_DONE
+    alignas(nlmsghdr) std::array<char, 16384> buffer{};
+    for (;;) {
+        auto len = ::recv(fd_, buffer.data(), buffer.size(), 0);
+        if (len < 0) {
+            return errno;  // EAGAIN: timed out, a late reply is skipped by its sequence number
+        }
+        auto remaining = static_cast<int>(len);
+        for (auto* msg = reinterpret_cast<nlmsghdr*>(buffer.data()); NLMSG_OK(msg, remaining);  // NOLINT
+             msg = NLMSG_NEXT(msg, remaining)) {
+            if (msg->nlmsg_seq != seq_) {
+                continue;  // reply to an earlier, abandoned request
+            }
+            if (msg->nlmsg_type == NLMSG_DONE) {
+                return 0;
+            }
+            if (msg->nlmsg_type == NLMSG_ERROR) {
+                auto* err = static_cast<nlmsgerr*>(NLMSG_DATA(msg));
+                if (err->error == 0) {
+                    return 0;  // an acknowledgement
+                }
+                if (err->error == -EOPNOTSUPP || err->error == -EINVAL) {
+                    netlink_failed_ = true;  // kernel too old
+                }
+                return -err->error;
+            }
+            if (msg->nlmsg_type != RTM_NEWSTATS) {
+                continue;
+            }
+
+            auto* ifsm = static_cast<if_stats_msg*>(NLMSG_DATA(msg));
+            auto attr_len = static_cast<int>(msg->nlmsg_len - NLMSG_LENGTH(sizeof(*ifsm)));
+            auto* attr = reinterpret_cast<rtattr*>(reinterpret_cast<char*>(ifsm)  // NOLINT
+                                                   + NLMSG_ALIGN(sizeof(*ifsm)));
+            for (; RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                if (attr->rta_type == IFLA_STATS_LINK_64 && RTA_PAYLOAD(attr) >= sizeof(rtnl_link_stats64)) {
+                    rtnl_link_stats64 link{};
+                    std::memcpy(&link, RTA_DATA(attr), sizeof(link));  // payload might not be aligned for u64
+                    on_stats(ifsm->ifindex, TrafficStats{link.rx_bytes, link.tx_bytes});
+                }
+            }
+            if ((msg->nlmsg_flags & NLM_F_MULTI) == 0) {
+                return 0;  // single reply
+            }
+        }
+    }
+}
+
+// common helper for read: one counter from sysfs
+static auto read_sysfs_counter(const std::string& iface, const char* name) -> std::optional<uint64_t> {
+    std::ifstream file{"/sys/class/net/" + iface + "/statistics/" + name};
+    uint64_t value{};
+    if (!(file >> value)) {
+        return {};
+    }
+    return value;
+}
+
+// (private) the index of an interface, resolved once (if_nametoindex needs a socket and an ioctl), 0 if unknown
+auto KernelTrafficStatsSource::ifindex(const std::string& iface) -> unsigned int {
+    if (auto it = ifindex_.find(iface); it != ifindex_.end()) {
+        return it->second;
+    }
+    auto index = ::if_nametoindex(iface.c_str());
+    if (index != 0) {
+        ifindex_.emplace(iface, index);
+    }
+    return index;
+}
+
+auto KernelTrafficStatsSource::read(const std::string& iface) -> std::optional<TrafficStats> {
+    {
+        std::lock_guard lock{mutex_};
+        auto index = ifindex(iface);
+        if (index == 0) {
+            return {};  // no such interface
+        }
+        std::optional<TrafficStats> stats;
+        auto error = request(index, [&](unsigned int, const TrafficStats& link) { stats = link; });
+        if (error == 0 && stats) {
+            return stats;
+        }
+        if (error == ENODEV) {
+            ifindex_.erase(iface);  // e.g. the interface was recreated with another index, resolve it again next time
+        }
+    }
+
+    // fallback
+    auto rx_bytes = read_sysfs_counter(iface, "rx_bytes");
+    auto tx_bytes = read_sysfs_counter(iface, "tx_bytes");
+    if (!rx_bytes || !tx_bytes) {
+        return {};
+    }
+    return TrafficStats{*rx_bytes, *tx_bytes};
+}
+
+auto KernelTrafficStatsSource::read_many(const std::vector<std::string>& ifaces)
+    -> std::map<std::string, TrafficStats> {
+    std::map<std::string, TrafficStats> all;
+    {
+        std::lock_guard lock{mutex_};
+        std::map<unsigned int, const std::string*> by_index;
+        for (const auto& iface : ifaces) {
+            if (auto index = ifindex(iface); index != 0) {
+                by_index.emplace(index, &iface);
+            }
+        }
+        bool complete = !by_index.empty() && request(0, [&](unsigned int index, const TrafficStats& link) {
+            if (auto it = by_index.find(index); it != by_index.end()) {
+                all.emplace(*it->second, link);
+            }
+        }) == 0;
+        if (!complete) {
+            all.clear();
+        }
+    }
+
+    // the rest one by one, e.g. from sysfs without netlink, or re-resolved
+    for (const auto& iface : ifaces) {
+        if (all.count(iface) == 0) {
+            if (auto stats = read(iface)) {
+                all.emplace(iface, *stats);
+            }
+        }
+    }
+    return all;
+}
+
+auto KernelTrafficStatsSource::read_all(const std::string& prefix) -> std::map<std::string, TrafficStats> {
+    std::map<std::string, TrafficStats> all;
+    std::array<char, IF_NAMESIZE> name{};
+
+    std::lock_guard lock{mutex_};
+    bool complete = request(0, [&](unsigned int ifindex, const TrafficStats& link) {
+        if (::if_indextoname(ifindex, name.data()) == nullptr) {
+            return;  // vanished in the meantime
+        }
+        std::string iface{name.data()};
+        if (iface.compare(0, prefix.size(), prefix) == 0) {
+            all.emplace(std::move(iface), link);
+        }
+    }) == 0;
+    if (!complete) {
+        all.clear();
+    }
+    return all;
+}
+
+} // namespace ezcellular
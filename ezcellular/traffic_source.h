@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2023 Oliver Kästner <git@oliver-kaestner.de>
+    SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+#pragma once
+
+#include <map>      // std::map
+#include <mutex>    // std::mutex
+#include <optional> // std::optional
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include "structs.h"  // TrafficStats
+
+namespace ezcellular {
+
+/**
+ * @brief Reads the traffic counters of a linux network interface, see Connection::set_traffic_stats_source().
+ *
+ * Implement this interface to take the counters from elsewhere, e.g. a monitoring agent.
+ */
+class TrafficStatsSource {
+public:
+    virtual ~TrafficStatsSource() = default;
+
+    /**
+     * @brief Read the counters of the interface.
+     * @param iface the linux interface, e.g. `wwan0`
+     * @return the counters, or an empty optional if they are not available here
+     * @note called on the caller's, the D-Bus event loop or a polling thread, so it should not block
+     */
+    virtual auto read(const std::string& iface) -> std::optional<TrafficStats> = 0;
+    /**
+     * @brief Read the counters of several interfaces, e.g. for all observers of a polling interval at once.
+     *
+     * Calls read() for each interface by default, override it if the source can read them in one go.
+     * @param ifaces the linux interfaces
+     * @return the counters by interface, without the interfaces that have none here
+     */
+    virtual auto read_many(const std::vector<std::string>& ifaces) -> std::map<std::string, TrafficStats>;
+};
+
+/**
+ * @brief Reads the counters from the kernel, without NetworkManager.
+ *
+ * Uses an rtnetlink `RTM_GETSTATS` request (64 bit counters, Linux >= 4.7),
+ * and `/sys/class/net/<iface>/statistics` if netlink is not available.
+ */
+class KernelTrafficStatsSource final : public TrafficStatsSource {
+public:
+    KernelTrafficStatsSource() = default;
+    /** @brief Close the netlink socket. */
+    ~KernelTrafficStatsSource() override;
+
+    // NOLINTBEGIN(*-trailing-return-type)
+    KernelTrafficStatsSource(const KernelTrafficStatsSource&) = delete;
+    KernelTrafficStatsSource& operator=(const KernelTrafficStatsSource&) = delete;
+    KernelTrafficStatsSource(KernelTrafficStatsSource&&) = delete;
+    KernelTrafficStatsSource& operator=(KernelTrafficStatsSource&&) = delete;
+    // NOLINTEND(*-trailing-return-type)
+
+    /** @brief see TrafficStatsSource::read() */
+    auto read(const std::string& iface) -> std::optional<TrafficStats> override;
+    /** @brief see TrafficStatsSource::read_many(), a single netlink dump for all of them */
+    auto read_many(const std::vector<std::string>& ifaces) -> std::map<std::string, TrafficStats> override;
+
+    /**
+     * @brief Read the counters of all interfaces whose name starts with prefix, with a single netlink dump.
+     * @param prefix e.g. `wwan`, empty for all interfaces
+     * @return the counters by interface name, empty if netlink is not available
+     */
+    auto read_all(const std::string& prefix = "wwan") -> std::map<std::string, TrafficStats>;
+
+private:
+    std::mutex mutex_;  // one request at a time on the socket, protects the members below
+    int fd_ = -1;       // netlink socket, opened on first use
+    bool netlink_failed_ = false;  // socket could not be opened, or RTM_GETSTATS is not supported
+    unsigned int seq_ = 0;         // sequence number of the last request
+    std::map<std::string, unsigned int> ifindex_;  // resolved interfaces, dropped once the kernel doesn't know one
+
+    template<typename OnStats>
+    auto request(unsigned int ifindex, OnStats&& on_stats) -> int;  // must hold mutex_, 0 or an errno value
+    auto ifindex(const std::string& iface) -> unsigned int;  // must hold mutex_
+};
+
+} // namespace ezcellular